@@ -0,0 +1,498 @@
+#include "asset_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASSET_FILE_URING 1
+#include <atomic>
+#include <cerrno>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+    auto failed(const std::string& path) -> std::runtime_error
+    {
+        return std::runtime_error("Failed to read " + path + ".");
+    }
+
+#if !defined(_WIN32)
+    struct Descriptor
+    {
+        explicit Descriptor(const std::string& path):
+            fd(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+        {
+            if (fd < 0) throw failed(path);
+        }
+        Descriptor(const Descriptor&) = delete;
+        ~Descriptor()
+        {
+            ::close(fd);
+        }
+
+        auto operator=(const Descriptor&) -> Descriptor& = delete;
+
+        auto size() const -> size_t
+        {
+            struct stat status;
+
+            if (fstat(fd, &status) != 0) return 0;
+
+            return static_cast<size_t>(status.st_size);
+        }
+
+        int fd;
+    };
+#endif
+
+#if defined(ASSET_FILE_URING)
+    // Just enough of io_uring for batched reads, straight on the system calls so there is no liburing dependency.
+    struct Uring
+    {
+        // Largest single read, the length field of a submission is 32-bit.
+        static constexpr size_t CHUNK = size_t(1) << 30;
+
+        explicit Uring(unsigned entries)
+        {
+            io_uring_params params = {};
+
+            descriptor = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+
+            // Kernels without io_uring, or with it disabled by policy or seccomp.
+            if (descriptor < 0) return;
+
+            // IORING_OP_READ came with 5.6, before that every read completes with -EINVAL.
+            if (!supports(IORING_OP_READ))
+            {
+                ::close(descriptor);
+                descriptor = -1;
+
+                return;
+            }
+
+            sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+            const auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+            if (single) sq_size = cq_size = std::max(sq_size, cq_size);
+
+            sq_ring = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQ_RING);
+            cq_ring = single ? sq_ring : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_CQ_RING);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, IORING_OFF_SQES));
+
+            if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+            {
+                unmap();
+                ::close(descriptor);
+                descriptor = -1;
+
+                return;
+            }
+
+            const auto sq = static_cast<std::uint8_t*>(sq_ring);
+            const auto cq = static_cast<std::uint8_t*>(cq_ring);
+
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            capacity = params.sq_entries;
+        }
+        Uring(const Uring&) = delete;
+        ~Uring()
+        {
+            if (descriptor < 0) return;
+
+            unmap();
+            ::close(descriptor);
+        }
+
+        auto operator=(const Uring&) -> Uring& = delete;
+
+        auto available() const -> bool
+        {
+            return descriptor >= 0;
+        }
+
+        // The caller keeps at most `capacity` reads in flight, so the submission queue never overflows.
+        auto read(int fd, std::uint8_t* destination, size_t size, size_t offset, std::uint64_t user_data) -> void
+        {
+            const auto tail = *sq_tail;
+            const auto index = tail & sq_mask;
+            auto& sqe = sqes[index];
+
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<std::uint64_t>(destination);
+            sqe.len = static_cast<unsigned>(std::min(size, CHUNK));
+            sqe.off = offset;
+            sqe.user_data = user_data;
+            sq_array[index] = index;
+
+            std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+
+            ++queued;
+        }
+
+        // Submits the queued reads and blocks until at least one of them completed.
+        auto submit_and_wait() -> void
+        {
+            for (;;)
+            {
+                const auto submitted = syscall(__NR_io_uring_enter, descriptor, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+                if (submitted >= 0)
+                {
+                    queued -= static_cast<unsigned>(submitted);
+
+                    return;
+                }
+
+                if (errno != EINTR) throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno) + ".");
+            }
+        }
+
+        template <typename Callback>
+        auto complete(Callback&& callback) -> void
+        {
+            auto head = *cq_head;
+            const auto tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+
+            for (; head != tail; ++head)
+            {
+                const auto& cqe = cqes[head & cq_mask];
+
+                callback(cqe.user_data, cqe.res);
+            }
+
+            std::atomic_ref(*cq_head).store(head, std::memory_order_release);
+        }
+
+        unsigned capacity = 0;
+
+    private:
+        // Kernels before 5.6 have no probe either, the register call fails and the opcode counts as missing.
+        auto supports(unsigned opcode) const -> bool
+        {
+            constexpr unsigned OPCODES = 256;
+
+            std::vector<std::uint8_t> storage(sizeof(io_uring_probe) + OPCODES * sizeof(io_uring_probe_op));
+
+            const auto probe = reinterpret_cast<io_uring_probe*>(storage.data());
+
+            if (syscall(__NR_io_uring_register, descriptor, IORING_REGISTER_PROBE, probe, OPCODES) < 0) return false;
+
+            return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+        }
+
+        auto unmap() -> void
+        {
+            if (sqes != MAP_FAILED && sqes) munmap(sqes, sqes_size);
+            if (cq_ring != MAP_FAILED && cq_ring && cq_ring != sq_ring) munmap(cq_ring, cq_size);
+            if (sq_ring != MAP_FAILED && sq_ring) munmap(sq_ring, sq_size);
+        }
+
+        int           descriptor = -1;
+        void*         sq_ring    = nullptr;
+        void*         cq_ring    = nullptr;
+        io_uring_sqe* sqes       = nullptr;
+        io_uring_cqe* cqes       = nullptr;
+        size_t        sq_size    = 0;
+        size_t        cq_size    = 0;
+        size_t        sqes_size  = 0;
+        unsigned*     sq_tail    = nullptr;
+        unsigned*     sq_array   = nullptr;
+        unsigned*     cq_head    = nullptr;
+        unsigned*     cq_tail    = nullptr;
+        unsigned      sq_mask    = 0;
+        unsigned      cq_mask    = 0;
+        unsigned      queued     = 0;
+    };
+#endif
+}
+
+auto AssetFile::default_mode() -> Mode
+{
+    static const auto mode = []
+    {
+        const auto value = std::getenv("NUTSHELL_ASSET_IO");
+
+        if (!value) return Mode::MMAP;
+
+        const auto name = std::string_view(value);
+
+        if (name == "read") return Mode::READ;
+        if (name == "uring") return Mode::URING;
+        if (name == "mmap") return Mode::MMAP;
+
+        throw std::runtime_error("Unknown NUTSHELL_ASSET_IO mode " + std::string(name) + ".");
+    }();
+
+    return mode;
+}
+
+auto AssetFile::open(const std::string& path) -> AssetFile
+{
+    return open(path, default_mode());
+}
+
+auto AssetFile::open(const std::string& path, Mode mode) -> AssetFile
+{
+    if (mode == Mode::URING)
+    {
+        auto files = open_all({ path }, mode);
+
+        return std::move(files.front());
+    }
+
+    AssetFile file;
+
+    if (mode == Mode::READ)
+    {
+        std::error_code error;
+
+        const auto size = static_cast<size_t>(std::filesystem::file_size(path, error));
+
+        if (error) throw failed(path);
+
+        const auto stream = std::fopen(path.c_str(), "rb");
+
+        if (!stream) throw failed(path);
+
+        // Unbuffered, so fread() reads straight into the destination instead of through the stdio buffer.
+        std::setvbuf(stream, nullptr, _IONBF, 0);
+
+        file.buffer = std::make_unique_for_overwrite<std::uint8_t[]>(size);
+
+        const auto read = std::fread(file.buffer.get(), 1, size, stream);
+
+        std::fclose(stream);
+
+        if (read != size) throw failed(path);
+
+        file.bytes = file.buffer.get();
+        file.length = size;
+
+        return file;
+    }
+
+#if defined(_WIN32)
+    const auto handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE) throw failed(path);
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(handle, &size))
+    {
+        CloseHandle(handle);
+
+        throw failed(path);
+    }
+
+    if (size.QuadPart > 0)
+    {
+        const auto section = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        // The view keeps the file and the section alive.
+        file.mapping = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (section) CloseHandle(section);
+    }
+
+    CloseHandle(handle);
+
+    if (size.QuadPart > 0 && !file.mapping) throw failed(path);
+
+    file.length = static_cast<size_t>(size.QuadPart);
+#else
+    const auto descriptor = Descriptor(path);
+    const auto size = descriptor.size();
+
+    // A zero length mapping is invalid, an empty file is just empty.
+    if (size > 0)
+    {
+        file.mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor.fd, 0);
+
+        if (file.mapping == MAP_FAILED)
+        {
+            file.mapping = nullptr;
+
+            throw failed(path);
+        }
+
+        // Decoders walk the file front to back once: read ahead aggressively and start right away.
+        madvise(file.mapping, size, MADV_SEQUENTIAL);
+        madvise(file.mapping, size, MADV_WILLNEED);
+    }
+
+    file.length = size;
+#endif
+
+    file.bytes = static_cast<const std::uint8_t*>(file.mapping);
+
+    return file;
+}
+
+auto AssetFile::open_all(const std::vector<std::string>& paths) -> std::vector<AssetFile>
+{
+    return open_all(paths, default_mode());
+}
+
+auto AssetFile::open_all(const std::vector<std::string>& paths, Mode mode) -> std::vector<AssetFile>
+{
+    std::vector<AssetFile> files;
+
+    files.reserve(paths.size());
+
+#if defined(ASSET_FILE_URING)
+    auto ring = mode == Mode::URING ? std::make_unique<Uring>(64) : nullptr;
+
+    if (ring && ring->available())
+    {
+        // Files are opened as read slots free up, so large batches do not run into the descriptor limit.
+        // On a failure the reads in flight still drain first, the kernel writes into the buffers until they complete.
+        std::vector<std::unique_ptr<Descriptor>> descriptors(paths.size());
+        std::vector<size_t> done(paths.size(), 0);
+        auto failure = paths.size();
+        size_t next = 0;
+        size_t in_flight = 0;
+
+        files.resize(paths.size());
+
+        auto queue = [&](size_t index)
+        {
+            auto& file = files[index];
+
+            ring->read(descriptors[index]->fd, file.buffer.get() + done[index], file.length - done[index], done[index], index);
+            ++in_flight;
+        };
+
+        while ((next < paths.size() && failure == paths.size()) || in_flight > 0)
+        {
+            for (; next < paths.size() && failure == paths.size() && in_flight < ring->capacity; ++next)
+            {
+                auto& file = files[next];
+
+                try
+                {
+                    descriptors[next] = std::make_unique<Descriptor>(paths[next]);
+                }
+                catch (const std::runtime_error&)
+                {
+                    failure = next;
+
+                    break;
+                }
+
+                file.length = descriptors[next]->size();
+                file.buffer = std::make_unique_for_overwrite<std::uint8_t[]>(file.length);
+                file.bytes = file.buffer.get();
+
+                if (file.length > 0) queue(next);
+                else descriptors[next].reset();
+            }
+
+            if (in_flight == 0) continue;
+
+            ring->submit_and_wait();
+            ring->complete([&](std::uint64_t index, std::int32_t result)
+            {
+                --in_flight;
+
+                done[index] += result > 0 ? static_cast<size_t>(result) : 0;
+
+                // Errors, or a file that shrank since it was opened.
+                if (result <= 0 && failure == paths.size()) failure = index;
+
+                // Short reads continue where they stopped.
+                if (result > 0 && done[index] < files[index].length && failure == paths.size()) queue(index);
+                else descriptors[index].reset();
+            });
+        }
+
+        if (failure != paths.size()) throw failed(paths[failure]);
+
+        return files;
+    }
+#endif
+
+    if (mode == Mode::URING) mode = Mode::MMAP;
+
+    for (const auto& path : paths) files.push_back(open(path, mode));
+
+    return files;
+}
+
+AssetFile::AssetFile(AssetFile&& other) noexcept:
+    bytes(other.bytes),
+    length(other.length),
+    mapping(other.mapping),
+    buffer(std::move(other.buffer))
+{
+    other.bytes = nullptr;
+    other.length = 0;
+    other.mapping = nullptr;
+}
+
+AssetFile::~AssetFile()
+{
+    release();
+}
+
+auto AssetFile::operator=(AssetFile&& other) noexcept -> AssetFile&
+{
+    if (this != &other)
+    {
+        release();
+
+        bytes = other.bytes;
+        length = other.length;
+        mapping = other.mapping;
+        buffer = std::move(other.buffer);
+
+        other.bytes = nullptr;
+        other.length = 0;
+        other.mapping = nullptr;
+    }
+
+    return *this;
+}
+
+auto AssetFile::release() -> void
+{
+    if (!mapping) return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, length);
+#endif
+
+    mapping = nullptr;
+}
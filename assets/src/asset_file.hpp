@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only contents of an asset file, handed to decoders as one contiguous block instead of buffered reads.
+//
+//     const auto file = AssetFile::open("media/image.png");
+//     png_image_begin_read_from_memory(&image, file.data(), file.size());
+//
+// MMAP maps the file and asks the kernel to read ahead, READ reads it into memory with a single read() and
+// URING batches the reads of open_all() through one io_uring (Linux, falls back to MMAP where unavailable).
+// The default comes from NUTSHELL_ASSET_IO (`mmap`, `read` or `uring`), MMAP when unset.
+struct AssetFile
+{
+    enum class Mode
+    {
+        MMAP,
+        READ,
+        URING,
+    };
+
+    static auto default_mode() -> Mode;
+    static auto open(const std::string& path) -> AssetFile;
+    static auto open(const std::string& path, Mode mode) -> AssetFile;
+    // Same order as `paths`. Throws on the first file that cannot be read.
+    static auto open_all(const std::vector<std::string>& paths) -> std::vector<AssetFile>;
+    static auto open_all(const std::vector<std::string>& paths, Mode mode) -> std::vector<AssetFile>;
+
+    AssetFile() = default;
+    AssetFile(AssetFile&& other) noexcept;
+    AssetFile(const AssetFile&) = delete;
+    ~AssetFile();
+
+    auto operator=(AssetFile&& other) noexcept -> AssetFile&;
+    auto operator=(const AssetFile&) -> AssetFile& = delete;
+
+    auto data() const -> const std::uint8_t*
+    {
+        return bytes;
+    }
+
+    auto size() const -> size_t
+    {
+        return length;
+    }
+
+private:
+    auto release() -> void;
+
+    const std::uint8_t*             bytes  = nullptr;
+    size_t                          length = 0;
+    void*                           mapping = nullptr;
+    std::unique_ptr<std::uint8_t[]> buffer;
+};
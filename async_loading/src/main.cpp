@@ -0,0 +1,346 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <profiler.hpp>
+#include <scene.hpp>
+#include <job_system.hpp>
+#include <draw_list.hpp>
+#include <camera.hpp>
+#include <task.hpp>
+#include <thread_pool.hpp>
+#include <gl_executor.hpp>
+#include <async_loader.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
+
+std::string VERTEX_SHADER_SOURCE = R"(#version 450
+layout (location = 0) uniform mat4 transformation;
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inMapping;
+
+layout (location = 0) out vec2 outMapping;
+
+void main() {
+    gl_Position = transformation * vec4(inPosition, 1);
+    outMapping = inMapping;
+}
+)";
+const char* VERTEX_SHADER_SOURCES[] = { VERTEX_SHADER_SOURCE.c_str() };
+const GLint VERTEX_SHADER_LENGTHS[] = { static_cast<GLint>(VERTEX_SHADER_SOURCE.length()) };
+
+std::string FRAGMENT_SHADER_SOURCE = R"(#version 450
+layout (binding = 0) uniform sampler2D textureColor;
+
+layout (location = 0) in vec2 inMapping;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textureColor, inMapping);
+}
+)";
+const char* FRAGMENT_SHADER_SOURCES[] = { FRAGMENT_SHADER_SOURCE.c_str() };
+const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOURCE.length()) };
+
+using Clock = std::chrono::steady_clock;
+
+auto milliseconds(Clock::time_point begin, Clock::time_point end) -> double
+{
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
+struct Options
+{
+    static auto from(int argc, char** argv) -> Options
+    {
+        auto options = Options();
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto argument = std::string(argv[i]);
+            const auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument + ".");
+
+                return argv[++i];
+            };
+
+            if (argument == "--scene") options.scene = value();
+            else if (argument == "--threads") options.threads = std::stoul(value());
+            else if (argument == "--budget-ms") options.budget_ms = std::stod(value());
+            else throw std::runtime_error("Unknown argument " + argument + ".");
+        }
+
+        if (!(options.budget_ms > 0.0)) throw std::runtime_error("GL budget must be positive.");
+
+        return options;
+    }
+
+    std::string scene     = "media/room.gltf";
+    size_t      threads   = 0;
+    double      budget_ms = 2.0;
+};
+
+int main(int argc, char** argv) {
+    try {
+        PROFILE_THREAD("main");
+
+        auto capture = Capture();
+
+        const auto options = Options::from(argc, argv);
+        const auto started = Clock::now();
+
+        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        capture.hint();
+
+        const auto window = glfwCreateWindow(1024, 1024, "Async Loading", nullptr, nullptr);
+
+        if (!window) throw std::runtime_error("Window creation failed.");
+
+        glfwMakeContextCurrent(window);
+
+        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+
+        // The executor outlives the pool, whose workers may still queue onto it while they shut down.
+        auto gl = GlExecutor();
+        auto pool = std::make_unique<ThreadPool>(options.threads);
+        auto loader = AsyncLoader(*pool, gl);
+        auto jobs = JobSystem(options.threads);
+
+        // Import and decoding start on the pool right away, uploads trickle in through gl.poll() below.
+        auto pending = spawn(loader.load_scene(options.scene));
+
+        const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
+
+        GLint vertexShaderCompileStatus;
+
+        {
+            PROFILE_SCOPE("vertex shader compile");
+
+            glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
+            glCompileShader(vertexShader);
+            glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        }
+
+        if (vertexShaderCompileStatus != GL_TRUE) {
+            GLint size = 0;
+
+            glGetShaderiv(vertexShader, GL_INFO_LOG_LENGTH, &size);
+
+            std::string log;
+
+            log.resize(size);
+            glGetShaderInfoLog(vertexShader, size, &size, log.data());
+
+            throw std::runtime_error(log);
+        }
+
+        const auto fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+        GLint fragmentShaderCompileStatus;
+
+        {
+            PROFILE_SCOPE("fragment shader compile");
+
+            glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
+            glCompileShader(fragmentShader);
+            glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        }
+
+        if (fragmentShaderCompileStatus != GL_TRUE) {
+            GLint size = 0;
+
+            glGetShaderiv(fragmentShader, GL_INFO_LOG_LENGTH, &size);
+
+            std::string log;
+
+            log.resize(size);
+            glGetShaderInfoLog(fragmentShader, size, &size, log.data());
+
+            throw std::runtime_error(log);
+        }
+
+        const auto program = glCreateProgram();
+
+        GLint linkStatus;
+
+        {
+            PROFILE_SCOPE("program link");
+
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        }
+
+        if (linkStatus != GL_TRUE) {
+            GLint size = 0;
+
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+
+            std::string log;
+
+            log.resize(size);
+            glGetProgramInfoLog(program, size, &size, log.data());
+
+            throw std::runtime_error(log);
+        }
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        GLuint sampler;
+
+        glCreateSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        // Owns the loaded tree, the draw list only points into it.
+        std::shared_ptr<Node> root;
+        std::unique_ptr<DrawList> draw_list;
+        auto camera = Camera();
+        auto pacer = FramePacer();
+        auto first_frame = Clock::time_point();
+        auto loaded = Clock::time_point();
+        size_t frames_while_loading = 0;
+        auto last = Clock::now();
+
+        while (!glfwWindowShouldClose(window))
+        {
+            PROFILE_SCOPE("frame");
+
+            glfwPollEvents();
+
+            pacer.begin();
+
+            {
+                PROFILE_SCOPE("uploads");
+
+                gl.poll(options.budget_ms);
+            }
+
+            if (!draw_list && pending->ready())
+            {
+                root = pending->get();
+                draw_list = std::make_unique<DrawList>(*root, jobs);
+                loaded = Clock::now();
+            }
+
+            const auto now = Clock::now();
+
+            std::uint8_t input = 0;
+
+            if (glfwGetKey(window, GLFW_KEY_UP)) input |= CAMERA_INPUT_UP;
+            if (glfwGetKey(window, GLFW_KEY_DOWN)) input |= CAMERA_INPUT_DOWN;
+            if (glfwGetKey(window, GLFW_KEY_RIGHT)) input |= CAMERA_INPUT_RIGHT;
+            if (glfwGetKey(window, GLFW_KEY_LEFT)) input |= CAMERA_INPUT_LEFT;
+
+            camera.update(input, std::chrono::duration<float>(now - last).count());
+            last = now;
+
+            int width, height;
+
+            glfwGetFramebufferSize(window, &width, &height);
+
+            glViewport(0, 0, width, height);
+            glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
+            glClearDepth(1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            if (draw_list)
+            {
+                glEnable(GL_CULL_FACE);
+                glCullFace(GL_BACK);
+                glFrontFace(GL_CCW);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glEnable(GL_DEPTH_TEST);
+                glDepthFunc(GL_LESS);
+                glUseProgram(program);
+                glActiveTexture(GL_TEXTURE0);
+                glBindSampler(0, sampler);
+
+                draw_list->build(camera.view_projection(static_cast<float>(width) / static_cast<float>(height)));
+                draw_list->submit(program);
+            }
+            else
+            {
+                ++frames_while_loading;
+            }
+
+            capture.frame(window);
+
+            {
+                PROFILE_SCOPE("glfwSwapBuffers");
+
+                glfwSwapBuffers(window);
+            }
+
+            pacer.end();
+
+            if (first_frame == Clock::time_point()) first_frame = Clock::now();
+        }
+
+        // Closing mid-load still lets every task finish, so no coroutine is left suspended on the pool.
+        while (!pending->ready()) gl.poll(options.budget_ms);
+
+        const auto threads = pool->threads();
+
+        draw_list.reset();
+        root.reset();
+        pool.reset();
+
+        std::cout << "{\n";
+        std::cout << "    \"threads\": " << threads << ",\n";
+        std::cout << "    \"first_frame_ms\": " << milliseconds(started, first_frame) << ",\n";
+
+        if (loaded != Clock::time_point()) std::cout << "    \"loaded_ms\": " << milliseconds(started, loaded) << ",\n";
+        else std::cout << "    \"loaded_ms\": null,\n";
+
+        std::cout << "    \"frames_while_loading\": " << frames_while_loading << "\n";
+        std::cout << "}" << std::endl;
+
+        auto error = glGetError();
+
+        if (error != GL_NO_ERROR) {
+            if (error == GL_INVALID_ENUM) throw std::runtime_error("GL_INVALID_ENUM");
+            if (error == GL_INVALID_VALUE) throw std::runtime_error("GL_INVALID_VALUE");
+            if (error == GL_INVALID_OPERATION) throw std::runtime_error("GL_INVALID_OPERATION");
+            if (error == GL_INVALID_FRAMEBUFFER_OPERATION) throw std::runtime_error("GL_INVALID_FRAMEBUFFER_OPERATION");
+            if (error == GL_OUT_OF_MEMORY) throw std::runtime_error("GL_OUT_OF_MEMORY");
+            if (error == GL_STACK_UNDERFLOW) throw std::runtime_error("GL_STACK_UNDERFLOW");
+            if (error == GL_STACK_OVERFLOW) throw std::runtime_error("GL_STACK_OVERFLOW");
+
+            throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
+        }
+
+        PROFILE_WRITE("async_loading.trace.json");
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    catch (std::runtime_error error) {
+        std::cerr << error.what() << std::endl;
+
+        throw;
+    }
+
+    std::cout << "done" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <asset_file.hpp>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    auto media_files() -> std::vector<std::string>
+    {
+        std::vector<std::string> paths;
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("media", error))
+        {
+            if (entry.is_regular_file()) paths.push_back(entry.path().generic_string());
+        }
+
+        return paths;
+    }
+
+    // Drops the files from the page cache, so the next read goes to the disk. Linux only, elsewhere runs stay warm.
+    auto evict(const std::vector<std::string>& paths) -> void
+    {
+#if defined(__linux__)
+        for (const auto& path : paths)
+        {
+            const auto fd = ::open(path.c_str(), O_RDONLY);
+
+            if (fd < 0) continue;
+
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+#endif
+    }
+
+    // Touches every page, a mapping costs nothing until it is read.
+    auto consume(const std::uint8_t* data, size_t size) -> std::uint32_t
+    {
+        std::uint32_t sum = 0;
+
+        for (size_t i = 0; i < size; i += 4096) sum += data[i];
+
+        return sum;
+    }
+
+    // What png_image_begin_read_from_file does: buffered stdio reads into the decoder's own buffers.
+    auto BM_AssetReadStdio(benchmark::State& state) -> void
+    {
+        const auto paths = media_files();
+        const auto cold = state.range(0) != 0;
+        std::vector<std::uint8_t> chunk(8192);
+        size_t bytes = 0;
+
+        for (auto _ : state)
+        {
+            if (cold)
+            {
+                state.PauseTiming();
+                evict(paths);
+                state.ResumeTiming();
+            }
+
+            bytes = 0;
+
+            for (const auto& path : paths)
+            {
+                const auto file = std::fopen(path.c_str(), "rb");
+
+                for (size_t read; (read = std::fread(chunk.data(), 1, chunk.size(), file)) > 0;)
+                {
+                    benchmark::DoNotOptimize(consume(chunk.data(), read));
+                    bytes += read;
+                }
+
+                std::fclose(file);
+            }
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+
+    auto BM_AssetRead(benchmark::State& state, AssetFile::Mode mode) -> void
+    {
+        const auto paths = media_files();
+        const auto cold = state.range(0) != 0;
+        size_t bytes = 0;
+
+        for (auto _ : state)
+        {
+            if (cold)
+            {
+                state.PauseTiming();
+                evict(paths);
+                state.ResumeTiming();
+            }
+
+            bytes = 0;
+
+            for (const auto& file : AssetFile::open_all(paths, mode))
+            {
+                benchmark::DoNotOptimize(consume(file.data(), file.size()));
+                bytes += file.size();
+            }
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+}
+
+// Argument 1 reads from a cold page cache.
+BENCHMARK(BM_AssetReadStdio)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_AssetRead, mmap, AssetFile::Mode::MMAP)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_AssetRead, read, AssetFile::Mode::READ)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_AssetRead, uring, AssetFile::Mode::URING)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <camera.hpp>
+
+namespace
+{
+    // Per-frame model/view/projection construction of the perspective sample (perspective/src/main.cpp).
+    auto perspective_transformation(float x, float y, float aspect) -> glm::mat4
+    {
+        glm::mat4x3 model = glm::transpose(glm::mat3x4(
+            +glm::cos(y), +0.0f,  +glm::sin(y), +0.0f,
+            +0.0f,        +1.0f,  +0.0f,        +0.0f,
+            -glm::sin(y), +0.0f,  +glm::cos(y), +0.0f
+        ));
+        glm::mat4x3 view = glm::transpose(glm::mat3x4(
+            +1.0f, +0.0f,         +0.0f,         +0.0f,
+            +0.0f, +glm::cos(-x), +glm::sin(-x), +0.0f,
+            +0.0f, -glm::sin(-x), +glm::cos(-x), -2.0f
+        ));
+
+        const auto fov = glm::radians(60.0f);
+        const auto z_near = 0.01f;
+        const auto z_far = 10.0f;
+
+        glm::mat4 projection = glm::transpose(glm::mat4(
+            aspect / glm::cos(fov / 2.0f), 0.0f,                        0.0f,                             0.0f,
+            0.0f,                          1.0f / glm::cos(fov / 2.0f), 0.0f,                             0.0f,
+            0.0f,                          0.0f,                        -(z_far*z_near)/(z_far - z_near), -(2.0f*z_far*z_near)/(z_far - z_near),
+            0.0f,                          0.0f,                        -1.0f,                            0.0f
+        ));
+
+        return projection * glm::mat4(view) * glm::mat4(model);
+    }
+
+    // Each iteration builds `count` matrices, as many frames' worth of cameras.
+    auto BM_DepthTestViewProjection(benchmark::State& state) -> void
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        auto matrices = std::vector<glm::mat4>(count);
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                matrices[i] = Camera::scripted(i, count).view_projection(16.0f / 9.0f);
+            }
+
+            benchmark::DoNotOptimize(matrices.data());
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+
+    auto BM_PerspectiveTransformation(benchmark::State& state) -> void
+    {
+        const auto count = static_cast<size_t>(state.range(0));
+        auto matrices = std::vector<glm::mat4>(count);
+
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto t = static_cast<float>(i) / static_cast<float>(count);
+
+                matrices[i] = perspective_transformation(t, glm::radians(360.0f) * t, 16.0f / 9.0f);
+            }
+
+            benchmark::DoNotOptimize(matrices.data());
+            benchmark::ClobberMemory();
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+}
+
+BENCHMARK(BM_DepthTestViewProjection)->RangeMultiplier(8)->Range(1, 1 << 15);
+BENCHMARK(BM_PerspectiveTransformation)->RangeMultiplier(8)->Range(1, 1 << 15);
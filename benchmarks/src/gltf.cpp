@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <asset_io_system.hpp>
+#include <gltf_scene.hpp>
+#include <job_system.hpp>
+#include <scene.hpp>
+#include <synthetic_scene.hpp>
+
+namespace
+{
+    // Synthetic .glb with `nodes` meshes of `triangles` each, written once per size.
+    auto scene_file(size_t nodes, size_t triangles) -> std::string
+    {
+        const auto path = (std::filesystem::temp_directory_path() / ("nutshell_gltf_" + std::to_string(nodes) + "_" + std::to_string(triangles) + ".glb")).string();
+
+        if (!std::filesystem::exists(path))
+        {
+            auto settings = SyntheticScene::Settings();
+
+            settings.nodes = nodes;
+            settings.triangles_per_mesh = triangles;
+            settings.textures = 0;
+
+            SyntheticScene::export_gltf(SyntheticScene::generate(settings).get(), path);
+        }
+
+        return path;
+    }
+
+    // Import and conversion to Vertex layout on every core, everything depth_test does before the GL upload.
+    // Argument 0 imports through assimp and converts its aiMeshes, 1 reads the file with GltfScene.
+    auto import(benchmark::State& state, const std::string& path) -> void
+    {
+        const auto native = state.range(0) == 1;
+
+        auto jobs = JobSystem();
+        size_t vertices = 0;
+
+        for (auto _ : state)
+        {
+            vertices = 0;
+
+            if (native)
+            {
+                const auto scene = GltfScene::load(path, &jobs);
+
+                for (const auto& mesh : scene.meshes)
+                {
+                    for (const auto& primitive : mesh.primitives) vertices += Mesh::convert(scene, primitive, &jobs).vertices.size();
+                }
+            }
+            else
+            {
+                Assimp::Importer importer;
+
+                importer.SetIOHandler(new AssetIOSystem());
+
+                const auto scene = importer.ReadFile(path, aiProcess_Triangulate);
+
+                if (!scene)
+                {
+                    state.SkipWithError(importer.GetErrorString());
+
+                    return;
+                }
+
+                for (size_t i = 0; i < scene->mNumMeshes; ++i) vertices += Mesh::convert(scene->mMeshes[i], &jobs).vertices.size();
+            }
+        }
+
+        state.SetLabel(native ? "GltfScene" : "assimp");
+        state.counters["vertices"] = static_cast<double>(vertices);
+    }
+
+    auto BM_ImportRoom(benchmark::State& state) -> void
+    {
+        if (!std::filesystem::exists("media/room.gltf"))
+        {
+            state.SkipWithError("No media/room.gltf, run from the repository root.");
+
+            return;
+        }
+
+        import(state, "media/room.gltf");
+    }
+
+    auto BM_ImportSynthetic(benchmark::State& state) -> void
+    {
+        import(state, scene_file(static_cast<size_t>(state.range(1)), static_cast<size_t>(state.range(2))));
+    }
+}
+
+BENCHMARK(BM_ImportRoom)->Arg(0)->Arg(1)->ArgName("native")->UseRealTime()->Unit(benchmark::kMillisecond);
+// Many small meshes against a few large ones.
+BENCHMARK(BM_ImportSynthetic)
+    ->ArgsProduct({ { 0, 1 }, { 10000 }, { 64 } })
+    ->ArgsProduct({ { 0, 1 }, { 16 }, { 1 << 18 } })
+    ->ArgNames({ "native", "nodes", "triangles" })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
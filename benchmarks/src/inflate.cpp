@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <zlib.h>
+
+namespace
+{
+    // Concatenated IDAT payloads of a PNG file, the zlib stream libpng feeds to inflate.
+    auto idat_stream(const std::string& path) -> std::vector<std::uint8_t>
+    {
+        auto file = std::ifstream(path, std::ios::binary);
+        const auto bytes = std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), {});
+
+        std::vector<std::uint8_t> stream;
+
+        // 8 byte signature, then chunks of big endian length, type, data and CRC.
+        for (size_t offset = 8; offset + 8 <= bytes.size();)
+        {
+            const auto length = static_cast<size_t>(bytes[offset]) << 24 | bytes[offset + 1] << 16 | bytes[offset + 2] << 8 | bytes[offset + 3];
+            const auto type = std::string(bytes.begin() + offset + 4, bytes.begin() + offset + 8);
+
+            if (offset + 12 + length > bytes.size()) throw std::runtime_error("Truncated PNG chunk.");
+
+            if (type == "IDAT") stream.insert(stream.end(), bytes.begin() + offset + 8, bytes.begin() + offset + 8 + length);
+
+            offset += 12 + length;
+        }
+
+        return stream;
+    }
+
+    auto inflate_stream(const std::vector<std::uint8_t>& stream, std::vector<std::uint8_t>& output) -> size_t
+    {
+        z_stream z = {};
+
+        if (inflateInit(&z) != Z_OK) throw std::runtime_error("Failed to initialize inflate.");
+
+        z.next_in = const_cast<Bytef*>(stream.data());
+        z.avail_in = static_cast<uInt>(stream.size());
+
+        for (;;)
+        {
+            // Sized on the first run, later runs inflate in one call.
+            if (z.total_out == output.size()) output.resize(output.empty() ? stream.size() * 4 : output.size() * 2);
+
+            z.next_out = output.data() + z.total_out;
+            z.avail_out = static_cast<uInt>(output.size() - z.total_out);
+
+            const auto status = inflate(&z, Z_NO_FLUSH);
+
+            if (status == Z_STREAM_END) break;
+            if (status != Z_OK && status != Z_BUF_ERROR) throw std::runtime_error("Failed to inflate.");
+        }
+
+        const auto size = static_cast<size_t>(z.total_out);
+
+        inflateEnd(&z);
+
+        return size;
+    }
+
+    // Inflate alone, without libpng's row filters and transforms. Build with NUTSHELL_ZLIB_NG on and off to
+    // compare the backends, the label shows which one ran.
+    auto BM_InflateFile(benchmark::State& state, const std::string& path) -> void
+    {
+        const auto stream = idat_stream(path);
+        std::vector<std::uint8_t> output;
+        size_t inflated = 0;
+
+        for (auto _ : state)
+        {
+            inflated = inflate_stream(stream, output);
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * inflated));
+        state.SetLabel(zlibVersion());
+        state.counters["compressed_bytes"] = static_cast<double>(stream.size());
+    }
+
+    const auto media_registered = []
+    {
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("media", error))
+        {
+            if (entry.path().extension() != ".png") continue;
+
+            const auto path = entry.path().generic_string();
+
+            benchmark::RegisterBenchmark(("BM_InflateFile/" + entry.path().filename().string()).c_str(), BM_InflateFile, path)
+                ->Unit(benchmark::kMillisecond);
+        }
+
+        return true;
+    }();
+}
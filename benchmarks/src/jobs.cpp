@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <glm/glm.hpp>
+#include <assimp/scene.h>
+#include <asset_file.hpp>
+#include <job_system.hpp>
+#include <scene.hpp>
+#include <synthetic_scene.hpp>
+
+namespace
+{
+    // 1, 2, 4, ... threads up to every core, so each benchmark reads as a scaling curve.
+    auto scaling(benchmark::internal::Benchmark* benchmark) -> void
+    {
+        const auto cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+        for (size_t threads = 1; threads < cores; threads *= 2) benchmark->Arg(static_cast<std::int64_t>(threads));
+
+        benchmark->Arg(static_cast<std::int64_t>(cores));
+        benchmark->ArgName("threads");
+        benchmark->UseRealTime();
+    }
+
+    // Fixed cost per job: submit and wait on empty jobs.
+    auto BM_JobsEmpty(benchmark::State& state) -> void
+    {
+        constexpr size_t COUNT = 10000;
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            auto counter = JobSystem::Counter();
+
+            for (size_t i = 0; i < COUNT; ++i) jobs.submit([] {}, counter);
+
+            jobs.wait(counter);
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * COUNT));
+    }
+
+    // Transform update: world = parent * local over a flattened hierarchy, split by parallel_for's own grain.
+    auto BM_JobsTransforms(benchmark::State& state) -> void
+    {
+        constexpr size_t COUNT = 1 << 20;
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+        const auto parents = std::vector<glm::mat4>(COUNT, glm::mat4(1.0f));
+        auto locals = std::vector<glm::mat4>(COUNT, glm::mat4(1.0f));
+        auto worlds = std::vector<glm::mat4>(COUNT);
+
+        for (size_t i = 0; i < COUNT; ++i) locals[i][3] = glm::vec4(static_cast<float>(i), 1.0f, 0.0f, 1.0f);
+
+        for (auto _ : state)
+        {
+            jobs.parallel_for(0, COUNT, [&](size_t begin, size_t end)
+            {
+                for (auto i = begin; i < end; ++i) worlds[i] = parents[i] * locals[i];
+            });
+
+            benchmark::DoNotOptimize(worlds.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * COUNT));
+    }
+
+    // Mesh conversion, one mesh per job.
+    auto BM_JobsMeshConvert(benchmark::State& state) -> void
+    {
+        auto settings = SyntheticScene::Settings();
+
+        settings.nodes = 64;
+        settings.triangles_per_mesh = 16384;
+        settings.textures = 0;
+
+        const auto scene = SyntheticScene::generate(settings);
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+        auto vertices = std::vector<std::vector<Vertex>>(scene->mNumMeshes);
+        size_t count = 0;
+
+        for (size_t i = 0; i < scene->mNumMeshes; ++i) count += scene->mMeshes[i]->mNumVertices;
+
+        for (auto _ : state)
+        {
+            jobs.parallel_for(0, scene->mNumMeshes, [&](size_t begin, size_t end)
+            {
+                for (auto i = begin; i < end; ++i) vertices[i] = Mesh::convert_vertices(scene->mMeshes[i]);
+            }, 1);
+
+            benchmark::DoNotOptimize(vertices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+
+    // Texture decode of everything in media/, one file per job, the way Material::from decodes with a job system.
+    auto BM_JobsPngDecode(benchmark::State& state) -> void
+    {
+        std::vector<std::string> paths;
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("media", error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".png") paths.push_back(entry.path().generic_string());
+        }
+
+        if (paths.empty())
+        {
+            state.SkipWithError("No PNGs in media/, run from the repository root.");
+
+            return;
+        }
+
+        const auto files = AssetFile::open_all(paths);
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+        auto decoded = std::vector<Material::Image>(files.size());
+        size_t bytes = 0;
+
+        for (auto _ : state)
+        {
+            jobs.parallel_for(0, files.size(), [&](size_t begin, size_t end)
+            {
+                for (auto i = begin; i < end; ++i) decoded[i] = Material::decode(files[i]);
+            }, 1);
+
+            bytes = 0;
+
+            // RGBA8 bytes whatever the files were packed into, so runs with and without NUTSHELL_TEXTURE_FORMATS compare.
+            for (const auto& image : decoded) bytes += static_cast<size_t>(image.width) * image.height * 4;
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+}
+
+BENCHMARK(BM_JobsEmpty)->Apply(scaling);
+BENCHMARK(BM_JobsTransforms)->Apply(scaling)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JobsMeshConvert)->Apply(scaling)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JobsPngDecode)->Apply(scaling)->Unit(benchmark::kMillisecond);
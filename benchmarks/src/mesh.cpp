@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <assimp/mesh.h>
+#include <job_system.hpp>
+#include <scene.hpp>
+
+namespace
+{
+    // Triangle strip-like mesh with one UV channel, the shape Mesh::from expects after aiProcess_Triangulate.
+    auto synthetic_mesh(unsigned vertices_count) -> std::unique_ptr<aiMesh>
+    {
+        auto mesh = std::make_unique<aiMesh>();
+
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        mesh->mNumVertices = vertices_count;
+        mesh->mVertices = new aiVector3D[vertices_count];
+        mesh->mTextureCoords[0] = new aiVector3D[vertices_count];
+        mesh->mNumUVComponents[0] = 2;
+
+        for (unsigned i = 0; i < vertices_count; ++i)
+        {
+            const auto t = static_cast<float>(i) / static_cast<float>(vertices_count);
+
+            mesh->mVertices[i] = aiVector3D(t, 1.0f - t, 0.5f * t);
+            mesh->mTextureCoords[0][i] = aiVector3D(t, t * t, 0.0f);
+        }
+
+        const auto faces_count = vertices_count > 2 ? vertices_count - 2 : 0;
+
+        mesh->mNumFaces = faces_count;
+        mesh->mFaces = new aiFace[faces_count];
+
+        for (unsigned i = 0; i < faces_count; ++i)
+        {
+            mesh->mFaces[i].mNumIndices = 3;
+            mesh->mFaces[i].mIndices = new unsigned[3] { i, i + 1, i + 2 };
+        }
+
+        return mesh;
+    }
+
+    // The per-vertex loop Mesh::convert_vertices replaced, the baseline for the SIMD kernel.
+    auto BM_MeshConvertVerticesScalar(benchmark::State& state) -> void
+    {
+        const auto mesh = synthetic_mesh(static_cast<unsigned>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            auto vertices = std::vector<Vertex>(mesh->mNumVertices);
+
+            for (size_t i = 0; i < mesh->mNumVertices; ++i) {
+                const auto position = mesh->mVertices[i];
+                const auto mapping = mesh->mTextureCoords[0][i];
+
+                vertices[i] = {
+                    { position.x, position.y, position.z },
+                    { mapping.x, 1.0f - mapping.y },
+                };
+            }
+
+            benchmark::DoNotOptimize(vertices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumVertices));
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumVertices * sizeof(Vertex)));
+    }
+
+    auto BM_MeshConvertVertices(benchmark::State& state) -> void
+    {
+        const auto mesh = synthetic_mesh(static_cast<unsigned>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            const auto vertices = Mesh::convert_vertices(mesh.get());
+
+            benchmark::DoNotOptimize(vertices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumVertices));
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumVertices * sizeof(Vertex)));
+    }
+
+    // One large mesh split into ranges across the job system, items are vertices.
+    auto BM_MeshConvertParallel(benchmark::State& state) -> void
+    {
+        const auto mesh = synthetic_mesh(1 << 22);
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            const auto converted = Mesh::convert(mesh.get(), &jobs);
+
+            benchmark::DoNotOptimize(converted.vertices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumVertices));
+    }
+
+    auto BM_MeshConvertIndices(benchmark::State& state) -> void
+    {
+        const auto mesh = synthetic_mesh(static_cast<unsigned>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            const auto indices = Mesh::convert_indices(mesh.get());
+
+            benchmark::DoNotOptimize(indices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumFaces * 3));
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * mesh->mNumFaces * 3 * sizeof(std::uint32_t)));
+    }
+}
+
+BENCHMARK(BM_MeshConvertVerticesScalar)->RangeMultiplier(8)->Range(1 << 9, 1 << 21);
+BENCHMARK(BM_MeshConvertVertices)->RangeMultiplier(8)->Range(1 << 9, 1 << 21);
+BENCHMARK(BM_MeshConvertIndices)->RangeMultiplier(8)->Range(1 << 9, 1 << 21);
+BENCHMARK(BM_MeshConvertParallel)->RangeMultiplier(2)->Range(1, std::max<int>(1, static_cast<int>(std::thread::hardware_concurrency())))->ArgName("threads")->UseRealTime()->Unit(benchmark::kMillisecond);
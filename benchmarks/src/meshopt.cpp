@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <meshoptimizer.h>
+#include <gltf_compression.hpp>
+#include <job_system.hpp>
+#include <scene.hpp>
+#include <synthetic_scene.hpp>
+
+namespace
+{
+    // Welded grid of `triangles` faces in Vertex layout, encoded the way gltfpack writes EXT_meshopt_compression.
+    struct Encoded
+    {
+        explicit Encoded(size_t triangles)
+        {
+            auto settings = SyntheticScene::Settings();
+
+            settings.nodes = 1;
+            settings.depth = 1;
+            settings.triangles_per_mesh = triangles;
+            settings.textures = 0;
+
+            const auto scene = SyntheticScene::generate(settings);
+            const auto converted = Mesh::convert(scene->mMeshes[0], nullptr, 0.0f);
+
+            vertices_count = converted.vertices.size();
+            indices_count = converted.indices.size();
+
+            vertices.resize(meshopt_encodeVertexBufferBound(vertices_count, sizeof(Vertex)));
+            vertices.resize(meshopt_encodeVertexBuffer(vertices.data(), vertices.size(), converted.vertices.data(), vertices_count, sizeof(Vertex)));
+            indices.resize(meshopt_encodeIndexBufferBound(indices_count, vertices_count));
+            indices.resize(meshopt_encodeIndexBuffer(indices.data(), indices.size(), converted.indices.data(), indices_count));
+        }
+
+        size_t                     vertices_count = 0;
+        size_t                     indices_count  = 0;
+        std::vector<std::uint8_t>  vertices;
+        std::vector<std::uint8_t>  indices;
+    };
+
+    // Decoded bytes per second, and the compressed bytes per second in `input` to hold against BM_AssetRead.
+    auto report(benchmark::State& state, size_t decoded, size_t compressed) -> void
+    {
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * decoded));
+        state.counters["input"] = benchmark::Counter(static_cast<double>(state.iterations() * compressed), benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
+        state.counters["ratio"] = static_cast<double>(decoded) / static_cast<double>(compressed);
+    }
+
+    auto BM_MeshoptDecodeVertices(benchmark::State& state) -> void
+    {
+        const auto encoded = Encoded(static_cast<size_t>(state.range(0)));
+        const auto view = GltfCompression::MeshoptView{ encoded.vertices.data(), encoded.vertices.size(), encoded.vertices_count, sizeof(Vertex) };
+
+        auto output = std::vector<std::uint8_t>(encoded.vertices_count * sizeof(Vertex));
+
+        for (auto _ : state)
+        {
+            GltfCompression::decode(view, output.data());
+
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        report(state, output.size(), encoded.vertices.size());
+    }
+
+    auto BM_MeshoptDecodeIndices(benchmark::State& state) -> void
+    {
+        const auto encoded = Encoded(static_cast<size_t>(state.range(0)));
+        const auto view = GltfCompression::MeshoptView{ encoded.indices.data(), encoded.indices.size(), encoded.indices_count, sizeof(std::uint32_t), GltfCompression::Mode::TRIANGLES };
+
+        auto output = std::vector<std::uint8_t>(encoded.indices_count * sizeof(std::uint32_t));
+
+        for (auto _ : state)
+        {
+            GltfCompression::decode(view, output.data());
+
+            benchmark::DoNotOptimize(output.data());
+        }
+
+        report(state, output.size(), encoded.indices.size());
+    }
+
+    // A scene's worth of compressed views, 64 meshes of vertices and indices, decoded one job per view the way
+    // GltfScene::load does.
+    auto BM_MeshoptDecodeViews(benchmark::State& state) -> void
+    {
+        constexpr size_t MESHES = 64;
+
+        const auto encoded = Encoded(16384);
+
+        std::vector<GltfCompression::MeshoptView> views;
+
+        for (size_t i = 0; i < MESHES; ++i)
+        {
+            views.push_back({ encoded.vertices.data(), encoded.vertices.size(), encoded.vertices_count, sizeof(Vertex) });
+            views.push_back({ encoded.indices.data(), encoded.indices.size(), encoded.indices_count, sizeof(std::uint32_t), GltfCompression::Mode::TRIANGLES });
+        }
+
+        auto outputs = std::vector<std::vector<std::uint8_t>>(views.size());
+        size_t decoded = 0;
+
+        for (size_t i = 0; i < views.size(); ++i)
+        {
+            outputs[i].resize(views[i].count * views[i].stride);
+            decoded += outputs[i].size();
+        }
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            jobs.parallel_for(0, views.size(), [&](size_t begin, size_t end)
+            {
+                for (auto i = begin; i < end; ++i) GltfCompression::decode(views[i], outputs[i].data());
+            }, 1);
+        }
+
+        report(state, decoded, MESHES * (encoded.vertices.size() + encoded.indices.size()));
+    }
+}
+
+BENCHMARK(BM_MeshoptDecodeVertices)->Arg(1 << 16)->Arg(1 << 20)->ArgName("triangles")->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MeshoptDecodeIndices)->Arg(1 << 16)->Arg(1 << 20)->ArgName("triangles")->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MeshoptDecodeViews)->RangeMultiplier(2)->Range(1, 8)->ArgName("threads")->UseRealTime()->Unit(benchmark::kMillisecond);
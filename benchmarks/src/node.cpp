@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <assimp/scene.h>
+#include <scene.hpp>
+#include <job_system.hpp>
+#include <draw_list.hpp>
+#include <camera.hpp>
+#include <synthetic_scene.hpp>
+
+namespace
+{
+    auto BM_NodeFrom(benchmark::State& state) -> void
+    {
+        auto settings = SyntheticScene::Settings();
+
+        settings.nodes = static_cast<size_t>(state.range(0));
+        settings.depth = static_cast<size_t>(state.range(1));
+        settings.triangles_per_mesh = 2;
+        settings.textures = 0;
+
+        const auto scene = SyntheticScene::generate(settings);
+        const auto meshes = std::vector<std::shared_ptr<Mesh>>(scene->mNumMeshes);
+
+        for (auto _ : state)
+        {
+            const auto root = Node::from(scene->mRootNode, meshes);
+
+            benchmark::DoNotOptimize(root.get());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * state.range(0)));
+    }
+
+    auto BM_DrawListBuild(benchmark::State& state) -> void
+    {
+        auto settings = SyntheticScene::Settings();
+
+        settings.nodes = static_cast<size_t>(state.range(0));
+        settings.depth = 8;
+        settings.triangles_per_mesh = 2;
+        settings.textures = 0;
+
+        const auto scene = SyntheticScene::generate(settings);
+
+        // Only the GL names are read while building, so meshes need no context.
+        auto meshes = std::vector<std::shared_ptr<Mesh>>();
+
+        for (size_t i = 0; i < scene->mNumMeshes; ++i)
+        {
+            meshes.push_back(std::make_shared<Mesh>(0, 0, static_cast<GLuint>(i + 1), 6, nullptr, glm::vec3(-0.5f, -0.1f, -0.5f), glm::vec3(0.5f, 0.1f, 0.5f)));
+        }
+
+        const auto root = Node::from(scene->mRootNode, meshes);
+        const auto view_projection = Camera::scripted(0, 1).view_projection(1.0f);
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(1)));
+        auto draw_list = DrawList(*root, jobs);
+
+        for (auto _ : state)
+        {
+            draw_list.build(view_projection);
+
+            benchmark::DoNotOptimize(draw_list.batches.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * state.range(0)));
+    }
+}
+
+BENCHMARK(BM_NodeFrom)->ArgsProduct({ { 10, 100, 1000, 10000, 100000 }, { 4, 32 } })->ArgNames({ "nodes", "depth" });
+BENCHMARK(BM_DrawListBuild)->ArgsProduct({ { 1000, 10000, 100000 }, { 1, 2, 4, 8 } })->ArgNames({ "nodes", "threads" })->UseRealTime();
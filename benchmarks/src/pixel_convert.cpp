@@ -0,0 +1,261 @@
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <png.h>
+#include <pixel_convert.hpp>
+
+namespace
+{
+    constexpr size_t PIXELS = 1024 * 1024;
+
+    auto pattern(size_t bytes) -> std::vector<std::uint8_t>
+    {
+        std::vector<std::uint8_t> values(bytes);
+
+        for (size_t i = 0; i < bytes; ++i) values[i] = static_cast<std::uint8_t>(i * 31 + (i >> 12));
+
+        return values;
+    }
+
+    // libpng adds the alpha channel (and expands gray) itself, what Material::load_texture used to do.
+    auto BM_PngRgbaLibpng(benchmark::State& state, const std::string& path) -> void
+    {
+        size_t decoded = 0;
+
+        for (auto _ : state)
+        {
+            png_image image = {};
+
+            image.version = PNG_IMAGE_VERSION;
+
+            if (png_image_begin_read_from_file(&image, path.c_str()) == 0) throw std::runtime_error("Failed to load image.");
+
+            image.format = PNG_FORMAT_RGBA;
+
+            std::vector<std::uint8_t> rgba(PNG_IMAGE_SIZE(image));
+
+            if (png_image_finish_read(&image, nullptr, rgba.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+
+            benchmark::DoNotOptimize(rgba.data());
+
+            decoded = rgba.size();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * decoded));
+    }
+
+    // libpng decodes the file's channels, pixels::best() expands them.
+    auto BM_PngRgbaKernels(benchmark::State& state, const std::string& path) -> void
+    {
+        size_t decoded = 0;
+
+        for (auto _ : state)
+        {
+            png_image image = {};
+
+            image.version = PNG_IMAGE_VERSION;
+
+            if (png_image_begin_read_from_file(&image, path.c_str()) == 0) throw std::runtime_error("Failed to load image.");
+
+            std::vector<std::uint8_t> rgba(static_cast<size_t>(image.width) * image.height * 4);
+
+            pixels::read_png_rgba(image, rgba.data());
+
+            benchmark::DoNotOptimize(rgba.data());
+
+            decoded = rgba.size();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * decoded));
+    }
+
+    // Bytes processed count the output, so every kernel and instruction set compares on the same scale.
+    auto BM_RgbToRgba(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        const auto source = pattern(PIXELS * 3);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            kernels->rgb_to_rgba(source.data(), destination.data(), PIXELS);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    auto BM_GrayToRgba(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        const auto source = pattern(PIXELS);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            kernels->gray_to_rgba(source.data(), destination.data(), PIXELS);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    auto BM_GrayAlphaToRgba(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        const auto source = pattern(PIXELS * 2);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            kernels->gray_alpha_to_rgba(source.data(), destination.data(), PIXELS);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    auto BM_PremultiplyAlpha(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        auto rgba = pattern(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            kernels->premultiply_alpha(rgba.data(), PIXELS);
+            benchmark::DoNotOptimize(rgba.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * rgba.size()));
+    }
+
+    auto BM_Swizzle(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        const auto source = pattern(PIXELS * 4);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            kernels->swizzle(source.data(), destination.data(), PIXELS, { 2, 1, 0, 3 });
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    auto BM_Reduce16To8(benchmark::State& state, const pixels::Kernels* kernels) -> void
+    {
+        const auto bytes = pattern(PIXELS * 8);
+        std::vector<std::uint16_t> source(PIXELS * 4);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<std::uint16_t>(bytes[i * 2] | bytes[i * 2 + 1] << 8);
+
+        for (auto _ : state)
+        {
+            kernels->reduce_16_to_8(source.data(), destination.data(), source.size());
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    auto BM_SrgbToLinear(benchmark::State& state) -> void
+    {
+        const auto source = pattern(PIXELS * 4);
+        std::vector<std::uint16_t> destination(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            pixels::srgb_to_linear(source.data(), destination.data(), PIXELS);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+    }
+
+    auto BM_LinearToSrgb(benchmark::State& state) -> void
+    {
+        const auto bytes = pattern(PIXELS * 8);
+        std::vector<std::uint16_t> source(PIXELS * 4);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        for (size_t i = 0; i < source.size(); ++i) source[i] = static_cast<std::uint16_t>(bytes[i * 2] | bytes[i * 2 + 1] << 8);
+
+        for (auto _ : state)
+        {
+            pixels::linear_to_srgb(source.data(), destination.data(), PIXELS);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * destination.size()));
+    }
+
+    // Analysis cost decoded textures pay before upload, on pixels where every channel varies so nothing ends early.
+    auto BM_AnalyzeChannels(benchmark::State& state) -> void
+    {
+        const auto source = pattern(PIXELS * 4);
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(pixels::analyze_channels(source.data(), PIXELS));
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+    }
+
+    // RGBA8 down to the first `channels` channels, as for an R8 or RG8 upload.
+    auto BM_PackChannels(benchmark::State& state) -> void
+    {
+        const auto source = pattern(PIXELS * 4);
+        std::vector<std::uint8_t> destination(PIXELS * 4);
+
+        auto layout = pixels::ChannelLayout();
+
+        layout.channels = static_cast<size_t>(state.range(0));
+
+        for (auto _ : state)
+        {
+            pixels::pack_channels(source.data(), destination.data(), PIXELS, layout);
+            benchmark::DoNotOptimize(destination.data());
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * source.size()));
+    }
+
+    // One run per instruction set the CPU supports, and one pair of decodes per file in media/.
+    const auto registered = []
+    {
+        for (const auto kernels : pixels::available())
+        {
+            const auto suffix = std::string("/") + kernels->name;
+
+            benchmark::RegisterBenchmark(("BM_RgbToRgba" + suffix).c_str(), BM_RgbToRgba, kernels);
+            benchmark::RegisterBenchmark(("BM_GrayToRgba" + suffix).c_str(), BM_GrayToRgba, kernels);
+            benchmark::RegisterBenchmark(("BM_GrayAlphaToRgba" + suffix).c_str(), BM_GrayAlphaToRgba, kernels);
+            benchmark::RegisterBenchmark(("BM_PremultiplyAlpha" + suffix).c_str(), BM_PremultiplyAlpha, kernels);
+            benchmark::RegisterBenchmark(("BM_Swizzle" + suffix).c_str(), BM_Swizzle, kernels);
+            benchmark::RegisterBenchmark(("BM_Reduce16To8" + suffix).c_str(), BM_Reduce16To8, kernels);
+        }
+
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("media", error))
+        {
+            if (entry.path().extension() != ".png") continue;
+
+            const auto path = entry.path().generic_string();
+            const auto name = entry.path().filename().string();
+
+            benchmark::RegisterBenchmark(("BM_PngRgbaLibpng/" + name).c_str(), BM_PngRgbaLibpng, path)->Unit(benchmark::kMillisecond);
+            benchmark::RegisterBenchmark(("BM_PngRgbaKernels/" + name).c_str(), BM_PngRgbaKernels, path)->Unit(benchmark::kMillisecond);
+        }
+
+        return true;
+    }();
+}
+
+BENCHMARK(BM_SrgbToLinear);
+BENCHMARK(BM_LinearToSrgb);
+BENCHMARK(BM_AnalyzeChannels);
+BENCHMARK(BM_PackChannels)->DenseRange(1, 2)->ArgName("channels");
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <png.h>
+#include <zlib.h>
+
+namespace
+{
+    auto decode(png_image& image) -> std::vector<std::uint8_t>
+    {
+        image.format = PNG_FORMAT_RGBA;
+
+        std::vector<std::uint8_t> pixels(PNG_IMAGE_SIZE(image));
+
+        if (png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+
+        return pixels;
+    }
+
+    // RGBA gradient with a little noise, compresses roughly like the photographic textures in media/.
+    auto encode_synthetic(std::uint32_t size) -> std::vector<std::uint8_t>
+    {
+        std::vector<std::uint8_t> pixels(size_t(size) * size * 4);
+        std::uint32_t seed = 12345;
+
+        for (std::uint32_t y = 0; y < size; ++y)
+        {
+            for (std::uint32_t x = 0; x < size; ++x)
+            {
+                seed = seed * 1664525u + 1013904223u;
+
+                const auto noise = static_cast<std::uint8_t>(seed >> 28);
+                const auto pixel = &pixels[(size_t(y) * size + x) * 4];
+
+                pixel[0] = static_cast<std::uint8_t>(x * 255 / size) ^ noise;
+                pixel[1] = static_cast<std::uint8_t>(y * 255 / size) ^ noise;
+                pixel[2] = static_cast<std::uint8_t>((x + y) * 127 / size);
+                pixel[3] = 255;
+            }
+        }
+
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+        image.width = size;
+        image.height = size;
+        image.format = PNG_FORMAT_RGBA;
+
+        png_alloc_size_t encoded_size = 0;
+
+        if (png_image_write_to_memory(&image, nullptr, &encoded_size, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+        std::vector<std::uint8_t> encoded(encoded_size);
+
+        if (png_image_write_to_memory(&image, encoded.data(), &encoded_size, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+        encoded.resize(encoded_size);
+
+        return encoded;
+    }
+
+    // Same path as Material::from and load_texture: stdio read through libpng, converted to RGBA.
+    auto BM_PngDecodeFile(benchmark::State& state, const std::string& path) -> void
+    {
+        size_t decoded = 0;
+
+        for (auto _ : state)
+        {
+            png_image image = {};
+
+            image.version = PNG_IMAGE_VERSION;
+
+            if (png_image_begin_read_from_file(&image, path.c_str()) == 0) throw std::runtime_error("Failed to load image.");
+
+            const auto pixels = decode(image);
+
+            benchmark::DoNotOptimize(pixels.data());
+
+            decoded = pixels.size();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * decoded));
+        state.SetLabel(zlibVersion());
+        state.counters["file_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+        state.counters["pixels"] = static_cast<double>(decoded / 4);
+    }
+
+    auto BM_PngDecodeSynthetic(benchmark::State& state) -> void
+    {
+        const auto encoded = encode_synthetic(static_cast<std::uint32_t>(state.range(0)));
+        size_t decoded = 0;
+
+        for (auto _ : state)
+        {
+            png_image image = {};
+
+            image.version = PNG_IMAGE_VERSION;
+
+            if (png_image_begin_read_from_memory(&image, encoded.data(), encoded.size()) == 0) throw std::runtime_error("Failed to load image.");
+
+            const auto pixels = decode(image);
+
+            benchmark::DoNotOptimize(pixels.data());
+
+            decoded = pixels.size();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * decoded));
+        state.counters["file_bytes"] = static_cast<double>(encoded.size());
+    }
+
+    // Registered per file at startup, so new assets in media/ are picked up without touching this list.
+    const auto media_registered = []
+    {
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("media", error))
+        {
+            if (entry.path().extension() != ".png") continue;
+
+            const auto path = entry.path().generic_string();
+
+            benchmark::RegisterBenchmark(("BM_PngDecodeFile/" + entry.path().filename().string()).c_str(), BM_PngDecodeFile, path)
+                ->Unit(benchmark::kMillisecond);
+        }
+
+        return true;
+    }();
+}
+
+BENCHMARK(BM_PngDecodeSynthetic)->RangeMultiplier(4)->Range(64, 4096)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <GL/glew.h>
+#include <headless.hpp>
+#include <staging_ring.hpp>
+
+namespace
+{
+    constexpr size_t BATCH = 8;
+
+    // Created on first use, so runs filtering out the upload benchmarks need no EGL.
+    auto context() -> bool
+    {
+        static std::unique_ptr<HeadlessContext> headless;
+        static const auto available = []
+        {
+            try
+            {
+                headless = std::make_unique<HeadlessContext>();
+
+                return glewContextInit() == GLEW_OK;
+            }
+            catch (const std::exception&)
+            {
+                return false;
+            }
+        }();
+
+        return available;
+    }
+
+    struct Textures
+    {
+        Textures(GLsizei size):
+            names(BATCH)
+        {
+            glCreateTextures(GL_TEXTURE_2D, static_cast<GLsizei>(names.size()), names.data());
+
+            for (const auto texture : names) glTextureStorage2D(texture, 1, GL_RGBA8, size, size);
+        }
+        ~Textures()
+        {
+            glDeleteTextures(static_cast<GLsizei>(names.size()), names.data());
+        }
+
+        std::vector<GLuint> names;
+    };
+
+    auto pattern(size_t bytes) -> std::vector<std::uint8_t>
+    {
+        std::vector<std::uint8_t> pixels(bytes);
+
+        for (size_t i = 0; i < bytes; ++i) pixels[i] = static_cast<std::uint8_t>(i * 31 + (i >> 12));
+
+        return pixels;
+    }
+
+    // Both variants copy the source once per texture, standing in for the decoder writing its output,
+    // and finish a batch of uploads so the driver copies and transfers are part of the measurement.
+    auto BM_TextureUploadDirect(benchmark::State& state) -> void
+    {
+        if (!context())
+        {
+            state.SkipWithError("No headless OpenGL context.");
+
+            return;
+        }
+
+        const auto size = static_cast<GLsizei>(state.range(0));
+        const auto bytes = static_cast<size_t>(size) * size * 4;
+        const auto source = pattern(bytes);
+        const auto textures = Textures(size);
+
+        std::vector<std::uint8_t> decoded(bytes);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (auto _ : state)
+        {
+            for (const auto texture : textures.names)
+            {
+                std::memcpy(decoded.data(), source.data(), bytes);
+                glTextureSubImage2D(texture, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+            }
+
+            glFinish();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * BATCH * bytes));
+    }
+
+    auto BM_TextureUploadStaging(benchmark::State& state) -> void
+    {
+        if (!context())
+        {
+            state.SkipWithError("No headless OpenGL context.");
+
+            return;
+        }
+
+        const auto size = static_cast<GLsizei>(state.range(0));
+        const auto bytes = static_cast<size_t>(size) * size * 4;
+        const auto source = pattern(bytes);
+        const auto textures = Textures(size);
+
+        // Half a batch, so the ring wraps and waits on its fences like a long loading session would.
+        auto ring = StagingRing(bytes * BATCH / 2 + 64 * BATCH);
+
+        for (auto _ : state)
+        {
+            for (const auto texture : textures.names)
+            {
+                const auto staging = ring.allocate(bytes);
+
+                std::memcpy(staging.data, source.data(), bytes);
+                ring.upload_texture(texture, staging, size, size, GL_RGBA, GL_UNSIGNED_BYTE);
+            }
+
+            glFinish();
+        }
+
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * BATCH * bytes));
+        state.counters["fence_wait_ms"] = ring.wait_ms;
+    }
+}
+
+BENCHMARK(BM_TextureUploadDirect)->RangeMultiplier(2)->Range(256, 2048)->ArgName("size")->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TextureUploadStaging)->RangeMultiplier(2)->Range(256, 2048)->ArgName("size")->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <job_system.hpp>
+#include <scene.hpp>
+#include <synthetic_scene.hpp>
+#include <vertex_weld.hpp>
+
+namespace
+{
+    // One triangle soup mesh, three vertices per face of which the grid shares most.
+    auto soup(size_t triangles) -> std::unique_ptr<aiScene>
+    {
+        auto settings = SyntheticScene::Settings();
+
+        settings.nodes = 1;
+        settings.depth = 1;
+        settings.triangles_per_mesh = triangles;
+        settings.textures = 0;
+        settings.unwelded = true;
+
+        return SyntheticScene::generate(settings);
+    }
+
+    // The soup as a .glb, written once per size.
+    auto soup_file(size_t triangles) -> std::string
+    {
+        const auto path = (std::filesystem::temp_directory_path() / ("nutshell_weld_" + std::to_string(triangles) + ".glb")).string();
+
+        if (!std::filesystem::exists(path)) SyntheticScene::export_gltf(soup(triangles).get(), path);
+
+        return path;
+    }
+
+    auto BM_WeldVertices(benchmark::State& state) -> void
+    {
+        const auto scene = soup(static_cast<size_t>(state.range(0)));
+        const auto source = Mesh::convert(scene->mMeshes[0], nullptr, std::nullopt);
+
+        auto jobs = JobSystem(static_cast<size_t>(state.range(1)));
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+
+            auto vertices = source.vertices;
+            auto indices = source.indices;
+
+            state.ResumeTiming();
+
+            VertexWeld::weld(vertices, indices, 0.0f, &jobs);
+
+            benchmark::DoNotOptimize(vertices.data());
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * source.vertices.size()));
+    }
+
+    // Import with assimp's own welding against import followed by conversion and VertexWeld on every core,
+    // and a plain import plus conversion as the baseline both are measured against.
+    auto BM_ImportJoin(benchmark::State& state) -> void
+    {
+        const auto path = soup_file(static_cast<size_t>(state.range(0)));
+        const auto mode = state.range(1);
+
+        auto jobs = JobSystem();
+        size_t vertices = 0;
+
+        for (auto _ : state)
+        {
+            Assimp::Importer importer;
+
+            const auto scene = importer.ReadFile(path, aiProcess_Triangulate | (mode == 0 ? aiProcess_JoinIdenticalVertices : 0));
+
+            if (!scene)
+            {
+                state.SkipWithError(importer.GetErrorString());
+
+                return;
+            }
+
+            const auto converted = Mesh::convert(scene->mMeshes[0], &jobs, mode == 1 ? std::optional<float>(0.0f) : std::nullopt);
+
+            vertices = converted.vertices.size();
+
+            benchmark::DoNotOptimize(converted.vertices.data());
+        }
+
+        state.SetLabel(mode == 0 ? "assimp JoinIdenticalVertices" : mode == 1 ? "VertexWeld" : "no welding");
+        state.counters["vertices"] = static_cast<double>(vertices);
+    }
+}
+
+BENCHMARK(BM_WeldVertices)
+    ->ArgsProduct({ { 1 << 16, 1 << 20, 1 << 21 }, { 1, 2, 4, 8 } })
+    ->ArgNames({ "triangles", "threads" })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+// Argument 1: 0 assimp, 1 VertexWeld, 2 neither.
+BENCHMARK(BM_ImportJoin)
+    ->ArgsProduct({ { 1 << 16, 1 << 20 }, { 0, 1, 2 } })
+    ->ArgNames({ "triangles", "mode" })
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,226 @@
+#include "capture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#include <png.h>
+
+namespace
+{
+    auto milliseconds(Capture::Clock::time_point begin, Capture::Clock::time_point end) -> double
+    {
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    auto percentile(std::vector<double> values, double p) -> double
+    {
+        if (values.empty()) return 0.0;
+
+        std::sort(values.begin(), values.end());
+
+        const auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(values.size() - 1) + 0.5);
+
+        return values[std::min(rank, values.size() - 1)];
+    }
+}
+
+Capture::Capture():
+    started(Clock::now())
+{
+    if (const auto path = std::getenv("NUTSHELL_CAPTURE")) image_path = path;
+    if (const auto path = std::getenv("NUTSHELL_CAPTURE_METRICS")) metrics_path = path;
+    if (const auto count = std::getenv("NUTSHELL_CAPTURE_FRAMES")) frames = std::max<size_t>(1, std::stoul(count));
+}
+
+auto Capture::enabled() const -> bool
+{
+    return !image_path.empty() || !metrics_path.empty();
+}
+
+auto Capture::finished() const -> bool
+{
+    return enabled() && rendered >= frames;
+}
+
+auto Capture::hint() const -> void
+{
+    if (enabled()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+}
+
+auto Capture::frame(GLFWwindow* window) -> void
+{
+    if (!enabled() || rendered >= frames) return;
+
+    // Frame times should measure rendering, not the display refresh.
+    if (rendered == 0) glfwSwapInterval(0);
+
+    frame();
+
+    if (finished()) glfwSetWindowShouldClose(window, GLFW_TRUE);
+}
+
+auto Capture::frame() -> void
+{
+    if (!enabled() || rendered >= frames) return;
+
+    glFinish();
+
+    const auto now = Clock::now();
+
+    if (rendered == 0)
+    {
+        startup = milliseconds(started, now);
+    }
+    else
+    {
+        frame_times.push_back(milliseconds(last, now));
+    }
+
+    last = now;
+
+    if (++rendered < frames) return;
+
+    if (!image_path.empty())
+    {
+        // The samples set the viewport to the framebuffer size every frame, and unlike glfwGetFramebufferSize
+        // the query also works from a render thread.
+        GLint viewport[4];
+
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        const auto width = viewport[2];
+        const auto height = viewport[3];
+
+        std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+
+        GLint framebuffer = 0;
+
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &framebuffer);
+        glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+        image.width = width;
+        image.height = height;
+        image.format = PNG_FORMAT_RGB;
+
+        // Negative stride: OpenGL rows start at the bottom.
+        if (png_image_write_to_file(&image, image_path.c_str(), 0, pixels.data(), -width * 3, nullptr) == 0) throw std::runtime_error("Failed to write image " + image_path + ".");
+    }
+
+    if (!metrics_path.empty())
+    {
+        std::ofstream stream(metrics_path);
+
+        if (!stream) throw std::runtime_error("Failed to write metrics " + metrics_path + ".");
+
+        stream << "{\n";
+        stream << "    \"frames\": " << rendered << ",\n";
+        stream << "    \"startup_ms\": " << startup << ",\n";
+        stream << "    \"frame_ms_median\": " << percentile(frame_times, 50.0) << ",\n";
+        stream << "    \"frame_ms_p90\": " << percentile(frame_times, 90.0) << "\n";
+        stream << "}\n";
+    }
+}
+
+Surface::Surface(Capture& capture, int width, int height, const char* title):
+    capture(capture)
+{
+    if (capture.enabled())
+    {
+        headless = std::make_unique<HeadlessContext>();
+
+        // GLEW is built against GLX, so glewInit() would fail on the missing X display after loading the entry points.
+        if (glewContextInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+
+        framebuffer = std::make_unique<Framebuffer>(width, height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->framebuffer);
+
+        return;
+    }
+
+    if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    window = glfwCreateWindow(width, height, title, nullptr, nullptr);
+
+    if (!window)
+    {
+        glfwTerminate();
+
+        throw std::runtime_error("Window creation failed.");
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (glewInit() != GLEW_OK)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+
+        throw std::runtime_error("GLEW initialization failed.");
+    }
+}
+Surface::~Surface()
+{
+    if (window)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    framebuffer.reset();
+    headless.reset();
+}
+
+auto Surface::open() const -> bool
+{
+    return window ? !glfwWindowShouldClose(window) : !capture.finished();
+}
+
+auto Surface::poll() -> void
+{
+    if (window) glfwPollEvents();
+}
+
+auto Surface::size(int& width, int& height) const -> void
+{
+    if (window)
+    {
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+    else
+    {
+        width = framebuffer->width;
+        height = framebuffer->height;
+    }
+}
+
+auto Surface::key(int key) const -> bool
+{
+    return window && glfwGetKey(window, key) == GLFW_PRESS;
+}
+
+auto Surface::present() -> void
+{
+    if (window)
+    {
+        capture.frame(window);
+
+        glfwSwapBuffers(window);
+    }
+    else
+    {
+        capture.frame();
+    }
+}
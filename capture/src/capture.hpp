@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <headless.hpp>
+
+// Offscreen frame capture for the regression tests, driven by environment variables:
+//
+//     NUTSHELL_CAPTURE=<png>           read back the last frame into this file
+//     NUTSHELL_CAPTURE_METRICS=<json>  write startup and frame times
+//     NUTSHELL_CAPTURE_FRAMES=<n>      frames to render before closing the window, 60 by default
+//
+// Without them the window is shown as usual and frame() does nothing. The frame is read from the bound framebuffer,
+// the back buffer of a window or the color attachment of an offscreen one.
+struct Capture
+{
+    using Clock = std::chrono::steady_clock;
+
+    Capture();
+
+    auto enabled() const -> bool;
+    // True once the last frame was captured.
+    auto finished() const -> bool;
+    // Call before glfwCreateWindow, hides the window while capturing.
+    auto hint() const -> void;
+    // Call after drawing and before presenting the frame. Safe on a render thread.
+    auto frame() -> void;
+    // The same for a window, which is closed after the last frame.
+    auto frame(GLFWwindow* window) -> void;
+
+    std::string         image_path;
+    std::string         metrics_path;
+    size_t              frames = 60;
+    size_t              rendered = 0;
+    double              startup = 0.0;
+    std::vector<double> frame_times;
+    Clock::time_point   started;
+    Clock::time_point   last;
+};
+
+// Where a sample renders: a window with an OpenGL 4.5 core context, or while capturing an EGL headless context
+// drawing into an offscreen framebuffer of the window size, so regression runs need no display.
+struct Surface
+{
+    Surface(Capture& capture, int width, int height, const char* title);
+    Surface(const Surface&) = delete;
+    ~Surface();
+
+    auto operator=(const Surface&) -> Surface& = delete;
+
+    // False once the window is closed or the last frame is captured.
+    auto open() const -> bool;
+    auto poll() -> void;
+    auto size(int& width, int& height) const -> void;
+    // Keys are never pressed without a window.
+    auto key(int key) const -> bool;
+    // Captures the frame and shows it.
+    auto present() -> void;
+
+    Capture&                         capture;
+    GLFWwindow*                      window = nullptr;
+    std::unique_ptr<HeadlessContext> headless;
+    std::unique_ptr<Framebuffer>     framebuffer;
+};
@@ -4,6 +4,7 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <frame_pacer.hpp>
 
 int main() {
     try {
@@ -22,15 +23,22 @@ int main() {
 
         if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
 
-        while (!glfwWindowShouldClose(window))
         {
-            glfwPollEvents();
+            auto pacer = FramePacer();
 
-            glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            glFlush();
+            while (!glfwWindowShouldClose(window))
+            {
+                glfwPollEvents();
 
-            glfwSwapBuffers(window);
+                pacer.begin();
+
+                glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                glfwSwapBuffers(window);
+
+                pacer.end();
+            }
         }
 
         auto error = glGetError();
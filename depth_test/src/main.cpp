@@ -2,308 +2,748 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+#include <thread>
+#include <exception>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/type_ptr.hpp>
-#include <png.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <profiler.hpp>
+#include <gltf_scene.hpp>
+#include <scene.hpp>
+#include <asset_io_system.hpp>
+#include <job_system.hpp>
+#include <draw_list.hpp>
+#include <camera.hpp>
+#include <camera_path.hpp>
+#include <triple_buffer.hpp>
+#include <scene_streamer.hpp>
+#include <texture_manager.hpp>
+#include <virtual_texture.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
+#include <headless.hpp>
 
-struct Vertex {
-    glm::vec3 position;
-    glm::vec2 mapping;
-};
+std::string VERTEX_SHADER_SOURCE = R"(#version 450
+layout (location = 0) uniform mat4 transformation;
 
-struct Material
-{
-    static auto from(const aiScene* scene)
-    {
-        std::vector<std::shared_ptr<Material>> materials;
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inMapping;
 
-        for (size_t i = 0; i < scene->mNumMaterials; ++i)
-        {
-            const auto material = scene->mMaterials[i];
+layout (location = 0) out vec2 outMapping;
 
-            aiString path;
+void main() {
+    gl_Position = transformation * vec4(inPosition, 1);
+    outMapping = inMapping;
+}
+)";
+const char* VERTEX_SHADER_SOURCES[] = { VERTEX_SHADER_SOURCE.c_str() };
+const GLint VERTEX_SHADER_LENGTHS[] = { static_cast<GLint>(VERTEX_SHADER_SOURCE.length()) };
 
-            material->GetTexture(aiTextureType::aiTextureType_DIFFUSE, 0, &path, nullptr, nullptr, nullptr, nullptr, nullptr);
+std::string FRAGMENT_SHADER_SOURCE = R"(#version 450
+layout (binding = 0) uniform sampler2D textureColor;
 
-            if (path.length > 0)
-            {
-                const auto scene_texture = scene->GetEmbeddedTexture(path.C_Str());
-                auto file_path = std::string(scene_texture->mFilename.C_Str());
+layout (location = 0) in vec2 inMapping;
 
-                file_path = "media/" + file_path + ".png";
+layout (location = 0) out vec4 outColor;
 
-                png_image image = {};
+void main() {
+    outColor = texture(textureColor, inMapping);
+}
+)";
+const char* FRAGMENT_SHADER_SOURCES[] = { FRAGMENT_SHADER_SOURCE.c_str() };
+const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOURCE.length()) };
 
-                image.version = PNG_IMAGE_VERSION;
+// With --virtual-textures the bound texture is the material's indirection, pages come from the atlas.
+std::string VIRTUAL_FRAGMENT_SHADER_SOURCE = "#version 450\n" + VirtualTexture::glsl() + R"(
+layout (location = 0) in vec2 inMapping;
 
-                if (png_image_begin_read_from_file(&image, file_path.c_str()) == 0) throw std::runtime_error("Failed to load image.");
+layout (location = 0) out vec4 outColor;
 
-                image.format = PNG_FORMAT_RGBA;
+void main() {
+    outColor = virtualTexture(inMapping);
+}
+)";
+const char* VIRTUAL_FRAGMENT_SHADER_SOURCES[] = { VIRTUAL_FRAGMENT_SHADER_SOURCE.c_str() };
+const GLint VIRTUAL_FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(VIRTUAL_FRAGMENT_SHADER_SOURCE.length()) };
 
-                std::vector<std::uint8_t> pixels(PNG_IMAGE_SIZE(image));
 
-                if (png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+using Clock = std::chrono::steady_clock;
 
-                GLuint texture;
+auto milliseconds(Clock::time_point begin, Clock::time_point end) -> double
+{
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
 
-                glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-                glTextureStorage2D(texture, 1, GL_RGBA8, image.width, image.height);
-                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-                glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+struct Options
+{
+    static auto from(int argc, char** argv) -> Options
+    {
+        Options options;
 
-                materials.push_back(std::make_shared<Material>(texture));
-            }
-            else
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto argument = std::string(argv[i]);
+            const auto value = [&]() -> std::string
             {
-                materials.push_back(nullptr);
-            }
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument + ".");
+
+                return argv[++i];
+            };
+
+            if (argument == "--headless") options.headless = true;
+            else if (argument == "--width") options.width = std::stoi(value());
+            else if (argument == "--height") options.height = std::stoi(value());
+            else if (argument == "--frames") options.frames = std::stoul(value());
+            else if (argument == "--warmup") options.warmup = std::stoul(value());
+            else if (argument == "--record") options.record = value();
+            else if (argument == "--replay") options.replay = value();
+            else if (argument == "--rate") options.rate = std::stof(value());
+            else if (argument == "--scene") options.scene = value();
+            else if (argument == "--threads") options.threads = std::stoul(value());
+            else if (argument == "--frames-in-flight") options.frames_in_flight = std::stoul(value());
+            else if (argument == "--blocking-load") options.blocking_load = true;
+            else if (argument == "--upload-budget-mb") options.upload_budget_mb = std::stod(value());
+            else if (argument == "--upload-budget-ms") options.upload_budget_ms = std::stod(value());
+            else if (argument == "--importer") options.importer = value();
+            else if (argument == "--texture-budget-mb") options.texture_budget_mb = std::stod(value());
+            else if (argument == "--virtual-textures") options.virtual_textures = value();
+            else throw std::runtime_error("Unknown argument " + argument + ".");
         }
 
-        return materials;
+        if (options.width <= 0 || options.height <= 0) throw std::runtime_error("Resolution must be positive.");
+        if (!(options.rate > 0.0f)) throw std::runtime_error("Simulation rate must be positive.");
+        if (!options.record.empty() && !options.replay.empty()) throw std::runtime_error("Cannot record and replay at the same time.");
+        if (!options.record.empty() && options.headless) throw std::runtime_error("Recording needs a window.");
+        if (options.importer != "native" && options.importer != "assimp") throw std::runtime_error("Importer must be native or assimp.");
+        if (!(options.texture_budget_mb >= 0.0)) throw std::runtime_error("Texture budget must not be negative.");
+        if (options.texture_budget_mb > 0.0 && !options.virtual_textures.empty()) throw std::runtime_error("Cannot use a texture budget and virtual textures at the same time.");
+        if (options.texture_budget_mb > 0.0 && options.streaming()) throw std::runtime_error("A texture budget needs a scene loaded up front (--headless, --replay or --blocking-load).");
+        if (!options.virtual_textures.empty() && options.streaming()) throw std::runtime_error("Virtual textures need a scene loaded up front (--headless, --replay or --blocking-load).");
+
+        return options;
     }
 
-    Material(GLuint texture):
-        texture(texture)
+    // The interactive window streams the scene in, replays and benchmarks load it up front to stay deterministic.
+    auto streaming() const -> bool
     {
+        return !headless && replay.empty() && !blocking_load;
     }
 
-    GLuint texture;
+    bool   headless = false;
+    int    width    = 1024;
+    int    height   = 1024;
+    size_t frames   = 300;
+    size_t warmup   = 10;
+    size_t threads  = 0;
+    size_t frames_in_flight = 0;
+    bool   blocking_load    = false;
+    double upload_budget_mb = 16.0;
+    double upload_budget_ms = 2.0;
+    // Texture memory limit of scenes loaded up front, 0 uploads every texture at full size.
+    double texture_budget_mb = 0.0;
+    // Tiled cache file of the scene's textures, built when missing or stale. Empty for regular textures.
+    std::string virtual_textures;
+
+    std::string scene = "media/room.gltf";
+    // native reads .gltf and .glb with GltfScene, other formats always go through assimp.
+    std::string importer = "native";
+    std::string record;
+    std::string replay;
+    float       rate = 60.0f;
 };
 
-struct Mesh
+auto draw(GLuint program, GLuint sampler, DrawList& draw_list, GLsizei width, GLsizei height, const Camera& camera, TextureManager* textures, VirtualTexture* virtual_texture) -> size_t
 {
-    static auto from(const aiMesh* source, const std::vector<std::shared_ptr<Material>>& materials)
-    {
-        auto vertices = std::vector<Vertex>(source->mNumVertices);
+    const auto aspect = static_cast<float>(width) / static_cast<float>(height);
 
-        for (size_t i = 0; i < source->mNumVertices; ++i) {
-            const auto position = source->mVertices[i];
-            const auto mapping = source->mTextureCoords[0][i];
+    if (textures) textures->update();
 
-            vertices[i] = {
-                { position.x, position.y, position.z },
-                { mapping.x, 1.0f - mapping.y },
-            };
-        }
+    draw_list.build(camera.view_projection(aspect), textures ? textures->frame : 0, glm::vec2(width, height));
 
-        GLuint vertex_buffer;
+    if (virtual_texture) virtual_texture->update(draw_list, width, height);
 
-        glCreateBuffers(1, &vertex_buffer);
-        glNamedBufferStorage(vertex_buffer, sizeof(Vertex) * vertices.size(), vertices.data(), 0);
+    glViewport(0, 0, width, height);
+    glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
+    glClearDepth(1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glUseProgram(program);
+    glValidateProgram(program);
 
-        auto indices = std::vector<std::uint32_t>(source->mNumFaces * 3);
+    GLint validateStatus;
 
-        for (size_t i = 0; i < source->mNumFaces; ++i)
-        {
-            indices[i*3 + 0] = source->mFaces[i].mIndices[0];
-            indices[i*3 + 1] = source->mFaces[i].mIndices[1];
-            indices[i*3 + 2] = source->mFaces[i].mIndices[2];
-        }
+    glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
 
-        GLuint index_buffer;
+    if (validateStatus != GL_TRUE) {
+        GLint size = 0;
 
-        glCreateBuffers(1, &index_buffer);
-        glNamedBufferStorage(index_buffer, sizeof(decltype(indices)::value_type) * indices.size(), indices.data(), 0);
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
 
-        GLuint vertex_arrays;
+        std::string log;
 
-        glCreateVertexArrays(1, &vertex_arrays);
-        glVertexArrayVertexBuffer(vertex_arrays, 0, vertex_buffer, 0, sizeof(Vertex));
+        log.resize(size);
+        glGetProgramInfoLog(program, size, &size, log.data());
 
-        glVertexArrayAttribBinding(vertex_arrays, 0, 0);
-        glVertexArrayAttribFormat(vertex_arrays, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
-        glEnableVertexArrayAttrib(vertex_arrays, 0);
+        throw std::runtime_error(log);
+    }
 
-        glVertexArrayAttribBinding(vertex_arrays, 1, 0);
-        glVertexArrayAttribFormat(vertex_arrays, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, mapping));
-        glEnableVertexArrayAttrib(vertex_arrays, 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindSampler(0, sampler);
 
-        glVertexArrayElementBuffer(vertex_arrays, index_buffer);
+    if (virtual_texture) glBindTextureUnit(VirtualTexture::ATLAS_UNIT, virtual_texture->atlas);
 
-        const auto material = source->mMaterialIndex < materials.size() ? materials[source->mMaterialIndex] : nullptr;
+    return draw_list.submit(program);
+}
 
-        return std::make_shared<Mesh>(vertex_buffer, index_buffer, vertex_arrays, indices.size(), material);
+// Peak resident set of the process so far, 0 where unknown.
+auto peak_rss_mb() -> double
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0.0;
+
+    return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+    rusage usage = {};
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+// Texture memory of the scene in the formats picked from the image contents, next to RGBA8 for all of them.
+auto print_texture_memory() -> void
+{
+    const auto& memory = Material::memory();
+    const auto rgba8 = static_cast<double>(memory.rgba8.load()) / (1024.0 * 1024.0);
+    const auto stored = static_cast<double>(memory.stored.load()) / (1024.0 * 1024.0);
+
+    std::cout << "    \"texture_mb\": { \"textures\": " << memory.textures.load() << ", \"rgba8\": " << rgba8 << ", \"stored\": " << stored << ", \"saved\": " << rgba8 - stored << " },\n";
+}
+
+// Last frame of the texture budget and the totals since start, nothing without a budget.
+auto print_texture_budget(const TextureManager* textures) -> void
+{
+    if (!textures) return;
+
+    const auto& stats = textures->stats;
+    const auto megabytes = [](size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+    std::cout << "    \"texture_budget\": { ";
+    std::cout << "\"budget_mb\": " << megabytes(stats.budget) << ", ";
+    std::cout << "\"resident_mb\": " << megabytes(stats.resident_bytes) << ", ";
+    std::cout << "\"resident\": " << stats.resident << ", ";
+    std::cout << "\"missing\": " << stats.missing << ", ";
+    std::cout << "\"loads\": " << textures->loads_total << ", ";
+    std::cout << "\"evictions\": " << textures->evictions_total << ", ";
+    std::cout << "\"downscaled\": " << textures->downscales_total << ", ";
+    std::cout << "\"refined\": " << textures->refines_total << ", ";
+    std::cout << "\"coarsened\": " << textures->coarsens_total << ", ";
+    std::cout << "\"levels_streamed\": " << textures->streamed_total << ", ";
+    std::cout << "\"update_ms_max\": " << textures->update_ms_max << " },\n";
+}
+
+// Last frame of the virtual textures and the totals since start, nothing without them.
+auto print_virtual_textures(const VirtualTexture* virtual_texture) -> void
+{
+    if (!virtual_texture) return;
+
+    const auto& stats = virtual_texture->stats;
+    const auto megabytes = [](size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+    std::cout << "    \"virtual_textures\": { ";
+    std::cout << "\"cache_mb\": " << megabytes(virtual_texture->cache_bytes()) << ", ";
+    std::cout << "\"atlas_mb\": " << megabytes(virtual_texture->atlas_bytes()) << ", ";
+    std::cout << "\"resident_pages\": " << stats.resident << ", ";
+    std::cout << "\"requested_pages\": " << stats.requested << ", ";
+    std::cout << "\"loads\": " << virtual_texture->loads_total << ", ";
+    std::cout << "\"evictions\": " << virtual_texture->evictions_total << ", ";
+    std::cout << "\"readbacks\": " << virtual_texture->readbacks_total << ", ";
+    std::cout << "\"dropped_readbacks\": " << virtual_texture->dropped_total << ", ";
+    std::cout << "\"update_ms_max\": " << virtual_texture->update_ms_max << " },\n";
+}
+
+auto percentile(const std::vector<double>& sorted, double p) -> double
+{
+    if (sorted.empty()) return 0.0;
+
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+auto benchmark(const Options& options, Capture& capture, GLuint program, GLuint sampler, DrawList& draw_list, TextureManager* textures, VirtualTexture* virtual_texture, const std::vector<std::pair<std::string, double>>& startup) -> void
+{
+    std::vector<Camera> cameras;
+
+    if (options.replay.empty())
+    {
+        for (size_t i = 0; i < options.frames; ++i) cameras.push_back(Camera::scripted(i, options.frames));
     }
-    static auto from(const aiScene* source, const std::vector<std::shared_ptr<Material>>& materials)
+    else
     {
-        std::vector<std::shared_ptr<Mesh>> meshes;
+        cameras = CameraPath::load(options.replay).cameras();
+    }
 
-        for (size_t i = 0; i < source->mNumMeshes; ++i)
-        {
-            meshes.push_back(Mesh::from(source->mMeshes[i], materials));
-        }
+    if (cameras.empty()) throw std::runtime_error("Nothing to render.");
+
+    const auto framebuffer = Framebuffer(options.width, options.height);
 
-        return meshes;
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer.framebuffer);
+
+    for (size_t i = 0; i < options.warmup; ++i)
+    {
+        draw(program, sampler, draw_list, framebuffer.width, framebuffer.height, cameras.front(), textures, virtual_texture);
     }
 
-    Mesh(
-        GLuint vertex_buffer,
-        GLuint index_buffer,
-        GLuint vertex_arrays,
-        size_t indices_count,
-        std::shared_ptr<Material> material
-    ):
-        vertex_buffer(vertex_buffer),
-        index_buffer(index_buffer),
-        vertex_arrays(vertex_arrays),
-        indices_count(indices_count),
-        material(material)
+    glFinish();
+
+    std::vector<double> frame_times;
+    size_t draws = 0;
+
+    frame_times.reserve(cameras.size());
+
+    for (const auto& camera : cameras)
+    {
+        PROFILE_SCOPE("frame");
+
+        const auto begin = Clock::now();
+
+        draws = draw(program, sampler, draw_list, framebuffer.width, framebuffer.height, camera, textures, virtual_texture);
+
+        glFinish();
+
+        frame_times.push_back(milliseconds(begin, Clock::now()));
+
+        capture.frame();
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    auto sorted = frame_times;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    auto mean = 0.0;
+
+    for (const auto time : frame_times) mean += time;
+
+    if (!frame_times.empty()) mean /= static_cast<double>(frame_times.size());
+
+    std::cout << "{\n";
+    std::cout << "    \"renderer\": \"" << reinterpret_cast<const char*>(glGetString(GL_RENDERER)) << "\",\n";
+    std::cout << "    \"width\": " << framebuffer.width << ",\n";
+    std::cout << "    \"height\": " << framebuffer.height << ",\n";
+    std::cout << "    \"frames\": " << cameras.size() << ",\n";
+    std::cout << "    \"draws_per_frame\": " << draws << ",\n";
+    std::cout << "    \"draw_list_threads\": " << draw_list.threads() << ",\n";
+    std::cout << "    \"startup_ms\": {";
+
+    for (size_t i = 0; i < startup.size(); ++i)
     {
+        std::cout << (i > 0 ? ", " : " ") << "\"" << startup[i].first << "\": " << startup[i].second;
     }
 
-    GLuint vertex_buffer;
-    GLuint index_buffer;
-    GLuint vertex_arrays;
-    size_t indices_count;
-    std::shared_ptr<Material> material;
+    std::cout << " },\n";
+    std::cout << "    \"peak_rss_mb\": " << peak_rss_mb() << ",\n";
+    print_texture_memory();
+    print_texture_budget(textures);
+    print_virtual_textures(virtual_texture);
+    std::cout << "    \"frame_ms\": { ";
+    std::cout << "\"mean\": " << mean << ", ";
+    std::cout << "\"min\": " << (sorted.empty() ? 0.0 : sorted.front()) << ", ";
+    std::cout << "\"p50\": " << percentile(sorted, 50.0) << ", ";
+    std::cout << "\"p90\": " << percentile(sorted, 90.0) << ", ";
+    std::cout << "\"p95\": " << percentile(sorted, 95.0) << ", ";
+    std::cout << "\"p99\": " << percentile(sorted, 99.0) << ", ";
+    std::cout << "\"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << " }\n";
+    std::cout << "}" << std::endl;
+}
+
+// Immutable snapshot handed from the update thread to the render thread.
+struct FrameState
+{
+    Camera            camera;
+    int               width  = 0;
+    int               height = 0;
+    Clock::time_point sampled;
 };
 
-struct Node
+// Lockstep, one simulation tick per rendered frame: every replay renders the same views.
+auto replay(const Options& options, GLFWwindow* window, Capture& capture, GLuint program, GLuint sampler, DrawList& draw_list, TextureManager* textures, VirtualTexture* virtual_texture) -> void
 {
-    static auto from(const aiNode* source, const std::vector<std::shared_ptr<Mesh>>& source_meshes, const std::shared_ptr<Node>& parent = nullptr) -> std::shared_ptr<Node>
+    const auto path = CameraPath::load(options.replay);
+
+    auto camera = path.start;
+    auto pacer = options.frames_in_flight > 0 ? FramePacer(options.frames_in_flight) : FramePacer();
+
+    for (std::uint32_t tick = 0; tick < path.ticks && !glfwWindowShouldClose(window); ++tick)
     {
-        std::vector<std::shared_ptr<Mesh>> meshes;
+        PROFILE_SCOPE("frame");
 
-        for (size_t i = 0; i < source->mNumMeshes; ++i)
         {
-            meshes.push_back(source_meshes[source->mMeshes[i]]);
+            PROFILE_SCOPE("glfwPollEvents");
+
+            glfwPollEvents();
         }
 
-        auto m = source->mTransformation;
-        auto transformation = glm::transpose(glm::mat4(
-            +m.a1, +m.a2, +m.a3, +m.a4,
-            +m.b1, +m.b2, +m.b3, +m.b4,
-            +m.c1, +m.c2, +m.c3, +m.c4,
-            +m.d1, +m.d2, +m.d3, +m.d4
-        ));
+        pacer.begin();
+
+        camera.update(path.input(tick), path.step());
 
-        if (parent) transformation = parent->transformation * transformation;
+        int width, height;
 
-        auto node = std::make_shared<Node>(meshes, transformation);
+        glfwGetFramebufferSize(window, &width, &height);
+
+        draw(program, sampler, draw_list, width, height, camera, textures, virtual_texture);
+
+        capture.frame(window);
 
-        for (size_t i = 0; i < source->mNumChildren; ++i)
         {
-            node->children.push_back(Node::from(source->mChildren[i], source_meshes, node));
+            PROFILE_SCOPE("glfwSwapBuffers");
+
+            glfwSwapBuffers(window);
         }
 
-        return node;
+        pacer.end();
     }
-    static auto from(const aiScene* scene)
-    {
-        auto materials = Material::from(scene);
-        auto meshes = Mesh::from(scene, materials);
+}
 
-        return Node::from(scene->mRootNode, meshes);
-    }
+// Events and the fixed-rate simulation stay on the main thread (GLFW requires it), rendering moves to its own
+// thread with the context. A slow frame no longer delays input, the renderer just picks up the newest snapshot.
+// With a streamer the scene starts empty and fills in as the loader thread finishes uploads.
+auto interactive(const Options& options, GLFWwindow* window, Capture& capture, JobSystem& jobs, GLuint program, GLuint sampler, const std::shared_ptr<Node>& root, TextureManager* textures, VirtualTexture* virtual_texture, SceneStreamer* streamer, Clock::time_point launched) -> void
+{
+    auto path = CameraPath{ options.rate };
+    auto frames = TripleBuffer<FrameState>();
+    auto state = FrameState{ path.start };
 
-    Node(
-        const std::vector<std::shared_ptr<Mesh>>& meshes,
-        const glm::mat4& transformation
-    ):
-        meshes(meshes),
-        transformation(transformation)
-    {
-    }
+    glfwGetFramebufferSize(window, &state.width, &state.height);
+    state.sampled = Clock::now();
+    frames.write() = state;
+    frames.publish();
+
+    std::vector<double> latencies;
+    std::exception_ptr failure;
+    auto render_busy = 0.0;
+    auto update_busy = 0.0;
+    size_t ticks = 0;
+    auto pacer = options.frames_in_flight > 0 ? FramePacer(options.frames_in_flight) : FramePacer();
+    auto first_frame = Clock::time_point();
+
+    glfwMakeContextCurrent(nullptr);
 
-    auto render(GLuint program, const glm::mat4& vp) -> void
+    const auto started = Clock::now();
+
+    auto render = std::thread([&]
     {
-        glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, glm::value_ptr(vp * transformation));
+        PROFILE_THREAD("render");
+
+        glfwMakeContextCurrent(window);
 
-        for (const auto &mesh : meshes)
+        try
         {
-            glActiveTexture(GL_TEXTURE0);
+            const auto empty = Node({}, glm::mat4(1.0f));
 
-            if (mesh->material)
-            {
-                glBindTexture(GL_TEXTURE_2D, mesh->material->texture);
-            }
-            else
+            auto draw_list = std::make_unique<DrawList>(root ? *root : empty, jobs);
+
+            while (!glfwWindowShouldClose(window))
             {
-                glBindTexture(GL_TEXTURE_2D, 0);
+                {
+                    PROFILE_SCOPE("frame pacing");
+
+                    pacer.begin();
+                }
+
+                if (streamer && streamer->adopt()) draw_list = std::make_unique<DrawList>(*streamer->root, jobs);
+
+                const auto fresh = frames.update();
+                const auto& frame = frames.read();
+                const auto begin = Clock::now();
+
+                {
+                    PROFILE_SCOPE("frame");
+
+                    draw(program, sampler, *draw_list, frame.width, frame.height, frame.camera, textures, virtual_texture);
+
+                    capture.frame(window);
+                }
+
+                render_busy += milliseconds(begin, Clock::now());
+
+                {
+                    PROFILE_SCOPE("glfwSwapBuffers");
+
+                    glfwSwapBuffers(window);
+                }
+
+                pacer.end();
+
+                if (first_frame == Clock::time_point()) first_frame = Clock::now();
+
+                if (fresh) latencies.push_back(milliseconds(frame.sampled, Clock::now()));
             }
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
 
-            glBindVertexArray(mesh->vertex_arrays);
-            glDrawElements(GL_TRIANGLES, mesh->indices_count, GL_UNSIGNED_INT, 0);
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
         }
 
-        for (const auto &child : children)
+        glfwMakeContextCurrent(nullptr);
+    });
+
+    const auto step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(path.step()));
+    auto next = started;
+
+    while (!glfwWindowShouldClose(window))
+    {
+        auto end = Clock::now();
+
         {
-            child->render(program, vp);
+            PROFILE_SCOPE("update");
+
+            const auto begin = Clock::now();
+
+            {
+                PROFILE_SCOPE("glfwPollEvents");
+
+                glfwPollEvents();
+            }
+
+            std::uint8_t input = 0;
+
+            if (glfwGetKey(window, GLFW_KEY_UP)) input |= CAMERA_INPUT_UP;
+            if (glfwGetKey(window, GLFW_KEY_DOWN)) input |= CAMERA_INPUT_DOWN;
+            if (glfwGetKey(window, GLFW_KEY_RIGHT)) input |= CAMERA_INPUT_RIGHT;
+            if (glfwGetKey(window, GLFW_KEY_LEFT)) input |= CAMERA_INPUT_LEFT;
+
+            if (!options.record.empty()) path.record(input);
+
+            state.camera.update(input, path.step());
+            glfwGetFramebufferSize(window, &state.width, &state.height);
+            state.sampled = begin;
+
+            frames.write() = state;
+            frames.publish();
+
+            ++ticks;
+
+            end = Clock::now();
+
+            update_busy += milliseconds(begin, end);
         }
+
+        // Ticks missed after a stall are dropped rather than replayed in a burst.
+        next = std::max(next + step, end);
+
+        std::this_thread::sleep_until(next);
     }
 
-    std::vector<std::shared_ptr<Mesh>> meshes;
-    std::vector<std::shared_ptr<Node>> children;
-    glm::mat4                          transformation;
-};
+    render.join();
 
-std::string VERTEX_SHADER_SOURCE = R"(#version 450
-layout (location = 0) uniform mat4 transformation;
+    glfwMakeContextCurrent(window);
 
-layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec2 inMapping;
+    if (failure) std::rethrow_exception(failure);
 
-layout (location = 0) out vec2 outMapping;
+    if (!options.record.empty()) path.save(options.record);
 
-void main() {
-    gl_Position = transformation * vec4(inPosition, 1);
-    outMapping = inMapping;
-}
-)";
-const char* VERTEX_SHADER_SOURCES[] = { VERTEX_SHADER_SOURCE.c_str() };
-const GLint VERTEX_SHADER_LENGTHS[] = { static_cast<GLint>(VERTEX_SHADER_SOURCE.length()) };
+    const auto elapsed = milliseconds(started, Clock::now());
 
-std::string FRAGMENT_SHADER_SOURCE = R"(#version 450
-layout (binding = 0) uniform sampler2D textureColor;
+    auto sorted = latencies;
 
-layout (location = 0) in vec2 inMapping;
+    std::sort(sorted.begin(), sorted.end());
 
-layout (location = 0) out vec4 outColor;
+    auto mean = 0.0;
 
-void main() {
-    outColor = texture(textureColor, inMapping);
+    for (const auto latency : latencies) mean += latency;
+
+    if (!latencies.empty()) mean /= static_cast<double>(latencies.size());
+
+    std::cout << "{\n";
+    std::cout << "    \"frames\": " << pacer.frame << ",\n";
+    std::cout << "    \"ticks\": " << ticks << ",\n";
+    std::cout << "    \"first_frame_ms\": " << milliseconds(launched, first_frame) << ",\n";
+
+    if (!streamer) std::cout << "    \"complete_ms\": " << milliseconds(launched, first_frame) << ",\n";
+    else if (streamer->complete()) std::cout << "    \"complete_ms\": " << milliseconds(launched, streamer->completed) << ",\n";
+    else std::cout << "    \"complete_ms\": null,\n";
+
+    std::cout << "    \"input_latency_ms\": { ";
+    std::cout << "\"mean\": " << mean << ", ";
+    std::cout << "\"p50\": " << percentile(sorted, 50.0) << ", ";
+    std::cout << "\"p99\": " << percentile(sorted, 99.0) << ", ";
+    std::cout << "\"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << " },\n";
+    std::cout << "    \"utilization\": { ";
+    std::cout << "\"update\": " << (elapsed > 0.0 ? update_busy / elapsed : 0.0) << ", ";
+    std::cout << "\"render\": " << (elapsed > 0.0 ? render_busy / elapsed : 0.0) << " },\n";
+    print_texture_memory();
+    print_texture_budget(textures);
+    print_virtual_textures(virtual_texture);
+    std::cout << "    \"frames_in_flight\": " << pacer.frames_in_flight << ",\n";
+    std::cout << "    \"fence_wait_ms\": { \"mean\": " << pacer.wait_ms_mean() << ", \"max\": " << pacer.wait_ms_max << " }\n";
+    std::cout << "}" << std::endl;
 }
-)";
-const char* FRAGMENT_SHADER_SOURCES[] = { FRAGMENT_SHADER_SOURCE.c_str() };
-const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOURCE.length()) };
 
-int main() {
+int main(int argc, char** argv) {
+    auto options = Options();
+
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        PROFILE_THREAD("main");
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        auto capture = Capture();
 
-        const auto window = glfwCreateWindow(1024, 1024, "Depth Test", nullptr, nullptr);
+        options = Options::from(argc, argv);
 
-        if (!window) throw std::runtime_error("Window creation failed.");
+        // Shared by texture decoding and the per-frame draw list build.
+        auto jobs = JobSystem(options.threads);
 
-        glfwMakeContextCurrent(window);
+        const auto started = Clock::now();
+        auto startup = std::vector<std::pair<std::string, double>>();
+        auto phase = [&, last = started](const char* name) mutable
+        {
+            const auto now = Clock::now();
+
+            startup.emplace_back(name, milliseconds(last, now));
+            last = now;
+        };
 
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        std::unique_ptr<HeadlessContext> headless;
+        GLFWwindow* window = nullptr;
 
-        Assimp::Importer importer;
+        if (options.headless)
+        {
+            PROFILE_SCOPE("EGL context");
 
-        const auto scene = importer.ReadFile("media/room.gltf", aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+            headless = std::make_unique<HeadlessContext>();
 
-        auto root = Node::from(scene);
+            // GLEW is built against GLX, so glewInit() would fail on the missing X display after loading the entry points.
+            if (glewContextInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        }
+        else
+        {
+            if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
 
-        const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            capture.hint();
 
-        glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
-        glCompileShader(vertexShader);
+            window = glfwCreateWindow(1024, 1024, "Depth Test", nullptr, nullptr);
+
+            if (!window) throw std::runtime_error("Window creation failed.");
+
+            glfwMakeContextCurrent(window);
+
+            if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        }
+
+        phase("context");
+
+        const auto streaming = options.streaming();
+
+        std::shared_ptr<Node> root;
+        std::unique_ptr<TextureManager> textures;
+
+        if (options.texture_budget_mb > 0.0)
+        {
+            textures = std::make_unique<TextureManager>(static_cast<size_t>(options.texture_budget_mb * 1024.0 * 1024.0), &jobs);
+        }
+
+        std::unique_ptr<VirtualTexture> virtual_texture;
+
+        if (!options.virtual_textures.empty())
+        {
+            virtual_texture = std::make_unique<VirtualTexture>(options.virtual_textures, &jobs);
+        }
+
+        if (!streaming)
+        {
+            const auto extension = std::filesystem::path(options.scene).extension();
+
+            if (options.importer == "native" && (extension == ".gltf" || extension == ".glb"))
+            {
+                const auto scene = GltfScene::load(options.scene, &jobs);
+
+                phase("import");
+
+                if (textures) root = Node::from(scene, textures->materials(scene), &jobs);
+                else if (virtual_texture) root = Node::from(scene, virtual_texture->materials(scene), &jobs);
+                else root = Node::from(scene, &jobs);
+
+                phase("scene");
+            }
+            else
+            {
+                Assimp::Importer importer;
+
+                importer.SetIOHandler(new AssetIOSystem());
+
+                const aiScene* scene;
+
+                {
+                    PROFILE_SCOPE("assimp import");
+
+                    scene = importer.ReadFile(options.scene, aiProcess_Triangulate);
+                }
+
+                if (!scene) throw std::runtime_error(importer.GetErrorString());
+
+                phase("import");
+
+                const auto directory = std::filesystem::path(options.scene).parent_path();
+
+                if (textures) root = Node::from(scene, textures->materials(scene, directory), &jobs);
+                else if (virtual_texture) root = Node::from(scene, virtual_texture->materials(scene, directory), &jobs);
+                else root = Node::from(scene, directory, &jobs);
+
+                phase("scene");
+            }
+        }
+
+        const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
 
         GLint vertexShaderCompileStatus;
 
-        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        {
+            PROFILE_SCOPE("vertex shader compile");
+
+            glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
+            glCompileShader(vertexShader);
+            glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        }
 
         if (vertexShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -320,12 +760,16 @@ int main() {
 
         const auto fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-        glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
-        glCompileShader(fragmentShader);
-
         GLint fragmentShaderCompileStatus;
 
-        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        {
+            PROFILE_SCOPE("fragment shader compile");
+
+            if (virtual_texture) glShaderSource(fragmentShader, 1, VIRTUAL_FRAGMENT_SHADER_SOURCES, VIRTUAL_FRAGMENT_SHADER_LENGTHS);
+            else glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
+            glCompileShader(fragmentShader);
+            glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        }
 
         if (fragmentShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -342,13 +786,16 @@ int main() {
 
         const auto program = glCreateProgram();
 
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, fragmentShader);
-        glLinkProgram(program);
-
         GLint linkStatus;
 
-        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        {
+            PROFILE_SCOPE("program link");
+
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        }
 
         if (linkStatus != GL_TRUE) {
             GLint size = 0;
@@ -370,98 +817,59 @@ int main() {
 
         glCreateSamplers(1, &sampler);
         glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        // The budget keeps a chain of coarser levels under the base, which only a mipmapped filter reads.
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, textures ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        float x = glm::radians(30.0f);
-        float y = glm::radians(45.0f);
-
-        while (!glfwWindowShouldClose(window))
-        {
-            glfwPollEvents();
-
-            if (glfwGetKey(window, GLFW_KEY_UP)) x += glm::radians(1.0f);
-            if (glfwGetKey(window, GLFW_KEY_DOWN)) x -= glm::radians(1.0f);
-            if (glfwGetKey(window, GLFW_KEY_RIGHT)) y += glm::radians(1.0f);
-            if (glfwGetKey(window, GLFW_KEY_LEFT)) y -= glm::radians(1.0f);
-
-            int width, height;
+        phase("program");
 
-            glfwGetFramebufferSize(window, &width, &height);
+        startup.emplace_back("total", milliseconds(started, Clock::now()));
 
-            glViewport(0, 0, width, height);
-            glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
-            glClearDepth(1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
-            glFrontFace(GL_CCW);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glEnable(GL_DEPTH_TEST);
-            glDepthFunc(GL_LESS);
-            glUseProgram(program);
-
-            GLint validateStatus;
-
-            glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
+        if (options.headless)
+        {
+            auto draw_list = DrawList(*root, jobs);
 
-            if (validateStatus != GL_TRUE) {
-                GLint size = 0;
+            benchmark(options, capture, program, sampler, draw_list, textures.get(), virtual_texture.get(), startup);
+        }
+        else if (!options.replay.empty())
+        {
+            auto draw_list = DrawList(*root, jobs);
 
-                glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+            replay(options, window, capture, program, sampler, draw_list, textures.get(), virtual_texture.get());
+        }
+        else if (streaming)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-                std::string log;
+            const auto loader = glfwCreateWindow(1, 1, "Depth Test Loader", nullptr, window);
 
-                log.resize(size);
-                glGetProgramInfoLog(program, size, &size, log.data());
+            if (!loader) throw std::runtime_error("Loader context creation failed.");
 
-                throw std::runtime_error(log);
+            {
+                auto streamer = SceneStreamer(
+                    options.scene,
+                    options.importer,
+                    &jobs,
+                    [loader] { glfwMakeContextCurrent(loader); },
+                    [] { glfwMakeContextCurrent(nullptr); },
+                    { options.upload_budget_mb, options.upload_budget_ms }
+                );
+
+                interactive(options, window, capture, jobs, program, sampler, nullptr, nullptr, nullptr, &streamer, started);
             }
 
-            auto rx = glm::transpose(glm::mat3(
-                +1.0f, +0.0f,         +0.0f,
-                +0.0f, +glm::cos(-x), +glm::sin(-x),
-                +0.0f, -glm::sin(-x), +glm::cos(-x)
-            ));
-            auto ry = glm::transpose(glm::mat3(
-                +glm::cos(-y), +0.0f, -glm::sin(-y),
-                +0.0f,         +1.0f, +0.0f,
-                +glm::sin(-y), +0.0f, +glm::cos(-y)
-            ));
-            auto t = glm::transpose(glm::mat3x4(
-                +1.0f, +0.0f, +0.0f, +0.0f,
-                +0.0f, +1.0f, +0.0f, -0.5f,
-                +0.0f, +0.0f, +1.0f, -3.0f
-            ));
-
-            glm::mat4 view = glm::mat4(t) * glm::mat4(rx) * glm::mat4(ry);
-
-            const auto aspect = static_cast<float>(width) / static_cast<float>(height);
-            const auto fov = glm::radians(60.0f);
-            const auto z_near = 0.01f;
-            const auto z_far = 100.0f;
-
-            glm::mat4 projection = glm::transpose(glm::mat4(
-                aspect / glm::cos(fov / 2.0f), 0.0f,                        0.0f,                             0.0f,
-                0.0f,                          1.0f / glm::cos(fov / 2.0f), 0.0f,                             0.0f,
-                0.0f,                          0.0f,                        -(z_far*z_near)/(z_far - z_near), -(2.0f*z_far*z_near)/(z_far - z_near),
-                0.0f,                          0.0f,                        -1.0f,                            0.0f
-            ));
-
-            const auto view_projection = projection * view;
-
-            glActiveTexture(GL_TEXTURE0);
-            glBindSampler(0, sampler);
-
-            root->render(program, view_projection);
-
-            glFlush();
-
-            glfwSwapBuffers(window);
+            glfwDestroyWindow(loader);
+        }
+        else
+        {
+            interactive(options, window, capture, jobs, program, sampler, root, textures.get(), virtual_texture.get(), nullptr, started);
         }
 
+        // Their textures go while the context is still current.
+        textures.reset();
+        virtual_texture.reset();
+
         // glDeleteSamplers(1, &sampler);
         // glDeleteTextures(1, &texture);
         // glDeleteProgram(program);
@@ -483,8 +891,13 @@ int main() {
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        PROFILE_WRITE("depth_test.trace.json");
+
+        if (window)
+        {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;
@@ -492,7 +905,7 @@ int main() {
         throw;
     }
 
-    std::cout << "done" << std::endl;
+    if (!options.headless) std::cout << "done" << std::endl;
 
     return 0;
 }
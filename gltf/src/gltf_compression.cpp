@@ -0,0 +1,122 @@
+#include "gltf_compression.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <meshoptimizer.h>
+#include <profiler.hpp>
+
+#if defined(GLTF_DRACO)
+#include <draco/compression/decode.h>
+#endif
+
+auto GltfCompression::decode(const MeshoptView& view, std::uint8_t* destination) -> void
+{
+    PROFILE_SCOPE("meshopt decode");
+
+    // meshoptimizer picks its SSSE3, AVX-512 or NEON decoders at runtime.
+    auto result = 0;
+
+    switch (view.mode)
+    {
+        case Mode::ATTRIBUTES:
+            result = meshopt_decodeVertexBuffer(destination, view.count, view.stride, view.source, view.size);
+
+            break;
+        case Mode::TRIANGLES:
+            result = meshopt_decodeIndexBuffer(destination, view.count, view.stride, view.source, view.size);
+
+            break;
+        case Mode::INDICES:
+            result = meshopt_decodeIndexSequence(destination, view.count, view.stride, view.source, view.size);
+
+            break;
+    }
+
+    if (result != 0) throw std::runtime_error("Malformed EXT_meshopt_compression data (error " + std::to_string(result) + ").");
+
+    switch (view.filter)
+    {
+        case Filter::NONE:        break;
+        case Filter::OCTAHEDRAL:  meshopt_decodeFilterOct(destination, view.count, view.stride); break;
+        case Filter::QUATERNION:  meshopt_decodeFilterQuat(destination, view.count, view.stride); break;
+        case Filter::EXPONENTIAL: meshopt_decodeFilterExp(destination, view.count, view.stride); break;
+    }
+}
+
+auto GltfCompression::draco_available() -> bool
+{
+#if defined(GLTF_DRACO)
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto GltfCompression::decode_draco(const std::uint8_t* data, size_t size, int position, int mapping) -> DracoMesh
+{
+#if defined(GLTF_DRACO)
+    PROFILE_SCOPE("draco decode");
+
+    draco::DecoderBuffer buffer;
+
+    buffer.Init(reinterpret_cast<const char*>(data), size);
+
+    draco::Decoder decoder;
+
+    auto decoded = decoder.DecodeMeshFromBuffer(&buffer);
+
+    if (!decoded.ok()) throw std::runtime_error("Malformed KHR_draco_mesh_compression data: " + decoded.status().error_msg_string() + ".");
+
+    const auto source = std::move(decoded).value();
+
+    auto mesh = DracoMesh();
+
+    mesh.vertices = static_cast<size_t>(source->num_points());
+
+    // Attributes are stored once per distinct value, points map onto them.
+    const auto read = [&](int id, int components, std::vector<std::uint8_t>& output)
+    {
+        const auto attribute = source->GetAttributeByUniqueId(static_cast<std::uint32_t>(id));
+
+        if (!attribute) throw std::runtime_error("KHR_draco_mesh_compression attribute " + std::to_string(id) + " is missing.");
+
+        output.resize(mesh.vertices * components * sizeof(float));
+
+        for (size_t i = 0; i < mesh.vertices; ++i)
+        {
+            const auto index = attribute->mapped_index(draco::PointIndex(static_cast<std::uint32_t>(i)));
+
+            float value[3] = {};
+
+            if (!attribute->ConvertValue<float>(index, static_cast<std::int8_t>(components), value)) throw std::runtime_error("KHR_draco_mesh_compression attribute " + std::to_string(id) + " is not numeric.");
+
+            std::memcpy(output.data() + i * components * sizeof(float), value, components * sizeof(float));
+        }
+    };
+
+    read(position, 3, mesh.positions);
+
+    if (mapping >= 0) read(mapping, 2, mesh.mappings);
+
+    mesh.indices.resize(static_cast<size_t>(source->num_faces()) * 3 * sizeof(std::uint32_t));
+
+    for (std::uint32_t i = 0; i < source->num_faces(); ++i)
+    {
+        const auto& face = source->face(draco::FaceIndex(i));
+        const std::uint32_t triangle[3] = { face[0].value(), face[1].value(), face[2].value() };
+
+        std::memcpy(mesh.indices.data() + i * sizeof(triangle), triangle, sizeof(triangle));
+    }
+
+    return mesh;
+#else
+    static_cast<void>(data);
+    static_cast<void>(size);
+    static_cast<void>(position);
+    static_cast<void>(mapping);
+
+    throw std::runtime_error("KHR_draco_mesh_compression needs a build with NUTSHELL_DRACO.");
+#endif
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decoders for compressed glTF geometry, called by GltfScene::load once per compressed buffer view
+// (EXT_meshopt_compression) or primitive (KHR_draco_mesh_compression), each safe to run on any thread.
+struct GltfCompression
+{
+    enum class Mode
+    {
+        ATTRIBUTES,
+        TRIANGLES,
+        INDICES,
+    };
+
+    enum class Filter
+    {
+        NONE,
+        OCTAHEDRAL,
+        QUATERNION,
+        EXPONENTIAL,
+    };
+
+    struct MeshoptView
+    {
+        const std::uint8_t* source = nullptr;
+        size_t              size   = 0;
+        size_t              count  = 0;
+        size_t              stride = 0;
+        Mode                mode   = Mode::ATTRIBUTES;
+        Filter              filter = Filter::NONE;
+    };
+
+    // Positions and UVs as packed floats, three and two per vertex, and a triangle list of 32-bit indices.
+    struct DracoMesh
+    {
+        size_t                    vertices = 0;
+        std::vector<std::uint8_t> positions;
+        std::vector<std::uint8_t> mappings;
+        std::vector<std::uint8_t> indices;
+    };
+
+    // Writes `count` * `stride` bytes to `destination`, throws on malformed data.
+    static auto decode(const MeshoptView& view, std::uint8_t* destination) -> void;
+
+    // False unless built with NUTSHELL_DRACO.
+    static auto draco_available() -> bool;
+    // `position` and `mapping` are Draco attribute ids, a negative `mapping` leaves the UVs empty.
+    static auto decode_draco(const std::uint8_t* data, size_t size, int position, int mapping) -> DracoMesh;
+};
@@ -0,0 +1,760 @@
+#include "gltf_scene.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include <job_system.hpp>
+#include <profiler.hpp>
+
+#include "gltf_compression.hpp"
+#include "json.hpp"
+
+namespace
+{
+    auto invalid(const std::string& what) -> std::runtime_error
+    {
+        return std::runtime_error("Invalid glTF: " + what + ".");
+    }
+
+    // Bytes of a buffer or buffer view.
+    struct Span
+    {
+        const std::uint8_t* data   = nullptr;
+        size_t              size   = 0;
+        size_t              stride = 0;
+    };
+
+    constexpr std::uint32_t GLB_MAGIC = 0x46546c67;
+    constexpr std::uint32_t GLB_JSON  = 0x4e4f534a;
+    constexpr std::uint32_t GLB_BIN   = 0x004e4942;
+
+    constexpr std::uint32_t BYTE           = 5120;
+    constexpr std::uint32_t UNSIGNED_BYTE  = 5121;
+    constexpr std::uint32_t SHORT          = 5122;
+    constexpr std::uint32_t UNSIGNED_SHORT = 5123;
+    constexpr std::uint32_t UNSIGNED_INT   = 5125;
+    constexpr std::uint32_t FLOAT          = 5126;
+
+    auto load_u32(const std::uint8_t* data) -> std::uint32_t
+    {
+        std::uint32_t value;
+
+        std::memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    auto component_size(std::uint32_t type) -> size_t
+    {
+        switch (type)
+        {
+            case BYTE:
+            case UNSIGNED_BYTE:  return 1;
+            case SHORT:
+            case UNSIGNED_SHORT: return 2;
+            case UNSIGNED_INT:
+            case FLOAT:          return 4;
+            default:             throw invalid("unknown component type " + std::to_string(type));
+        }
+    }
+
+    auto component_count(std::string_view type) -> std::uint32_t
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        if (type == "MAT2") return 4;
+        if (type == "MAT3") return 9;
+        if (type == "MAT4") return 16;
+
+        throw invalid("unknown accessor type " + std::string(type));
+    }
+
+    // Index into `count` elements of a top-level array, for references between glTF objects.
+    auto reference(const Json::View& view, size_t count, const char* what) -> size_t
+    {
+        if (!view) return GltfScene::NONE;
+
+        const auto index = view.integer();
+
+        if (index >= count) throw invalid(std::string(what) + " " + std::to_string(index) + " out of range");
+
+        return index;
+    }
+
+    // URIs in glTF are relative and may percent-encode characters such as spaces.
+    auto decode_uri(std::string_view uri) -> std::string
+    {
+        std::string decoded;
+
+        for (size_t i = 0; i < uri.size(); ++i)
+        {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) && std::isxdigit(static_cast<unsigned char>(uri[i + 2])))
+            {
+                decoded += static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                decoded += uri[i];
+            }
+        }
+
+        return decoded;
+    }
+
+    // Payload of a base64 data: URI.
+    auto decode_data_uri(std::string_view uri) -> std::vector<std::uint8_t>
+    {
+        const auto comma = uri.find(',');
+
+        if (comma == std::string_view::npos || uri.substr(0, comma).find(";base64") == std::string_view::npos) throw invalid("only base64 data URIs are supported");
+
+        std::uint8_t table[256];
+
+        std::memset(table, 0xff, sizeof(table));
+
+        for (int i = 0; i < 64; ++i) table[static_cast<std::uint8_t>("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i])] = static_cast<std::uint8_t>(i);
+
+        std::vector<std::uint8_t> bytes;
+        std::uint32_t bits = 0;
+        int count = 0;
+
+        bytes.reserve((uri.size() - comma) / 4 * 3);
+
+        for (const auto c : uri.substr(comma + 1))
+        {
+            if (c == '=') break;
+
+            const auto value = table[static_cast<std::uint8_t>(c)];
+
+            if (value == 0xff) throw invalid("malformed base64 in data URI");
+
+            bits = (bits << 6) | value;
+            count += 6;
+
+            if (count >= 8)
+            {
+                count -= 8;
+                bytes.push_back(static_cast<std::uint8_t>(bits >> count));
+            }
+        }
+
+        return bytes;
+    }
+
+    // Column-major T * R * S, R from the unit quaternion (x, y, z, w).
+    auto compose(const float* t, const float* r, const float* s, float* matrix) -> void
+    {
+        const auto [x, y, z, w] = std::tuple(r[0], r[1], r[2], r[3]);
+
+        const float rotation[9] = {
+            1 - 2 * (y * y + z * z), 2 * (x * y + z * w),     2 * (x * z - y * w),
+            2 * (x * y - z * w),     1 - 2 * (x * x + z * z), 2 * (y * z + x * w),
+            2 * (x * z + y * w),     2 * (y * z - x * w),     1 - 2 * (x * x + y * y),
+        };
+
+        for (int column = 0; column < 3; ++column)
+        {
+            for (int row = 0; row < 3; ++row) matrix[column * 4 + row] = rotation[column * 3 + row] * s[column];
+
+            matrix[column * 4 + 3] = 0.0f;
+        }
+
+        matrix[12] = t[0];
+        matrix[13] = t[1];
+        matrix[14] = t[2];
+        matrix[15] = 1.0f;
+    }
+
+    // Elements of `count` items and `stride` bytes each, throws where they would not fit a size_t.
+    auto checked_bytes(size_t count, size_t stride) -> size_t
+    {
+        if (stride != 0 && count > std::numeric_limits<size_t>::max() / stride) throw invalid("buffer view too large");
+
+        return count * stride;
+    }
+
+    auto meshopt_view(const Json::View& extension, const Span& buffer, size_t length) -> GltfCompression::MeshoptView
+    {
+        using Mode = GltfCompression::Mode;
+        using Filter = GltfCompression::Filter;
+
+        auto view = GltfCompression::MeshoptView();
+        const auto offset = extension["byteOffset"].integer();
+        const auto mode = extension["mode"].string();
+        const auto filter = extension["filter"].string("NONE");
+
+        view.size = extension["byteLength"].integer();
+        view.count = extension["count"].integer();
+        view.stride = extension["byteStride"].integer();
+
+        if (!buffer.data) throw invalid("EXT_meshopt_compression reads a buffer without data");
+        if (offset > buffer.size || view.size > buffer.size - offset) throw invalid("EXT_meshopt_compression data outside of its buffer");
+        if (checked_bytes(view.count, view.stride) > length) throw invalid("EXT_meshopt_compression decodes past its buffer view");
+
+        view.source = buffer.data + offset;
+
+        if (mode == "ATTRIBUTES") view.mode = Mode::ATTRIBUTES;
+        else if (mode == "TRIANGLES") view.mode = Mode::TRIANGLES;
+        else if (mode == "INDICES") view.mode = Mode::INDICES;
+        else throw invalid("unknown EXT_meshopt_compression mode " + std::string(mode));
+
+        if (filter == "NONE") view.filter = Filter::NONE;
+        else if (filter == "OCTAHEDRAL") view.filter = Filter::OCTAHEDRAL;
+        else if (filter == "QUATERNION") view.filter = Filter::QUATERNION;
+        else if (filter == "EXPONENTIAL") view.filter = Filter::EXPONENTIAL;
+        else throw invalid("unknown EXT_meshopt_compression filter " + std::string(filter));
+
+        // The decoders assert on these rather than fail, so they are checked up front.
+        const auto valid = view.mode == Mode::ATTRIBUTES
+            ? view.stride > 0 && view.stride % 4 == 0 && view.stride <= 256
+            : (view.stride == 2 || view.stride == 4) && (view.mode == Mode::INDICES || view.count % 3 == 0);
+
+        if (!valid) throw invalid("EXT_meshopt_compression stride or count does not fit its mode");
+
+        const auto filtered = view.filter == Filter::NONE
+            || (view.filter == Filter::OCTAHEDRAL && (view.stride == 4 || view.stride == 8))
+            || (view.filter == Filter::QUATERNION && view.stride == 8)
+            || (view.filter == Filter::EXPONENTIAL && view.stride % 4 == 0);
+
+        if (view.mode != Mode::ATTRIBUTES && view.filter != Filter::NONE) throw invalid("EXT_meshopt_compression filters apply to attributes only");
+        if (!filtered) throw invalid("EXT_meshopt_compression filter does not fit its stride");
+
+        return view;
+    }
+
+    template <typename T>
+    auto read_components(const GltfScene::Accessor& accessor, float* destination, size_t stride, size_t components, size_t begin, size_t end, float scale) -> void
+    {
+        const auto present = std::min<size_t>(components, accessor.components);
+
+        for (auto i = begin; i < end; ++i)
+        {
+            const auto source = accessor.data + i * accessor.stride;
+            const auto output = destination + i * stride;
+
+            if constexpr (std::is_same_v<T, float>)
+            {
+                std::memcpy(output, source, present * sizeof(float));
+            }
+            else
+            {
+                for (size_t c = 0; c < present; ++c)
+                {
+                    T value;
+
+                    std::memcpy(&value, source + c * sizeof(T), sizeof(T));
+
+                    output[c] = accessor.normalized ? std::max(static_cast<float>(value) * scale, -1.0f) : static_cast<float>(value);
+                }
+            }
+
+            for (auto c = present; c < components; ++c) output[c] = 0.0f;
+        }
+    }
+}
+
+auto GltfScene::load(const std::string& path, JobSystem* jobs) -> GltfScene
+{
+    PROFILE_SCOPE("GltfScene::load");
+
+    auto scene = GltfScene();
+    auto& document = scene.files.emplace_back(AssetFile::open(path));
+    const auto directory = std::filesystem::path(path).parent_path();
+
+    auto text = std::string_view(reinterpret_cast<const char*>(document.data()), document.size());
+    auto binary = Span();
+
+    if (document.size() >= 12 && load_u32(document.data()) == GLB_MAGIC)
+    {
+        // Header, then a JSON chunk and an optional BIN chunk, each as length, type and 4-byte aligned payload.
+        if (load_u32(document.data() + 4) != 2) throw invalid("only GLB version 2 is supported");
+
+        const auto length = std::min<size_t>(load_u32(document.data() + 8), document.size());
+
+        for (size_t offset = 12; offset + 8 <= length;)
+        {
+            const auto chunk_length = static_cast<size_t>(load_u32(document.data() + offset));
+            const auto chunk_type = load_u32(document.data() + offset + 4);
+            const auto chunk = document.data() + offset + 8;
+
+            if (chunk_length > length - offset - 8) throw invalid("truncated GLB chunk");
+
+            if (offset == 12 && chunk_type != GLB_JSON) throw invalid("GLB does not start with a JSON chunk");
+
+            if (chunk_type == GLB_JSON && offset == 12) text = std::string_view(reinterpret_cast<const char*>(chunk), chunk_length);
+            else if (chunk_type == GLB_BIN && !binary.data) binary = { chunk, chunk_length };
+
+            offset += 8 + chunk_length;
+        }
+    }
+
+    Json json;
+
+    {
+        PROFILE_SCOPE("glTF JSON parse");
+
+        json = Json::parse(text);
+    }
+
+    const auto root = json.root();
+
+    if (root["asset"]["version"].string().substr(0, 2) != "2.") throw invalid("only glTF 2.0 is supported");
+
+    for (const auto extension : root["extensionsRequired"])
+    {
+        const auto name = extension.string();
+
+        if (name == "KHR_draco_mesh_compression" && !GltfCompression::draco_available()) throw invalid("KHR_draco_mesh_compression needs a build with NUTSHELL_DRACO");
+
+        // Quantized attributes need nothing beyond read(), which converts every component type.
+        if (name != "KHR_mesh_quantization" && name != "EXT_meshopt_compression" && name != "KHR_draco_mesh_compression") throw invalid("required extension " + std::string(name) + " is not supported");
+    }
+
+    // Buffers: the GLB chunk, base64 data: URIs, or files next to the scene, all files read in one batch.
+    std::vector<Span> buffers;
+    std::vector<std::string> external_paths;
+    std::vector<size_t> external_buffers;
+
+    for (const auto buffer : root["buffers"])
+    {
+        const auto uri = buffer["uri"].string();
+        const auto length = buffer["byteLength"].integer();
+
+        // Placeholder for views that are all EXT_meshopt_compression, nothing to read.
+        if (!buffer["uri"] && buffer["extensions"]["EXT_meshopt_compression"]["fallback"].boolean())
+        {
+            buffers.push_back({ nullptr, length });
+        }
+        else if (!buffer["uri"])
+        {
+            if (!binary.data || !buffers.empty()) throw invalid("buffer without uri outside of a GLB");
+            if (binary.size < length) throw invalid("GLB binary chunk is shorter than its buffer");
+
+            buffers.push_back({ binary.data, length });
+        }
+        else if (uri.substr(0, 5) == "data:")
+        {
+            const auto& bytes = scene.embedded.emplace_back(decode_data_uri(uri));
+
+            if (bytes.size() < length) throw invalid("data URI is shorter than its buffer");
+
+            buffers.push_back({ bytes.data(), length });
+        }
+        else
+        {
+            external_paths.push_back((directory / decode_uri(uri)).generic_string());
+            external_buffers.push_back(buffers.size());
+            buffers.push_back({ nullptr, length });
+        }
+    }
+
+    if (!external_paths.empty())
+    {
+        PROFILE_SCOPE("glTF buffer read");
+
+        auto files = AssetFile::open_all(external_paths);
+
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            auto& buffer = buffers[external_buffers[i]];
+
+            if (files[i].size() < buffer.size) throw invalid(external_paths[i] + " is shorter than its buffer");
+
+            buffer.data = files[i].data();
+            scene.files.push_back(std::move(files[i]));
+        }
+    }
+
+    // Compressed views decode into memory of their own, one job per view.
+    std::vector<Span> views;
+    std::vector<std::pair<GltfCompression::MeshoptView, std::uint8_t*>> compressed;
+
+    for (const auto view : root["bufferViews"])
+    {
+        const auto& buffer = buffers[reference(view["buffer"], buffers.size(), "buffer")];
+        const auto offset = view["byteOffset"].integer();
+        const auto length = view["byteLength"].integer();
+        const auto extension = view["extensions"]["EXT_meshopt_compression"];
+
+        if (offset > buffer.size || length > buffer.size - offset) throw invalid("buffer view outside of its buffer");
+
+        if (extension)
+        {
+            const auto source = meshopt_view(extension, buffers[reference(extension["buffer"], buffers.size(), "buffer")], length);
+            auto& decoded = scene.embedded.emplace_back(length);
+
+            compressed.emplace_back(source, decoded.data());
+            views.push_back({ decoded.data(), length, view["byteStride"].integer() });
+        }
+        else
+        {
+            views.push_back({ buffer.data ? buffer.data + offset : nullptr, length, view["byteStride"].integer() });
+        }
+    }
+
+    if (!compressed.empty())
+    {
+        PROFILE_SCOPE("glTF meshopt decode");
+
+        const auto decode = [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) GltfCompression::decode(compressed[i].first, compressed[i].second);
+        };
+
+        if (jobs) jobs->parallel_for(0, compressed.size(), decode, 1);
+        else decode(0, compressed.size());
+    }
+
+    for (const auto source : root["accessors"])
+    {
+        if (source["sparse"]) throw invalid("sparse accessors are not supported");
+
+        auto accessor = Accessor();
+
+        accessor.count = source["count"].integer();
+        accessor.component_type = static_cast<std::uint32_t>(source["componentType"].integer());
+        accessor.components = component_count(source["type"].string());
+        accessor.normalized = source["normalized"].boolean();
+
+        const auto element = component_size(accessor.component_type) * accessor.components;
+
+        accessor.stride = element;
+
+        if (source["bufferView"])
+        {
+            const auto& view = views[reference(source["bufferView"], views.size(), "buffer view")];
+            const auto offset = source["byteOffset"].integer();
+
+            if (view.stride != 0) accessor.stride = view.stride;
+
+            if (!view.data && accessor.count > 0) throw invalid("accessor reads a buffer without data");
+
+            if (accessor.count > 0 && (offset > view.size || (accessor.count - 1) * accessor.stride + element > view.size - offset)) throw invalid("accessor outside of its buffer view");
+
+            accessor.data = view.data + offset;
+        }
+
+        scene.accessors.push_back(accessor);
+    }
+
+    // KHR_draco_mesh_compression primitives, decoded after all meshes are known, one job per primitive.
+    struct Draco
+    {
+        Primitive* primitive;
+        Span       source;
+        int        position;
+        int        mapping;
+    };
+
+    std::vector<Draco> draco;
+
+    scene.meshes.reserve(root["meshes"].size());
+
+    for (const auto source : root["meshes"])
+    {
+        auto& mesh = scene.meshes.emplace_back();
+
+        mesh.primitives.reserve(source["primitives"].size());
+
+        for (const auto primitive : source["primitives"])
+        {
+            const auto mode = primitive["mode"].integer(4);
+
+            // Points and lines have nothing to fill, like assimp's triangulation drops them for the samples.
+            if (mode < 4) continue;
+            if (mode > 6) throw invalid("unknown primitive mode " + std::to_string(mode));
+
+            const auto attributes = primitive["attributes"];
+            auto target = Primitive();
+
+            target.mode = static_cast<Mode>(mode);
+            target.position = reference(attributes["POSITION"], scene.accessors.size(), "accessor");
+            target.mapping = reference(attributes["TEXCOORD_0"], scene.accessors.size(), "accessor");
+            target.indices = reference(primitive["indices"], scene.accessors.size(), "accessor");
+            target.material = reference(primitive["material"], root["materials"].size(), "material");
+
+            if (target.position == NONE) continue;
+
+            if (target.indices != NONE)
+            {
+                const auto& indices = scene.accessors[target.indices];
+
+                if (indices.components != 1 || (indices.component_type != UNSIGNED_BYTE && indices.component_type != UNSIGNED_SHORT && indices.component_type != UNSIGNED_INT)) throw invalid("indices must be unsigned scalars");
+            }
+
+            auto& added = mesh.primitives.emplace_back(target);
+            const auto extension = primitive["extensions"]["KHR_draco_mesh_compression"];
+
+            // Without Draco support a primitive that also has uncompressed accessors uses those.
+            if (extension && (GltfCompression::draco_available() || !scene.accessors[target.position].data))
+            {
+                const auto& view = views[reference(extension["bufferView"], views.size(), "buffer view")];
+                const auto mapping = extension["attributes"]["TEXCOORD_0"];
+
+                if (!extension["attributes"]["POSITION"]) throw invalid("KHR_draco_mesh_compression without POSITION");
+                if (!view.data) throw invalid("KHR_draco_mesh_compression reads a buffer without data");
+
+                draco.push_back({ &added, view, static_cast<int>(extension["attributes"]["POSITION"].integer()), mapping ? static_cast<int>(mapping.integer()) : -1 });
+            }
+        }
+    }
+
+    if (!draco.empty())
+    {
+        PROFILE_SCOPE("glTF draco decode");
+
+        std::vector<GltfCompression::DracoMesh> decoded(draco.size());
+
+        const auto decode = [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) decoded[i] = GltfCompression::decode_draco(draco[i].source.data, draco[i].source.size, draco[i].position, draco[i].mapping);
+        };
+
+        if (jobs) jobs->parallel_for(0, draco.size(), decode, 1);
+        else decode(0, draco.size());
+
+        // Each decoded stream becomes a tightly packed accessor of its own.
+        const auto add = [&](std::vector<std::uint8_t>& bytes, size_t count, std::uint32_t type, std::uint32_t components)
+        {
+            const auto& owned = scene.embedded.emplace_back(std::move(bytes));
+
+            scene.accessors.push_back({ owned.data(), count, component_size(type) * components, type, components, false });
+
+            return scene.accessors.size() - 1;
+        };
+
+        for (size_t i = 0; i < draco.size(); ++i)
+        {
+            auto& primitive = *draco[i].primitive;
+            auto& mesh = decoded[i];
+
+            primitive.mode = Mode::TRIANGLES;
+            primitive.position = add(mesh.positions, mesh.vertices, FLOAT, 3);
+            primitive.indices = add(mesh.indices, mesh.indices.size() / 4, UNSIGNED_INT, 1);
+
+            if (draco[i].mapping >= 0) primitive.mapping = add(mesh.mappings, mesh.vertices, FLOAT, 2);
+        }
+    }
+
+    // Attributes of a primitive have to agree on the vertex count, Mesh::convert reads as many UVs as positions.
+    for (const auto& mesh : scene.meshes)
+    {
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.mapping != NONE && scene.accessors[primitive.mapping].count != scene.accessors[primitive.position].count) throw invalid("TEXCOORD_0 and POSITION counts differ");
+        }
+    }
+
+    for (const auto source : root["images"])
+    {
+        auto& image = scene.images.emplace_back();
+        const auto uri = source["uri"].string();
+
+        if (source["bufferView"])
+        {
+            const auto& view = views[reference(source["bufferView"], views.size(), "buffer view")];
+
+            if (!view.data) throw invalid("image reads a buffer without data");
+
+            image.data = view.data;
+            image.size = view.size;
+        }
+        else if (uri.substr(0, 5) == "data:")
+        {
+            const auto& bytes = scene.embedded.emplace_back(decode_data_uri(uri));
+
+            image.data = bytes.data();
+            image.size = bytes.size();
+        }
+        else if (!uri.empty())
+        {
+            image.path = (directory / decode_uri(uri)).generic_string();
+        }
+    }
+
+    std::vector<size_t> textures;
+
+    for (const auto texture : root["textures"]) textures.push_back(reference(texture["source"], scene.images.size(), "image"));
+
+    for (const auto source : root["materials"])
+    {
+        const auto texture = reference(source["pbrMetallicRoughness"]["baseColorTexture"]["index"], textures.size(), "texture");
+
+        scene.materials.push_back({ texture == NONE ? NONE : textures[texture] });
+    }
+
+    const auto nodes_count = root["nodes"].size();
+    std::vector<std::uint32_t> parents(nodes_count);
+
+    for (const auto source : root["nodes"])
+    {
+        auto& node = scene.nodes.emplace_back();
+
+        if (source["matrix"])
+        {
+            if (source["matrix"].size() != 16) throw invalid("node matrix needs 16 numbers");
+
+            for (size_t i = 0; i < 16; ++i) node.matrix[i] = static_cast<float>(source["matrix"][i].number());
+        }
+        else if (source["translation"] || source["rotation"] || source["scale"])
+        {
+            float t[3] = { 0, 0, 0 };
+            float r[4] = { 0, 0, 0, 1 };
+            float s[3] = { 1, 1, 1 };
+
+            for (size_t i = 0; i < 3; ++i) t[i] = static_cast<float>(source["translation"][i].number(t[i]));
+            for (size_t i = 0; i < 4; ++i) r[i] = static_cast<float>(source["rotation"][i].number(r[i]));
+            for (size_t i = 0; i < 3; ++i) s[i] = static_cast<float>(source["scale"][i].number(s[i]));
+
+            compose(t, r, s, node.matrix);
+        }
+
+        node.mesh = reference(source["mesh"], root["meshes"].size(), "mesh");
+
+        for (const auto child : source["children"])
+        {
+            const auto index = reference(child, nodes_count, "node");
+
+            if (++parents[index] > 1) throw invalid("node " + std::to_string(index) + " has several parents");
+
+            node.children.push_back(index);
+        }
+    }
+
+    // Roots have no parent and every node at most one, so the hierarchy below them is a forest.
+    const auto scenes = root["scenes"];
+
+    if (scenes.size() > 0)
+    {
+        const auto selected = reference(root["scene"], scenes.size(), "scene");
+
+        for (const auto node : scenes[selected == NONE ? 0 : selected]["nodes"]) scene.roots.push_back(reference(node, nodes_count, "node"));
+    }
+    else
+    {
+        for (size_t i = 0; i < nodes_count; ++i)
+        {
+            if (parents[i] == 0) scene.roots.push_back(i);
+        }
+    }
+
+    for (const auto node : scene.roots)
+    {
+        if (parents[node] != 0) throw invalid("scene root " + std::to_string(node) + " has a parent");
+    }
+
+    return scene;
+}
+
+auto GltfScene::read(const Accessor& accessor, float* destination, size_t stride, size_t components, size_t begin, size_t end) -> void
+{
+    if (!accessor.data)
+    {
+        for (auto i = begin; i < end; ++i) std::fill_n(destination + i * stride, components, 0.0f);
+
+        return;
+    }
+
+    switch (accessor.component_type)
+    {
+        case FLOAT:          read_components<float>(accessor, destination, stride, components, begin, end, 1.0f); break;
+        case BYTE:           read_components<std::int8_t>(accessor, destination, stride, components, begin, end, 1.0f / 127.0f); break;
+        case UNSIGNED_BYTE:  read_components<std::uint8_t>(accessor, destination, stride, components, begin, end, 1.0f / 255.0f); break;
+        case SHORT:          read_components<std::int16_t>(accessor, destination, stride, components, begin, end, 1.0f / 32767.0f); break;
+        case UNSIGNED_SHORT: read_components<std::uint16_t>(accessor, destination, stride, components, begin, end, 1.0f / 65535.0f); break;
+        case UNSIGNED_INT:   read_components<std::uint32_t>(accessor, destination, stride, components, begin, end, 1.0f); break;
+        default:             throw invalid("unknown component type " + std::to_string(accessor.component_type));
+    }
+}
+
+auto GltfScene::triangles(const Primitive& primitive) const -> size_t
+{
+    const auto count = accessors[primitive.indices != NONE ? primitive.indices : primitive.position].count;
+
+    if (primitive.mode == Mode::TRIANGLES) return count / 3;
+
+    return count >= 3 ? count - 2 : 0;
+}
+
+auto GltfScene::read_triangles(const Primitive& primitive, std::uint32_t* destination, size_t begin, size_t end) const -> void
+{
+    const auto vertices = accessors[primitive.position].count;
+    const auto indices = primitive.indices != NONE ? &accessors[primitive.indices] : nullptr;
+
+    // Vertex of the i-th index, the index itself without an index accessor.
+    const auto vertex = [&](size_t i) -> std::uint32_t
+    {
+        if (!indices) return static_cast<std::uint32_t>(i);
+        if (!indices->data) return 0;
+
+        const auto source = indices->data + i * indices->stride;
+
+        switch (indices->component_type)
+        {
+            case UNSIGNED_BYTE:
+                return *source;
+            case UNSIGNED_SHORT:
+            {
+                std::uint16_t value;
+
+                std::memcpy(&value, source, sizeof(value));
+
+                return value;
+            }
+            default:
+                return load_u32(source);
+        }
+    };
+
+    std::uint32_t largest = 0;
+
+    if (primitive.mode == Mode::TRIANGLES && indices && indices->data && indices->component_type == UNSIGNED_INT && indices->stride == 4)
+    {
+        std::memcpy(destination + begin * 3, indices->data + begin * 12, (end - begin) * 12);
+
+        for (auto i = begin * 3; i < end * 3; ++i) largest = std::max(largest, destination[i]);
+    }
+    else
+    {
+        for (auto t = begin; t < end; ++t)
+        {
+            auto output = destination + t * 3;
+
+            switch (primitive.mode)
+            {
+                case Mode::TRIANGLES:
+                    output[0] = vertex(t * 3);
+                    output[1] = vertex(t * 3 + 1);
+                    output[2] = vertex(t * 3 + 2);
+
+                    break;
+                // Every other strip triangle is wound the other way round, swapping two keeps them consistent.
+                case Mode::TRIANGLE_STRIP:
+                    output[0] = vertex(t);
+                    output[1] = vertex(t + 1 + t % 2);
+                    output[2] = vertex(t + 2 - t % 2);
+
+                    break;
+                case Mode::TRIANGLE_FAN:
+                    output[0] = vertex(t + 1);
+                    output[1] = vertex(t + 2);
+                    output[2] = vertex(0);
+
+                    break;
+            }
+
+            largest = std::max({ largest, output[0], output[1], output[2] });
+        }
+    }
+
+    if (end > begin && largest >= vertices) throw invalid("index " + std::to_string(largest) + " past the " + std::to_string(vertices) + " vertices of its primitive");
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <asset_file.hpp>
+
+struct JobSystem;
+
+// glTF 2.0 scene (.gltf with external or data: buffers, or .glb) read without assimp: the JSON is parsed into a
+// tape, the buffers are mapped through AssetFile and stay mapped, and accessors become typed, strided views
+// straight into them. Uncompressed data is not copied at load, read() and read_triangles() convert any range of
+// an accessor into the caller's layout, so one primitive can be decoded by several threads at once.
+//
+//     const auto scene = GltfScene::load("media/room.gltf");
+//     for (const auto& primitive : scene.meshes[0].primitives) vertices += scene.accessors[primitive.position].count;
+//
+// Covers what the samples render: node hierarchy with matrix or TRS transforms, triangle lists, strips and fans,
+// positions, the first UV set, indices and the base color texture of materials, from files or buffer views.
+// Compressed geometry (EXT_meshopt_compression, KHR_draco_mesh_compression with NUTSHELL_DRACO) and quantized
+// attributes (KHR_mesh_quantization) decode at load into memory owned by the scene, the accessors then view
+// that. Sparse accessors, skins, morph targets and animations are rejected or ignored.
+struct GltfScene
+{
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    enum class Mode
+    {
+        TRIANGLES      = 4,
+        TRIANGLE_STRIP = 5,
+        TRIANGLE_FAN   = 6,
+    };
+
+    struct Accessor
+    {
+        // nullptr for accessors without a buffer view, which read as zeros.
+        const std::uint8_t* data           = nullptr;
+        size_t              count          = 0;
+        size_t              stride         = 0;
+        // GL enum of the components, GL_FLOAT, GL_UNSIGNED_SHORT, ...
+        std::uint32_t       component_type = 0;
+        std::uint32_t       components     = 0;
+        bool                normalized     = false;
+    };
+
+    struct Primitive
+    {
+        Mode   mode     = Mode::TRIANGLES;
+        size_t position = NONE;
+        size_t mapping  = NONE;
+        size_t indices  = NONE;
+        size_t material = NONE;
+    };
+
+    struct Mesh
+    {
+        std::vector<Primitive> primitives;
+    };
+
+    struct Node
+    {
+        // Local transformation, column-major like glTF.
+        float               matrix[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        size_t              mesh       = NONE;
+        std::vector<size_t> children;
+    };
+
+    // Image file next to the scene, or encoded bytes inside a buffer.
+    struct Image
+    {
+        std::string         path;
+        const std::uint8_t* data = nullptr;
+        size_t              size = 0;
+    };
+
+    struct Material
+    {
+        size_t base_color = NONE;
+    };
+
+    // With `jobs` compressed buffer views and primitives decode in parallel.
+    static auto load(const std::string& path, JobSystem* jobs = nullptr) -> GltfScene;
+
+    // Components of elements [begin, end) as floats, `components` of them to every `stride` floats of
+    // `destination` (missing ones as zeros), normalized integers mapped to [0, 1] or [-1, 1].
+    static auto read(const Accessor& accessor, float* destination, size_t stride, size_t components, size_t begin, size_t end) -> void;
+
+    // Triangles in a primitive, strips and fans included.
+    auto triangles(const Primitive& primitive) const -> size_t;
+    // Triangles [begin, end) of `primitive` as a triangle list of three indices each. Throws on indices past
+    // the primitive's vertices, so a broken file cannot make the GPU read outside the vertex buffer.
+    auto read_triangles(const Primitive& primitive, std::uint32_t* destination, size_t begin, size_t end) const -> void;
+
+    GltfScene() = default;
+    GltfScene(GltfScene&&) = default;
+    GltfScene(const GltfScene&) = delete;
+
+    auto operator=(GltfScene&&) -> GltfScene& = default;
+    auto operator=(const GltfScene&) -> GltfScene& = delete;
+
+    std::vector<Accessor>  accessors;
+    std::vector<Mesh>      meshes;
+    std::vector<Node>      nodes;
+    std::vector<Image>     images;
+    std::vector<Material>  materials;
+    // Top-level nodes of the default scene.
+    std::vector<size_t>    roots;
+
+private:
+    // Keep the views valid: mapped files and decoded data: URIs.
+    std::vector<AssetFile>                 files;
+    std::vector<std::vector<std::uint8_t>> embedded;
+};
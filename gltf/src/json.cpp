@@ -0,0 +1,358 @@
+#include "json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Nesting deeper than this is rejected instead of overflowing the stack, glTF needs less than ten.
+    constexpr int MAX_DEPTH = 256;
+
+    auto append_utf8(std::string& output, std::uint32_t code) -> void
+    {
+        if (code < 0x80)
+        {
+            output += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            output += static_cast<char>(0xc0 | (code >> 6));
+            output += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+            output += static_cast<char>(0xe0 | (code >> 12));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            output += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            output += static_cast<char>(0xf0 | (code >> 18));
+            output += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            output += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            output += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+}
+
+struct Json::Parser
+{
+    auto fail(const char* what) const -> std::runtime_error
+    {
+        return std::runtime_error("Malformed JSON at byte " + std::to_string(position) + ": " + what + ".");
+    }
+
+    auto skip_whitespace() -> void
+    {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\n' || text[position] == '\r' || text[position] == '\t')) ++position;
+    }
+
+    auto peek() -> char
+    {
+        skip_whitespace();
+
+        if (position >= text.size()) throw fail("unexpected end");
+
+        return text[position];
+    }
+
+    auto expect(std::string_view literal) -> void
+    {
+        if (text.substr(position, literal.size()) != literal) throw fail("invalid literal");
+
+        position += literal.size();
+    }
+
+    auto hex4() -> std::uint32_t
+    {
+        if (position + 4 > text.size()) throw fail("truncated escape");
+
+        std::uint32_t code = 0;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const auto c = text[position++];
+
+            code <<= 4;
+
+            if (c >= '0' && c <= '9') code |= static_cast<std::uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<std::uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<std::uint32_t>(c - 'A' + 10);
+            else throw fail("invalid escape");
+        }
+
+        return code;
+    }
+
+    // Unescaped strings stay views into the text, only strings with escapes are copied.
+    auto string() -> std::string_view
+    {
+        ++position;
+
+        const auto begin = position;
+
+        while (position < text.size() && text[position] != '"' && text[position] != '\\') ++position;
+
+        if (position >= text.size()) throw fail("unterminated string");
+
+        if (text[position] == '"') return text.substr(begin, position++ - begin);
+
+        auto& output = json.decoded.emplace_back(text.substr(begin, position - begin));
+
+        while (position < text.size() && text[position] != '"')
+        {
+            const auto c = text[position++];
+
+            if (c != '\\')
+            {
+                output += c;
+
+                continue;
+            }
+
+            if (position >= text.size()) throw fail("truncated escape");
+
+            switch (text[position++])
+            {
+                case '"':  output += '"'; break;
+                case '\\': output += '\\'; break;
+                case '/':  output += '/'; break;
+                case 'b':  output += '\b'; break;
+                case 'f':  output += '\f'; break;
+                case 'n':  output += '\n'; break;
+                case 'r':  output += '\r'; break;
+                case 't':  output += '\t'; break;
+                case 'u':
+                {
+                    auto code = hex4();
+
+                    // Surrogate pair, the low half has to follow as its own escape.
+                    if (code >= 0xd800 && code < 0xdc00)
+                    {
+                        if (text.substr(position, 2) != "\\u") throw fail("unpaired surrogate");
+
+                        position += 2;
+
+                        const auto low = hex4();
+
+                        if (low < 0xdc00 || low >= 0xe000) throw fail("unpaired surrogate");
+
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+
+                    append_utf8(output, code);
+
+                    break;
+                }
+                default:
+                    throw fail("invalid escape");
+            }
+        }
+
+        if (position >= text.size()) throw fail("unterminated string");
+
+        ++position;
+
+        return output;
+    }
+
+    auto number() -> double
+    {
+        const auto begin = text.data() + position;
+
+        // from_chars would also take inf and nan.
+        if (*begin != '-' && (*begin < '0' || *begin > '9')) throw fail("unexpected character");
+
+        double value;
+
+        const auto [end, error] = std::from_chars(begin, text.data() + text.size(), value);
+
+        if (error != std::errc() || end == begin) throw fail("invalid number");
+
+        position += static_cast<size_t>(end - begin);
+
+        return value;
+    }
+
+    auto value(int depth) -> void
+    {
+        if (depth > MAX_DEPTH) throw fail("nested too deeply");
+
+        const auto c = peek();
+        const auto index = json.values.size();
+
+        if (index >= std::numeric_limits<std::uint32_t>::max()) throw fail("too many values");
+
+        json.values.emplace_back();
+
+        switch (c)
+        {
+            case '{':
+            {
+                json.values[index].type = Type::OBJECT;
+
+                ++position;
+
+                std::uint32_t count = 0;
+
+                if (peek() != '}')
+                {
+                    for (;;)
+                    {
+                        if (peek() != '"') throw fail("expected a key");
+
+                        auto& key = json.values.emplace_back();
+
+                        key.type = Type::STRING;
+                        key.end = static_cast<std::uint32_t>(json.values.size());
+                        key.string = string();
+
+                        if (peek() != ':') throw fail("expected ':'");
+
+                        ++position;
+
+                        value(depth + 1);
+                        ++count;
+
+                        if (peek() == ',')
+                        {
+                            ++position;
+
+                            continue;
+                        }
+
+                        if (peek() != '}') throw fail("expected ',' or '}'");
+
+                        break;
+                    }
+                }
+
+                ++position;
+
+                json.values[index].count = count;
+
+                break;
+            }
+            case '[':
+            {
+                json.values[index].type = Type::ARRAY;
+
+                ++position;
+
+                std::uint32_t count = 0;
+
+                if (peek() != ']')
+                {
+                    for (;;)
+                    {
+                        value(depth + 1);
+                        ++count;
+
+                        if (peek() == ',')
+                        {
+                            ++position;
+
+                            continue;
+                        }
+
+                        if (peek() != ']') throw fail("expected ',' or ']'");
+
+                        break;
+                    }
+                }
+
+                ++position;
+
+                json.values[index].count = count;
+
+                break;
+            }
+            case '"':
+                json.values[index].type = Type::STRING;
+                json.values[index].string = string();
+
+                break;
+            case 't':
+                expect("true");
+
+                json.values[index].type = Type::BOOLEAN;
+                json.values[index].boolean = true;
+
+                break;
+            case 'f':
+                expect("false");
+
+                json.values[index].type = Type::BOOLEAN;
+
+                break;
+            case 'n':
+                expect("null");
+
+                break;
+            default:
+                json.values[index].type = Type::NUMBER;
+                json.values[index].number = number();
+
+                break;
+        }
+
+        json.values[index].end = static_cast<std::uint32_t>(json.values.size());
+    }
+
+    Json&            json;
+    std::string_view text;
+    size_t           position = 0;
+};
+
+auto Json::parse(std::string_view text) -> Json
+{
+    auto json = Json();
+    auto parser = Parser{ json, text };
+
+    // About one value per eight bytes of typical glTF, so the array rarely grows more than once.
+    json.values.reserve(text.size() / 8 + 1);
+
+    parser.value(0);
+    parser.skip_whitespace();
+
+    if (parser.position != text.size()) throw parser.fail("trailing characters");
+
+    return json;
+}
+
+auto Json::View::operator[](std::string_view key) const -> View
+{
+    if (type() != Type::OBJECT) return {};
+
+    // Members alternate key and value, a key's value is the next index and the member after it starts at its end.
+    for (auto member = index + 1; member < value().end; member = json->values[member + 1].end)
+    {
+        if (json->values[member].string == key) return { json, member + 1 };
+    }
+
+    return {};
+}
+
+auto Json::View::operator[](size_t element) const -> View
+{
+    if (type() != Type::ARRAY || element >= value().count) return {};
+
+    auto position = index + 1;
+
+    for (size_t i = 0; i < element; ++i) position = json->values[position].end;
+
+    return { json, position };
+}
+
+auto Json::View::integer(size_t fallback) const -> size_t
+{
+    if (type() != Type::NUMBER) return fallback;
+
+    const auto number = value().number;
+
+    if (!(number >= 0.0) || number != std::floor(number) || number > 9007199254740992.0) throw std::runtime_error("Expected a non-negative integer in JSON.");
+
+    return static_cast<size_t>(number);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only JSON document parsed in a single pass into a flat array of values, every container followed by its
+// elements (objects alternate key and value) so skipping a subtree is one jump. Strings point into the source
+// text, which has to outlive the document, unless they contain escapes.
+//
+//     const auto json = Json::parse(text);
+//     for (const auto accessor : json.root()["accessors"]) count += accessor["count"].integer();
+//
+// Lookups by key are linear, which suits objects of a handful of members; arrays are meant to be walked in order.
+struct Json
+{
+    enum class Type : std::uint8_t
+    {
+        NUL,
+        BOOLEAN,
+        NUMBER,
+        STRING,
+        ARRAY,
+        OBJECT,
+    };
+
+    struct Value
+    {
+        Type             type    = Type::NUL;
+        bool             boolean = false;
+        double           number  = 0.0;
+        std::string_view string;
+        // Elements of an array or members of an object, and the index right after the subtree.
+        std::uint32_t    count = 0;
+        std::uint32_t    end   = 0;
+    };
+
+    // Value inside a document, or a missing one: lookups of absent keys and indices yield a view that is
+    // false and returns the fallbacks.
+    struct View
+    {
+        struct Iterator
+        {
+            auto operator*() const -> View
+            {
+                return { json, index };
+            }
+
+            auto operator++() -> Iterator&
+            {
+                index = json->values[index].end;
+
+                return *this;
+            }
+
+            auto operator==(const Iterator& other) const -> bool = default;
+
+            const Json*   json;
+            std::uint32_t index;
+        };
+
+        explicit operator bool() const
+        {
+            return json != nullptr;
+        }
+
+        auto type() const -> Type
+        {
+            return json ? value().type : Type::NUL;
+        }
+
+        auto operator[](std::string_view key) const -> View;
+        auto operator[](size_t index) const -> View;
+
+        auto size() const -> size_t
+        {
+            return json && (value().type == Type::ARRAY || value().type == Type::OBJECT) ? value().count : 0;
+        }
+
+        auto boolean(bool fallback = false) const -> bool
+        {
+            return type() == Type::BOOLEAN ? value().boolean : fallback;
+        }
+
+        auto number(double fallback = 0.0) const -> double
+        {
+            return type() == Type::NUMBER ? value().number : fallback;
+        }
+
+        // Throws on negative or fractional numbers, which no count or index may be.
+        auto integer(size_t fallback = 0) const -> size_t;
+
+        auto string(std::string_view fallback = {}) const -> std::string_view
+        {
+            return type() == Type::STRING ? value().string : fallback;
+        }
+
+        // Elements of an array, nothing for other types.
+        auto begin() const -> Iterator
+        {
+            return { json, type() == Type::ARRAY ? index + 1 : 0 };
+        }
+
+        auto end() const -> Iterator
+        {
+            return { json, type() == Type::ARRAY ? value().end : 0 };
+        }
+
+        const Json*   json  = nullptr;
+        std::uint32_t index = 0;
+
+    private:
+        auto value() const -> const Value&
+        {
+            return json->values[index];
+        }
+    };
+
+    // Throws on malformed input, with the byte offset of the error.
+    static auto parse(std::string_view text) -> Json;
+
+    Json() = default;
+    Json(Json&&) = default;
+    Json(const Json&) = delete;
+
+    auto operator=(Json&&) -> Json& = default;
+    auto operator=(const Json&) -> Json& = delete;
+
+    auto root() const -> View
+    {
+        return values.empty() ? View() : View{ this, 0 };
+    }
+
+private:
+    struct Parser;
+
+    std::vector<Value>      values;
+    // Strings with escapes, decoded; a deque so views into earlier ones stay valid.
+    std::deque<std::string> decoded;
+};
@@ -0,0 +1,217 @@
+#include "headless.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if HEADLESS_EGL
+
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace
+{
+    // Displays worth trying, best first: the Mesa surfaceless platform, every EGL device, the default display.
+    auto candidate_displays() -> std::vector<EGLDisplay>
+    {
+        std::vector<EGLDisplay> displays;
+
+        const auto client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        const auto has_client_extension = [&](const char* name)
+        {
+            return client_extensions && std::strstr(client_extensions, name);
+        };
+        const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (get_platform_display && has_client_extension("EGL_MESA_platform_surfaceless"))
+        {
+            displays.push_back(get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr));
+        }
+
+        const auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+
+        if (get_platform_display && query_devices && has_client_extension("EGL_EXT_platform_device"))
+        {
+            EGLint devices_count = 0;
+
+            if (query_devices(0, nullptr, &devices_count) == EGL_TRUE && devices_count > 0)
+            {
+                std::vector<EGLDeviceEXT> devices(devices_count);
+
+                if (query_devices(devices_count, devices.data(), &devices_count) == EGL_TRUE)
+                {
+                    for (EGLint i = 0; i < devices_count; ++i)
+                    {
+                        displays.push_back(get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr));
+                    }
+                }
+            }
+        }
+
+        displays.push_back(eglGetDisplay(EGL_DEFAULT_DISPLAY));
+
+        std::erase(displays, EGL_NO_DISPLAY);
+
+        return displays;
+    }
+}
+
+HeadlessContext::HeadlessContext():
+    display(EGL_NO_DISPLAY),
+    context(EGL_NO_CONTEXT),
+    surface(EGL_NO_SURFACE)
+{
+    // The first failure is reported, it comes from the display that was expected to work.
+    auto error = std::string();
+
+    for (const auto candidate : candidate_displays())
+    {
+        try
+        {
+            display = candidate;
+            create();
+
+            return;
+        }
+        catch (const std::runtime_error& exception)
+        {
+            if (error.empty()) error = exception.what();
+
+            destroy();
+        }
+    }
+
+    throw std::runtime_error(error.empty() ? "EGL display is not available." : error);
+}
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
+
+auto HeadlessContext::create() -> void
+{
+    EGLint major, minor;
+
+    if (eglInitialize(display, &major, &minor) != EGL_TRUE) throw std::runtime_error("EGL initialization failed.");
+
+    initialized = true;
+
+    if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) throw std::runtime_error("EGL does not support desktop OpenGL.");
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_ALPHA_SIZE,      8,
+        EGL_DEPTH_SIZE,      24,
+        EGL_NONE,
+    };
+
+    EGLConfig config;
+    EGLint configs_count = 0;
+
+    if (eglChooseConfig(display, config_attributes, &config, 1, &configs_count) != EGL_TRUE || configs_count == 0) throw std::runtime_error("EGL config selection failed.");
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       4,
+        EGL_CONTEXT_MINOR_VERSION,       5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if (context == EGL_NO_CONTEXT) throw std::runtime_error("EGL context creation failed.");
+
+    const auto display_extensions = eglQueryString(display, EGL_EXTENSIONS);
+
+    if (!display_extensions || !std::strstr(display_extensions, "EGL_KHR_surfaceless_context"))
+    {
+        const EGLint surface_attributes[] = {
+            EGL_WIDTH,  1,
+            EGL_HEIGHT, 1,
+            EGL_NONE,
+        };
+
+        surface = eglCreatePbufferSurface(display, config, surface_attributes);
+
+        if (surface == EGL_NO_SURFACE) throw std::runtime_error("EGL pbuffer creation failed.");
+    }
+
+    if (eglMakeCurrent(display, surface, surface, context) != EGL_TRUE) throw std::runtime_error("EGL context activation failed.");
+}
+auto HeadlessContext::destroy() -> void
+{
+    if (display == EGL_NO_DISPLAY) return;
+
+    if (initialized)
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+
+        eglTerminate(display);
+    }
+
+    display     = EGL_NO_DISPLAY;
+    context     = EGL_NO_CONTEXT;
+    surface     = EGL_NO_SURFACE;
+    initialized = false;
+}
+
+#else
+
+HeadlessContext::HeadlessContext()
+{
+    throw std::runtime_error("Headless mode requires EGL, which was not found at configure time.");
+}
+HeadlessContext::~HeadlessContext()
+{
+}
+
+auto HeadlessContext::create() -> void
+{
+}
+auto HeadlessContext::destroy() -> void
+{
+}
+
+#endif
+
+Framebuffer::Framebuffer(GLsizei width, GLsizei height):
+    width(width),
+    height(height)
+{
+    glCreateRenderbuffers(1, &color);
+    glNamedRenderbufferStorage(color, GL_RGBA8, width, height);
+
+    glCreateRenderbuffers(1, &depth);
+    glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT24, width, height);
+
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    const auto status = glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        // The destructor does not run for a constructor that throws.
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteRenderbuffers(1, &color);
+
+        throw std::runtime_error("Framebuffer is incomplete: " + std::to_string(status) + ".");
+    }
+}
+Framebuffer::~Framebuffer()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteRenderbuffers(1, &color);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// OpenGL 4.5 core context without a window, created through EGL.
+// Prefers the Mesa surfaceless platform (llvmpipe on GPU-less machines), then every EGL device, then the default display,
+// with a pbuffer where surfaceless contexts are missing. A display that fails is terminated before the next is tried.
+struct HeadlessContext
+{
+    HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    ~HeadlessContext();
+
+    auto operator=(const HeadlessContext&) -> HeadlessContext& = delete;
+
+    void* display;
+    void* context;
+    void* surface;
+
+private:
+    auto create() -> void;
+    auto destroy() -> void;
+
+    bool initialized = false;
+};
+
+// Color and depth render targets used in place of the default framebuffer.
+struct Framebuffer
+{
+    Framebuffer(GLsizei width, GLsizei height);
+    Framebuffer(const Framebuffer&) = delete;
+    ~Framebuffer();
+
+    auto operator=(const Framebuffer&) -> Framebuffer& = delete;
+
+    GLuint  framebuffer;
+    GLuint  color;
+    GLuint  depth;
+    GLsizei width;
+    GLsizei height;
+};
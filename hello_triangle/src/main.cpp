@@ -4,6 +4,8 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
 
 
 std::string VERTEX_SHADER_SOURCE = R"(#version 450
@@ -33,20 +35,9 @@ const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOU
 
 int main() {
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        auto capture = Capture();
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-        const auto window = glfwCreateWindow(800, 600, "Hello triangle", nullptr, nullptr);
-
-        if (!window) throw std::runtime_error("Window creation failed.");
-
-        glfwMakeContextCurrent(window);
-
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        auto surface = Surface(capture, 800, 600, "Hello triangle");
 
         GLuint vertexArrays;
 
@@ -122,42 +113,49 @@ int main() {
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
 
-        while (!glfwWindowShouldClose(window))
         {
-            glfwPollEvents();
+            auto pacer = FramePacer();
 
-            int width, height;
+            while (surface.open())
+            {
+                surface.poll();
 
-            glfwGetFramebufferSize(window, &width, &height);
+                pacer.begin();
 
-            glViewport(0, 0, width, height);
-            glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            glBindVertexArray(vertexArrays);
-            glUseProgram(program);
-            glValidateProgram(program);
+                int width, height;
 
-            GLint validateStatus;
+                surface.size(width, height);
 
-            glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
+                glViewport(0, 0, width, height);
+                glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glBindVertexArray(vertexArrays);
+                glUseProgram(program);
+                glValidateProgram(program);
 
-            if (validateStatus != GL_TRUE) {
-                GLint size = 0;
+                GLint validateStatus;
 
-                glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+                glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
 
-                std::string log;
+                if (validateStatus != GL_TRUE) {
+                    GLint size = 0;
 
-                log.resize(size);
-                glGetProgramInfoLog(program, size, &size, log.data());
+                    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
 
-                throw std::runtime_error(log);
-            }
+                    std::string log;
 
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            glFlush();
+                    log.resize(size);
+                    glGetProgramInfoLog(program, size, &size, log.data());
 
-            glfwSwapBuffers(window);
+                    throw std::runtime_error(log);
+                }
+
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+
+                surface.present();
+
+                pacer.end();
+            }
         }
 
         glDeleteProgram(program);
@@ -176,9 +174,6 @@ int main() {
 
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
-
-        glfwDestroyWindow(window);
-        glfwTerminate();
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;
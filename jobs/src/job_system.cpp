@@ -0,0 +1,289 @@
+#include "job_system.hpp"
+
+#include <utility>
+
+#include <profiler.hpp>
+
+struct JobSystem::Job
+{
+    std::function<void()> function;
+    Counter*              counter;
+    Job*                  next = nullptr;
+};
+
+namespace
+{
+    // Which system and deque the calling thread works for, nullptr outside of workers.
+    thread_local const JobSystem* current_system = nullptr;
+    thread_local size_t           current_index  = 0;
+    thread_local std::uint32_t    random_state   = 0x9e3779b9u;
+
+    auto next_random() -> std::uint32_t
+    {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+
+        return random_state;
+    }
+
+    // How often an idle worker looks for work again before it sleeps, waking costs a futex round trip.
+    constexpr int SPINS_BEFORE_SLEEP = 64;
+}
+
+auto JobSystem::Counter::add() -> void
+{
+    auto current = state.load(std::memory_order_relaxed);
+
+    while (!state.compare_exchange_weak(current, (current & ~CLOSED) + 1 + GENERATION, std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+    }
+}
+
+auto JobSystem::Counter::release() -> bool
+{
+    auto current = state.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        // Only one thread closes at a time, a count dropping to zero meanwhile is picked up by that one.
+        const auto last = (current & COUNT) == 1 && !(current & CLOSING);
+        const auto next = (current - 1 + GENERATION) | (last ? CLOSING : 0);
+
+        if (state.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_relaxed)) return last;
+    }
+}
+
+auto JobSystem::Counter::fail(std::exception_ptr exception) -> void
+{
+    if (!failed.exchange(true, std::memory_order_relaxed)) failure = exception;
+}
+
+JobSystem::JobSystem(size_t threads)
+{
+    threads = std::max<size_t>(1, threads == 0 ? std::thread::hardware_concurrency() : threads);
+
+    for (size_t i = 1; i < threads; ++i) workers.push_back(std::make_unique<Worker>());
+
+    // Every deque exists before the first worker starts stealing.
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        workers[i]->thread = std::thread([this, i] { work(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    stopping.store(true, std::memory_order_release);
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_all();
+
+    for (auto& worker : workers) worker->thread.join();
+
+    for (auto& worker : workers)
+    {
+        while (const auto job = worker->deque.take()) delete job;
+    }
+
+    for (const auto job : injected) delete job;
+}
+
+auto JobSystem::submit(std::function<void()> function, Counter& counter) -> void
+{
+    counter.add();
+
+    push(new Job{ std::move(function), &counter });
+}
+
+auto JobSystem::submit_after(Counter& dependency, std::function<void()> function, Counter& counter) -> void
+{
+    counter.add();
+
+    const auto job = new Job{ std::move(function), &counter };
+
+    // Holding a reference keeps the dependency from closing while the job goes onto its list, dropping it runs
+    // the job right away when the dependency was done already.
+    dependency.add();
+
+    auto head = dependency.continuations.load(std::memory_order_relaxed);
+
+    do
+    {
+        job->next = head;
+    }
+    while (!dependency.continuations.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+
+    release(dependency);
+}
+
+auto JobSystem::wait(Counter& counter) -> void
+{
+    PROFILE_SCOPE("JobSystem::wait");
+
+    while (!counter.done())
+    {
+        if (const auto job = find())
+        {
+            run(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (counter.failed.load(std::memory_order_relaxed))
+    {
+        auto failure = std::exchange(counter.failure, nullptr);
+
+        counter.failed.store(false, std::memory_order_relaxed);
+
+        std::rethrow_exception(failure);
+    }
+}
+
+auto JobSystem::push(Job* job) -> void
+{
+    if (current_system == this)
+    {
+        workers[current_index]->deque.push(job);
+    }
+    else
+    {
+        auto lock = std::lock_guard(mutex);
+
+        injected.push_back(job);
+        injected_count.fetch_add(1, std::memory_order_release);
+    }
+
+    epoch.fetch_add(1, std::memory_order_release);
+    epoch.notify_one();
+}
+
+auto JobSystem::find() -> Job*
+{
+    const auto own = current_system == this;
+
+    if (own)
+    {
+        if (const auto job = workers[current_index]->deque.take()) return job;
+    }
+
+    if (injected_count.load(std::memory_order_acquire) > 0)
+    {
+        auto lock = std::lock_guard(mutex);
+
+        if (!injected.empty())
+        {
+            const auto job = injected.front();
+
+            injected.pop_front();
+            injected_count.fetch_sub(1, std::memory_order_relaxed);
+
+            return job;
+        }
+    }
+
+    if (workers.empty()) return nullptr;
+
+    // Random first victim, so thieves do not all pile onto the same deque.
+    const auto first = next_random() % workers.size();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        const auto victim = (first + i) % workers.size();
+
+        if (own && victim == current_index) continue;
+
+        if (const auto job = workers[victim]->deque.steal()) return job;
+    }
+
+    return nullptr;
+}
+
+auto JobSystem::run(Job* job) -> void
+{
+    const auto counter = job->counter;
+
+    try
+    {
+        job->function();
+    }
+    catch (...)
+    {
+        counter->fail(std::current_exception());
+    }
+
+    delete job;
+
+    release(*counter);
+}
+
+auto JobSystem::release(Counter& counter) -> void
+{
+    if (!counter.release()) return;
+
+    for (;;)
+    {
+        const auto seen = counter.state.load(std::memory_order_acquire);
+        auto continuation = counter.continuations.exchange(nullptr, std::memory_order_acquire);
+
+        while (continuation)
+        {
+            const auto next = continuation->next;
+
+            push(continuation);
+            continuation = next;
+        }
+
+        // Any add or release since `seen` changed the generation, so the list is drained again. Otherwise the
+        // counter closes, or stays open for jobs submitted meanwhile. Either exchange is the last access, a waiter
+        // may destroy the counter right after.
+        const auto next = (seen & Counter::COUNT) == 0 ? (seen & ~Counter::CLOSING) | Counter::CLOSED : seen & ~Counter::CLOSING;
+        auto expected = seen;
+
+        if (counter.state.compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed)) return;
+    }
+}
+
+auto JobSystem::work(size_t index) -> void
+{
+    PROFILE_THREAD("jobs");
+
+    current_system = this;
+    current_index = index;
+    random_state ^= static_cast<std::uint32_t>(index + 1) * 0x85ebca6bu;
+
+    for (;;)
+    {
+        if (const auto job = find())
+        {
+            run(job);
+
+            continue;
+        }
+
+        // A push after this load changes the epoch, so the wait below cannot miss it.
+        const auto seen = epoch.load(std::memory_order_acquire);
+
+        if (stopping.load(std::memory_order_acquire)) return;
+
+        auto job = static_cast<Job*>(nullptr);
+
+        for (int spin = 0; spin < SPINS_BEFORE_SLEEP && !job; ++spin)
+        {
+            job = find();
+
+            if (!job) std::this_thread::yield();
+        }
+
+        if (job)
+        {
+            run(job);
+
+            continue;
+        }
+
+        epoch.wait(seen, std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <work_stealing_deque.hpp>
+
+// Work-stealing job system: every worker pushes the jobs it spawns onto its own Chase-Lev deque and runs them
+// newest first, idle workers steal the oldest jobs of the others. Threads outside the system submit through a
+// shared queue and run jobs themselves while they wait(), so `threads` counts the waiting thread too.
+//
+//     auto jobs = JobSystem();
+//     auto decoded = JobSystem::Counter();
+//     for (auto& file : files) jobs.submit([&] { decode(file); }, decoded);
+//     jobs.wait(decoded);
+//
+//     jobs.parallel_for(0, nodes.size(), [&](size_t begin, size_t end) { update(begin, end); });
+//
+// Jobs that throw hand the first exception to whoever waits on their counter.
+struct JobSystem
+{
+    struct Job;
+
+    // Jobs still to run. Reuse one only after wait() on it returned.
+    struct Counter
+    {
+        Counter() = default;
+        Counter(const Counter&) = delete;
+
+        auto operator=(const Counter&) -> Counter& = delete;
+
+        auto done() const -> bool
+        {
+            return state.load(std::memory_order_acquire) & CLOSED;
+        }
+
+    private:
+        friend JobSystem;
+
+        // Count, closed and closing flags share one word, so a submit racing the last job either keeps the counter
+        // open or reopens it, never leaves it closed with a job queued. Every change bumps the generation, which
+        // lets the closing thread tell whether a continuation may have been added while it drained the list.
+        static constexpr std::uint64_t COUNT      = 0xffffffffull;
+        static constexpr std::uint64_t CLOSED     = 1ull << 32;
+        static constexpr std::uint64_t CLOSING    = 1ull << 33;
+        static constexpr std::uint64_t GENERATION = 1ull << 34;
+
+        auto add() -> void;
+        // True for the caller that dropped the count to zero, it has to close().
+        auto release() -> bool;
+        auto fail(std::exception_ptr exception) -> void;
+
+        std::atomic<std::uint64_t> state         = CLOSED;
+        std::atomic<Job*>          continuations = nullptr;
+        std::atomic<bool>          failed        = false;
+        std::exception_ptr         failure;
+    };
+
+    // 0 uses every core.
+    explicit JobSystem(size_t threads = 0);
+    JobSystem(const JobSystem&) = delete;
+    // Jobs that never ran are dropped, wait() on everything before.
+    ~JobSystem();
+
+    auto operator=(const JobSystem&) -> JobSystem& = delete;
+
+    auto submit(std::function<void()> function, Counter& counter) -> void;
+    // Runs `function` once `dependency` dropped to zero.
+    auto submit_after(Counter& dependency, std::function<void()> function, Counter& counter) -> void;
+    // Runs jobs until `counter` dropped to zero, then rethrows the first exception of its jobs.
+    auto wait(Counter& counter) -> void;
+
+    // Calls `body(begin, end)` on disjoint subranges covering [begin, end) and returns when all are done.
+    // Ranges are halved recursively down to `grain` elements, spare halves are left for thieves. With the
+    // default grain of 0 each thread gets about eight pieces, enough slack to even out uneven pieces.
+    template <typename Body>
+    auto parallel_for(size_t begin, size_t end, Body&& body, size_t grain = 0) -> void
+    {
+        if (begin >= end) return;
+
+        const auto count = end - begin;
+
+        if (grain == 0) grain = std::max<size_t>(1, count / (threads() * 8));
+
+        if (count <= grain || threads() == 1)
+        {
+            body(begin, end);
+
+            return;
+        }
+
+        auto counter = Counter();
+
+        // Jobs spawned so far still reference `body` and `counter`, so even a throwing body waits for them.
+        try
+        {
+            split(begin, end, grain, body, counter);
+        }
+        catch (...)
+        {
+            counter.fail(std::current_exception());
+        }
+
+        wait(counter);
+    }
+
+    auto threads() const -> size_t
+    {
+        return workers.size() + 1;
+    }
+
+private:
+    struct Worker
+    {
+        WorkStealingDeque<Job> deque;
+        std::thread            thread;
+    };
+
+    template <typename Body>
+    auto split(size_t begin, size_t end, size_t grain, Body& body, Counter& counter) -> void
+    {
+        while (end - begin > grain)
+        {
+            const auto middle = begin + (end - begin) / 2;
+
+            submit([this, middle, end, grain, &body, &counter] { split(middle, end, grain, body, counter); }, counter);
+
+            end = middle;
+        }
+
+        body(begin, end);
+    }
+
+    auto push(Job* job) -> void;
+    auto find() -> Job*;
+    auto run(Job* job) -> void;
+    // Drops one reference of `counter`, the last one pushes its continuations and closes it.
+    auto release(Counter& counter) -> void;
+    auto work(size_t index) -> void;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex                           mutex;
+    std::deque<Job*>                     injected;
+    std::atomic<size_t>                  injected_count = 0;
+    std::atomic<std::uint32_t>           epoch          = 0;
+    std::atomic<bool>                    stopping       = false;
+};
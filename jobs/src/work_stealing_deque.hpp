@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Chase-Lev deque of pointers (Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+// Memory Models", 2013). The owning thread push()es and take()s at the bottom, any other thread steal()s from
+// the top. Grows on demand, outgrown arrays are kept until destruction since a thief may still be reading one.
+template <typename T>
+struct WorkStealingDeque
+{
+    explicit WorkStealingDeque(size_t capacity = 256)
+    {
+        arrays.push_back(std::make_unique<Array>(static_cast<std::int64_t>(std::bit_ceil(std::max<size_t>(capacity, 2)))));
+        array.store(arrays.back().get(), std::memory_order_relaxed);
+    }
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+    auto operator=(const WorkStealingDeque&) -> WorkStealingDeque& = delete;
+
+    // Owner only.
+    auto push(T* item) -> void
+    {
+        const auto b = bottom.load(std::memory_order_relaxed);
+        const auto t = top.load(std::memory_order_acquire);
+        auto a = array.load(std::memory_order_relaxed);
+
+        if (b - t > a->capacity - 1) a = grow(a, t, b);
+
+        a->put(b, item);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // Owner only, newest first.
+    auto take() -> T*
+    {
+        const auto b = bottom.load(std::memory_order_relaxed) - 1;
+        const auto a = array.load(std::memory_order_relaxed);
+
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+
+            return nullptr;
+        }
+
+        auto item = a->get(b);
+
+        // Last item: race the thieves for it.
+        if (t == b)
+        {
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) item = nullptr;
+
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    // Any thread, oldest first. Returns nullptr when empty or when another thread won the race.
+    auto steal() -> T*
+    {
+        auto t = top.load(std::memory_order_acquire);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const auto b = bottom.load(std::memory_order_acquire);
+
+        if (t >= b) return nullptr;
+
+        const auto a = array.load(std::memory_order_acquire);
+        const auto item = a->get(t);
+
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+
+        return item;
+    }
+
+    auto empty() const -> bool
+    {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array
+    {
+        explicit Array(std::int64_t capacity):
+            capacity(capacity),
+            slots(std::make_unique<std::atomic<T*>[]>(static_cast<size_t>(capacity)))
+        {
+        }
+
+        auto put(std::int64_t index, T* item) -> void
+        {
+            slots[static_cast<size_t>(index & (capacity - 1))].store(item, std::memory_order_relaxed);
+        }
+
+        auto get(std::int64_t index) const -> T*
+        {
+            return slots[static_cast<size_t>(index & (capacity - 1))].load(std::memory_order_relaxed);
+        }
+
+        std::int64_t                       capacity;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    auto grow(Array* old, std::int64_t t, std::int64_t b) -> Array*
+    {
+        arrays.push_back(std::make_unique<Array>(old->capacity * 2));
+
+        const auto a = arrays.back().get();
+
+        for (auto i = t; i < b; ++i) a->put(i, old->get(i));
+
+        array.store(a, std::memory_order_release);
+
+        return a;
+    }
+
+    // Separate cache lines, the owner hammers bottom while thieves hammer top.
+    alignas(64) std::atomic<std::int64_t> top    = 0;
+    alignas(64) std::atomic<std::int64_t> bottom = 0;
+    alignas(64) std::atomic<Array*>       array;
+    std::vector<std::unique_ptr<Array>>   arrays;
+};
@@ -0,0 +1,102 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <job_system.hpp>
+
+// Submits while earlier jobs of the same counter are finishing, so the count keeps dropping to zero and coming back.
+// A counter that reads done() too early lets wait() return before a job ran, or a continuation start too soon.
+
+auto check(bool condition, const std::string& message) -> void
+{
+    if (!condition) throw std::runtime_error(message);
+}
+
+// Second job submitted right as the first one finishes, wait() has to cover both.
+auto resubmit(JobSystem& jobs, size_t rounds) -> void
+{
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        auto counter = JobSystem::Counter();
+        auto first = std::atomic<bool>(false);
+        auto second = false;
+
+        jobs.submit([&] { first.store(true, std::memory_order_release); }, counter);
+
+        // Spread the second submit around the moment the first job finishes.
+        for (size_t spin = round % 64; spin > 0 && !first.load(std::memory_order_acquire); --spin) std::this_thread::yield();
+
+        jobs.submit([&] { second = true; }, counter);
+        jobs.wait(counter);
+
+        check(counter.done() && second, "wait() returned with a job still queued in round " + std::to_string(round) + ".");
+    }
+}
+
+// Continuations registered while the dependency's jobs finish and new ones are submitted to it.
+auto continuations(JobSystem& jobs, size_t rounds) -> void
+{
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        auto dependency = JobSystem::Counter();
+        auto after = JobSystem::Counter();
+        auto finished = std::atomic<int>(0);
+        auto early = std::atomic<bool>(false);
+        constexpr int JOBS = 4;
+
+        for (int i = 0; i < JOBS / 2; ++i) jobs.submit([&] { finished.fetch_add(1, std::memory_order_acq_rel); }, dependency);
+
+        jobs.submit_after(dependency, [&] { if (finished.load(std::memory_order_acquire) < JOBS / 2) early = true; }, after);
+
+        for (int i = JOBS / 2; i < JOBS; ++i) jobs.submit([&] { finished.fetch_add(1, std::memory_order_acq_rel); }, dependency);
+
+        jobs.submit_after(dependency, [&] { if (finished.load(std::memory_order_acquire) < JOBS) early = true; }, after);
+
+        jobs.wait(after);
+        jobs.wait(dependency);
+
+        check(!early, "A continuation ran before its dependency finished in round " + std::to_string(round) + ".");
+        check(finished == JOBS, "Dependency jobs were lost in round " + std::to_string(round) + ".");
+    }
+}
+
+// Splits submit from inside jobs of the same counter.
+auto ranges(JobSystem& jobs, size_t rounds) -> void
+{
+    constexpr size_t COUNT = 4096;
+
+    auto values = std::vector<int>(COUNT);
+
+    for (size_t round = 0; round < rounds; ++round)
+    {
+        jobs.parallel_for(0, COUNT, [&](size_t begin, size_t end) { for (auto i = begin; i < end; ++i) ++values[i]; }, 1 + round % 16);
+
+        for (size_t i = 0; i < COUNT; ++i) check(values[i] == static_cast<int>(round + 1), "parallel_for missed element " + std::to_string(i) + ".");
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const auto rounds = argc > 1 ? std::stoul(argv[1]) : size_t(20000);
+
+        for (const auto threads : { size_t(2), size_t(4), size_t(0) })
+        {
+            auto jobs = JobSystem(threads);
+
+            resubmit(jobs, rounds);
+            continuations(jobs, rounds / 4);
+            ranges(jobs, rounds / 100);
+        }
+    }
+    catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,12 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <png.h>
+#include <asset_file.hpp>
+#include <pixel_convert.hpp>
+#include <profiler.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
+#include <staging_ring.hpp>
 
 struct Vertex {
     glm::vec2 position;
@@ -43,20 +49,11 @@ const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOU
 
 int main() {
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        PROFILE_THREAD("main");
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        auto capture = Capture();
 
-        const auto window = glfwCreateWindow(800, 600, "Load texture", nullptr, nullptr);
-
-        if (!window) throw std::runtime_error("Window creation failed.");
-
-        glfwMakeContextCurrent(window);
-
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        auto surface = Surface(capture, 800, 600, "Load texture");
 
         const auto vertices = std::vector<Vertex>{
             { { -0.5f, -0.5f }, { 0.0f, 0.0f } },
@@ -84,12 +81,15 @@ int main() {
 
         const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
 
-        glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
-        glCompileShader(vertexShader);
-
         GLint vertexShaderCompileStatus;
 
-        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        {
+            PROFILE_SCOPE("vertex shader compile");
+
+            glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
+            glCompileShader(vertexShader);
+            glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        }
 
         if (vertexShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -106,12 +106,15 @@ int main() {
 
         const auto fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-        glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
-        glCompileShader(fragmentShader);
-
         GLint fragmentShaderCompileStatus;
 
-        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        {
+            PROFILE_SCOPE("fragment shader compile");
+
+            glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
+            glCompileShader(fragmentShader);
+            glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        }
 
         if (fragmentShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -128,13 +131,16 @@ int main() {
 
         const auto program = glCreateProgram();
 
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, fragmentShader);
-        glLinkProgram(program);
-
         GLint linkStatus;
 
-        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        {
+            PROFILE_SCOPE("program link");
+
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        }
 
         if (linkStatus != GL_TRUE) {
             GLint size = 0;
@@ -154,23 +160,31 @@ int main() {
 
         png_image image = {};
 
-        // memset(&image, 0, sizeof(image));
         image.version = PNG_IMAGE_VERSION;
 
-        if (png_image_begin_read_from_file(&image, "media/image.png") == 0) throw std::runtime_error("Failed to load image.");
+        const auto file = AssetFile::open("media/image.png");
 
-        image.format = PNG_FORMAT_RGBA;
-
-        std::vector<std::uint8_t> pixels(PNG_IMAGE_SIZE(image));
-
-        if (png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+        if (png_image_begin_read_from_memory(&image, file.data(), file.size()) == 0) throw std::runtime_error("Failed to load image.");
 
         GLuint texture;
 
         glCreateTextures(GL_TEXTURE_2D, 1, &texture);
         glTextureStorage2D(texture, 1, GL_RGBA8, image.width, image.height);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        {
+            // libpng decodes straight into mapped buffer memory, the texture is filled from there.
+            const auto bytes = static_cast<size_t>(image.width) * image.height * 4;
+            auto ring = StagingRing(bytes);
+            const auto staging = ring.allocate(bytes);
+
+            {
+                PROFILE_SCOPE("png decode");
+
+                pixels::read_png_rgba(image, staging.data);
+            }
+
+            ring.upload_texture(texture, staging, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE);
+        }
 
         GLuint sampler;
 
@@ -180,13 +194,19 @@ int main() {
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        while (!glfwWindowShouldClose(window))
+        auto pacer = FramePacer();
+
+        while (surface.open())
         {
-            glfwPollEvents();
+            PROFILE_SCOPE("frame");
+
+            surface.poll();
+
+            pacer.begin();
 
             int width, height;
 
-            glfwGetFramebufferSize(window, &width, &height);
+            surface.size(width, height);
 
             glViewport(0, 0, width, height);
             glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
@@ -219,9 +239,14 @@ int main() {
             glBindSampler(0, sampler);
 
             glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-            glFlush();
 
-            glfwSwapBuffers(window);
+            {
+                PROFILE_SCOPE("present");
+
+                surface.present();
+            }
+
+            pacer.end();
         }
 
         glDeleteSamplers(1, &sampler);
@@ -244,8 +269,7 @@ int main() {
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        PROFILE_WRITE("load_texture.trace.json");
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;
@@ -7,6 +7,9 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <png.h>
+#include <asset_file.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
 
 struct Vertex {
     glm::vec2 position;
@@ -46,20 +49,9 @@ const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOU
 
 int main() {
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        auto capture = Capture();
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-        const auto window = glfwCreateWindow(512, 512, "Matrix 2D", nullptr, nullptr);
-
-        if (!window) throw std::runtime_error("Window creation failed.");
-
-        glfwMakeContextCurrent(window);
-
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        auto surface = Surface(capture, 512, 512, "Matrix 2D");
 
         const auto vertices = std::vector<Vertex>{
             { { -0.5f, -0.5f * 6.0f / 8.0f }, { 0.0f, 0.0f } },
@@ -173,7 +165,9 @@ int main() {
         // memset(&image, 0, sizeof(image));
         image.version = PNG_IMAGE_VERSION;
 
-        if (png_image_begin_read_from_file(&image, "media/image.png") == 0) throw std::runtime_error("Failed to load image.");
+        const auto file = AssetFile::open("media/image.png");
+
+        if (png_image_begin_read_from_memory(&image, file.data(), file.size()) == 0) throw std::runtime_error("Failed to load image.");
 
         image.format = PNG_FORMAT_RGBA;
 
@@ -198,13 +192,17 @@ int main() {
 
         float x = 0.0f;
 
-        while (!glfwWindowShouldClose(window))
+        auto pacer = FramePacer();
+
+        while (surface.open())
         {
-            glfwPollEvents();
+            surface.poll();
+
+            pacer.begin();
 
             int width, height;
 
-            glfwGetFramebufferSize(window, &width, &height);
+            surface.size(width, height);
 
             glViewport(0, 0, width, height);
             glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
@@ -246,9 +244,10 @@ int main() {
             glBindSampler(0, sampler);
 
             glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-            glFlush();
 
-            glfwSwapBuffers(window);
+            surface.present();
+
+            pacer.end();
         }
 
         glDeleteSamplers(1, &sampler);
@@ -271,9 +270,6 @@ int main() {
 
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
-
-        glfwDestroyWindow(window);
-        glfwTerminate();
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;
@@ -0,0 +1,79 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    auto frames_in_flight_from_environment() -> size_t
+    {
+        if (const auto count = std::getenv("NUTSHELL_FRAMES_IN_FLIGHT")) return std::stoul(count);
+
+        return 2;
+    }
+}
+
+FramePacer::FramePacer():
+    FramePacer(frames_in_flight_from_environment())
+{
+}
+
+FramePacer::FramePacer(size_t frames_in_flight):
+    frames_in_flight(std::max<size_t>(1, frames_in_flight)),
+    fences(this->frames_in_flight, nullptr)
+{
+}
+FramePacer::~FramePacer()
+{
+    for (const auto fence : fences)
+    {
+        if (fence) glDeleteSync(fence);
+    }
+}
+
+auto FramePacer::begin() -> size_t
+{
+    const auto slot = frame % frames_in_flight;
+    auto& fence = fences[slot];
+
+    if (fence)
+    {
+        const auto started = Clock::now();
+
+        // Flush once so the fence is guaranteed to signal, then keep waiting without flushing again.
+        auto flags = GLbitfield(GL_SYNC_FLUSH_COMMANDS_BIT);
+        auto status = GLenum(GL_TIMEOUT_EXPIRED);
+
+        while (status == GL_TIMEOUT_EXPIRED)
+        {
+            status = glClientWaitSync(fence, flags, 100'000'000);
+            flags = 0;
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        if (status == GL_WAIT_FAILED) throw std::runtime_error("Waiting for a frame fence failed.");
+
+        const auto waited = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        wait_ms_total += waited;
+        wait_ms_max = std::max(wait_ms_max, waited);
+    }
+
+    return slot;
+}
+
+auto FramePacer::end() -> void
+{
+    fences[frame % frames_in_flight] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    ++frame;
+}
+
+auto FramePacer::wait_ms_mean() const -> double
+{
+    return frame > 0 ? wait_ms_total / static_cast<double>(frame) : 0.0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Bounds how many frames the driver may queue with one fence per frame.
+//
+//     auto pacer = FramePacer();           // NUTSHELL_FRAMES_IN_FLIGHT, 2 by default
+//
+//     while (...)
+//     {
+//         const auto slot = pacer.begin(); // blocks until the frame N frames back is done on the GPU
+//         ...                              // dynamic buffers indexed by `slot` are safe to write
+//         glfwSwapBuffers(window);
+//         pacer.end();
+//     }
+//
+// Destroy it with the context still current, it deletes the fences of the frames still in flight.
+struct FramePacer
+{
+    using Clock = std::chrono::steady_clock;
+
+    FramePacer();
+    explicit FramePacer(size_t frames_in_flight);
+    FramePacer(const FramePacer&) = delete;
+    ~FramePacer();
+
+    auto operator=(const FramePacer&) -> FramePacer& = delete;
+
+    auto begin() -> size_t;
+    auto end() -> void;
+
+    auto wait_ms_mean() const -> double;
+
+    size_t              frames_in_flight;
+    size_t              frame = 0;
+    std::vector<GLsync> fences;
+    double              wait_ms_total = 0.0;
+    double              wait_ms_max   = 0.0;
+};
@@ -7,6 +7,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <png.h>
+#include <asset_file.hpp>
+#include <profiler.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
 
 struct Vertex {
     glm::vec3 position;
@@ -46,20 +50,11 @@ const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOU
 
 int main() {
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        PROFILE_THREAD("main");
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        auto capture = Capture();
 
-        const auto window = glfwCreateWindow(512, 512, "Perspective", nullptr, nullptr);
-
-        if (!window) throw std::runtime_error("Window creation failed.");
-
-        glfwMakeContextCurrent(window);
-
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        auto surface = Surface(capture, 512, 512, "Perspective");
 
         const auto vertices = std::vector<Vertex>{
             // back vertices
@@ -130,12 +125,15 @@ int main() {
 
         const auto vertexShader = glCreateShader(GL_VERTEX_SHADER);
 
-        glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
-        glCompileShader(vertexShader);
-
         GLint vertexShaderCompileStatus;
 
-        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        {
+            PROFILE_SCOPE("vertex shader compile");
+
+            glShaderSource(vertexShader, 1, VERTEX_SHADER_SOURCES, VERTEX_SHADER_LENGTHS);
+            glCompileShader(vertexShader);
+            glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &vertexShaderCompileStatus);
+        }
 
         if (vertexShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -152,12 +150,15 @@ int main() {
 
         const auto fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-        glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
-        glCompileShader(fragmentShader);
-
         GLint fragmentShaderCompileStatus;
 
-        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        {
+            PROFILE_SCOPE("fragment shader compile");
+
+            glShaderSource(fragmentShader, 1, FRAGMENT_SHADER_SOURCES, FRAGMENT_SHADER_LENGTHS);
+            glCompileShader(fragmentShader);
+            glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &fragmentShaderCompileStatus);
+        }
 
         if (fragmentShaderCompileStatus != GL_TRUE) {
             GLint size = 0;
@@ -174,13 +175,16 @@ int main() {
 
         const auto program = glCreateProgram();
 
-        glAttachShader(program, vertexShader);
-        glAttachShader(program, fragmentShader);
-        glLinkProgram(program);
-
         GLint linkStatus;
 
-        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        {
+            PROFILE_SCOPE("program link");
+
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        }
 
         if (linkStatus != GL_TRUE) {
             GLint size = 0;
@@ -199,17 +203,24 @@ int main() {
         glDeleteShader(fragmentShader);
 
         png_image image = {};
+        std::vector<std::uint8_t> pixels;
+
+        {
+            PROFILE_SCOPE("png decode");
 
-        // memset(&image, 0, sizeof(image));
-        image.version = PNG_IMAGE_VERSION;
+            // memset(&image, 0, sizeof(image));
+            image.version = PNG_IMAGE_VERSION;
 
-        if (png_image_begin_read_from_file(&image, "media/redbricks2b-albedo.png") == 0) throw std::runtime_error("Failed to load image.");
+            const auto file = AssetFile::open("media/redbricks2b-albedo.png");
 
-        image.format = PNG_FORMAT_RGBA;
+            if (png_image_begin_read_from_memory(&image, file.data(), file.size()) == 0) throw std::runtime_error("Failed to load image.");
 
-        std::vector<std::uint8_t> pixels(PNG_IMAGE_SIZE(image));
+            image.format = PNG_FORMAT_RGBA;
 
-        if (png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+            pixels.resize(PNG_IMAGE_SIZE(image));
+
+            if (png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+        }
 
         GLuint texture;
 
@@ -229,84 +240,97 @@ int main() {
         float x = 0.0f;
         float y = 0.0f;
 
-        while (!glfwWindowShouldClose(window))
         {
-            glfwPollEvents();
+            auto pacer = FramePacer();
 
-            if (glfwGetKey(window, GLFW_KEY_UP)) x += glm::radians(1.0f);
-            if (glfwGetKey(window, GLFW_KEY_DOWN)) x -= glm::radians(1.0f);
+            while (surface.open())
+            {
+                PROFILE_SCOPE("frame");
 
-            int width, height;
+                surface.poll();
 
-            glfwGetFramebufferSize(window, &width, &height);
+                pacer.begin();
 
-            glViewport(0, 0, width, height);
-            glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT);
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
-            glFrontFace(GL_CCW);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glBindVertexArray(vertexArrays);
-            glUseProgram(program);
-            glValidateProgram(program);
+                if (surface.key(GLFW_KEY_UP)) x += glm::radians(1.0f);
+                if (surface.key(GLFW_KEY_DOWN)) x -= glm::radians(1.0f);
 
-            GLint validateStatus;
+                int width, height;
 
-            glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
+                surface.size(width, height);
 
-            if (validateStatus != GL_TRUE) {
-                GLint size = 0;
+                glViewport(0, 0, width, height);
+                glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glEnable(GL_CULL_FACE);
+                glCullFace(GL_BACK);
+                glFrontFace(GL_CCW);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glBindVertexArray(vertexArrays);
+                glUseProgram(program);
+                glValidateProgram(program);
 
-                glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+                GLint validateStatus;
 
-                std::string log;
+                glGetProgramiv(program, GL_VALIDATE_STATUS, &validateStatus);
 
-                log.resize(size);
-                glGetProgramInfoLog(program, size, &size, log.data());
+                if (validateStatus != GL_TRUE) {
+                    GLint size = 0;
 
-                throw std::runtime_error(log);
-            }
+                    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
 
-            glm::mat4x3 model = glm::transpose(glm::mat3x4(
-                +glm::cos(y), +0.0f,  +glm::sin(y), +0.0f,
-                +0.0f,        +1.0f,  +0.0f,        +0.0f,
-                -glm::sin(y), +0.0f,  +glm::cos(y), +0.0f
-            ));
-            glm::mat4x3 view = glm::transpose(glm::mat3x4(
-                +1.0f, +0.0f,         +0.0f,         +0.0f,
-                +0.0f, +glm::cos(-x), +glm::sin(-x), +0.0f,
-                +0.0f, -glm::sin(-x), +glm::cos(-x), -2.0f
-            ));
+                    std::string log;
 
-            const auto aspect = static_cast<float>(width) / static_cast<float>(height);
-            const auto fov = glm::radians(60.0f);
-            const auto z_near = 0.01f;
-            const auto z_far = 10.0f;
+                    log.resize(size);
+                    glGetProgramInfoLog(program, size, &size, log.data());
 
-            glm::mat4 projection = glm::transpose(glm::mat4(
-                aspect / glm::cos(fov / 2.0f), 0.0f,                        0.0f,                             0.0f,
-                0.0f,                          1.0f / glm::cos(fov / 2.0f), 0.0f,                             0.0f,
-                0.0f,                          0.0f,                        -(z_far*z_near)/(z_far - z_near), -(2.0f*z_far*z_near)/(z_far - z_near),
-                0.0f,                          0.0f,                        -1.0f,                            0.0f
-            ));
+                    throw std::runtime_error(log);
+                }
 
-            auto transformation = projection * glm::mat4(view) * glm::mat4(model);
+                glm::mat4x3 model = glm::transpose(glm::mat3x4(
+                    +glm::cos(y), +0.0f,  +glm::sin(y), +0.0f,
+                    +0.0f,        +1.0f,  +0.0f,        +0.0f,
+                    -glm::sin(y), +0.0f,  +glm::cos(y), +0.0f
+                ));
+                glm::mat4x3 view = glm::transpose(glm::mat3x4(
+                    +1.0f, +0.0f,         +0.0f,         +0.0f,
+                    +0.0f, +glm::cos(-x), +glm::sin(-x), +0.0f,
+                    +0.0f, -glm::sin(-x), +glm::cos(-x), -2.0f
+                ));
 
-            // y = glm::radians(30.0f);
-            y += glm::radians(1.0f);
+                const auto aspect = static_cast<float>(width) / static_cast<float>(height);
+                const auto fov = glm::radians(60.0f);
+                const auto z_near = 0.01f;
+                const auto z_far = 10.0f;
 
-            glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, glm::value_ptr(transformation));
+                glm::mat4 projection = glm::transpose(glm::mat4(
+                    aspect / glm::cos(fov / 2.0f), 0.0f,                        0.0f,                             0.0f,
+                    0.0f,                          1.0f / glm::cos(fov / 2.0f), 0.0f,                             0.0f,
+                    0.0f,                          0.0f,                        -(z_far*z_near)/(z_far - z_near), -(2.0f*z_far*z_near)/(z_far - z_near),
+                    0.0f,                          0.0f,                        -1.0f,                            0.0f
+                ));
 
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glBindSampler(0, sampler);
+                auto transformation = projection * glm::mat4(view) * glm::mat4(model);
 
-            glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-            glFlush();
+                // y = glm::radians(30.0f);
+                y += glm::radians(1.0f);
 
-            glfwSwapBuffers(window);
+                glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, glm::value_ptr(transformation));
+
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glBindSampler(0, sampler);
+
+                glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+
+                {
+                    PROFILE_SCOPE("present");
+
+                    surface.present();
+                }
+
+                pacer.end();
+            }
         }
 
         glDeleteSamplers(1, &sampler);
@@ -330,8 +354,7 @@ int main() {
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
 
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        PROFILE_WRITE("perspective.trace.json");
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;
@@ -0,0 +1,383 @@
+#include "pixel_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(PIXELS_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace pixels
+{
+    namespace scalar
+    {
+        auto rgb_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            for (size_t i = 0; i < count; ++i, source += 3, destination += 4)
+            {
+                destination[0] = source[0];
+                destination[1] = source[1];
+                destination[2] = source[2];
+                destination[3] = 255;
+            }
+        }
+
+        auto gray_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            for (size_t i = 0; i < count; ++i, source += 1, destination += 4)
+            {
+                destination[0] = source[0];
+                destination[1] = source[0];
+                destination[2] = source[0];
+                destination[3] = 255;
+            }
+        }
+
+        auto gray_alpha_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            for (size_t i = 0; i < count; ++i, source += 2, destination += 4)
+            {
+                destination[0] = source[0];
+                destination[1] = source[0];
+                destination[2] = source[0];
+                destination[3] = source[1];
+            }
+        }
+
+        auto premultiply_alpha(std::uint8_t* rgba, size_t count) -> void
+        {
+            for (size_t i = 0; i < count; ++i, rgba += 4)
+            {
+                const std::uint32_t alpha = rgba[3];
+
+                for (int channel = 0; channel < 3; ++channel)
+                {
+                    // Exact rounded division by 255 without a divide.
+                    const auto product = rgba[channel] * alpha + 128;
+
+                    rgba[channel] = static_cast<std::uint8_t>((product + (product >> 8)) >> 8);
+                }
+            }
+        }
+
+        auto swizzle(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order) -> void
+        {
+            for (size_t i = 0; i < count; ++i, source += 4, destination += 4)
+            {
+                // Through locals, so swizzling in place works.
+                const auto r = source[order[0]];
+                const auto g = source[order[1]];
+                const auto b = source[order[2]];
+                const auto a = source[order[3]];
+
+                destination[0] = r;
+                destination[1] = g;
+                destination[2] = b;
+                destination[3] = a;
+            }
+        }
+
+        auto reduce_16_to_8(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                // Exact rounded division by 257.
+                const std::uint32_t value = source[i] + 128u;
+
+                destination[i] = static_cast<std::uint8_t>((value - (value >> 8)) >> 8);
+            }
+        }
+    }
+
+    const Kernels SCALAR_KERNELS = {
+        Isa::SCALAR,
+        "scalar",
+        scalar::rgb_to_rgba,
+        scalar::gray_to_rgba,
+        scalar::gray_alpha_to_rgba,
+        scalar::premultiply_alpha,
+        scalar::swizzle,
+        scalar::reduce_16_to_8,
+    };
+
+    namespace
+    {
+        // 8-bit sRGB to 16-bit linear, and 12-bit linear (the top bits of the 16) back to 8-bit sRGB.
+        constexpr size_t LINEAR_BITS = 12;
+
+        struct Tables
+        {
+            Tables()
+            {
+                for (size_t i = 0; i < to_linear.size(); ++i)
+                {
+                    const auto c = static_cast<double>(i) / 255.0;
+                    const auto linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+
+                    to_linear[i] = static_cast<std::uint16_t>(std::lround(linear * 65535.0));
+                }
+
+                for (size_t i = 0; i < to_srgb.size(); ++i)
+                {
+                    const auto linear = static_cast<double>(i) / static_cast<double>(to_srgb.size() - 1);
+                    const auto c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+
+                    to_srgb[i] = static_cast<std::uint8_t>(std::lround(c * 255.0));
+                }
+            }
+
+            std::array<std::uint16_t, 256>                to_linear;
+            std::array<std::uint8_t, 1 << LINEAR_BITS>    to_srgb;
+        };
+
+        auto tables() -> const Tables&
+        {
+            static const auto instance = Tables();
+
+            return instance;
+        }
+
+        auto supported(Isa isa) -> bool
+        {
+            switch (isa)
+            {
+            case Isa::SCALAR:
+                return true;
+#if defined(PIXELS_X86) && defined(_MSC_VER)
+            case Isa::SSSE3:
+            {
+                int registers[4];
+
+                __cpuid(registers, 1);
+
+                return (registers[2] & (1 << 9)) != 0;
+            }
+            case Isa::AVX2:
+            {
+                int registers[4];
+
+                __cpuid(registers, 1);
+
+                // The OS must save the YMM registers too.
+                if ((registers[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+                __cpuidex(registers, 7, 0);
+
+                return (registers[1] & (1 << 5)) != 0;
+            }
+#elif defined(PIXELS_X86)
+            case Isa::SSSE3:
+                return __builtin_cpu_supports("ssse3");
+            case Isa::AVX2:
+                return __builtin_cpu_supports("avx2");
+#endif
+#if defined(PIXELS_NEON)
+            case Isa::NEON:
+                return true;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        auto kernels() -> std::vector<const Kernels*>
+        {
+            std::vector<const Kernels*> result = { &SCALAR_KERNELS };
+
+#if defined(PIXELS_X86)
+            if (supported(Isa::SSSE3)) result.push_back(&SSSE3_KERNELS);
+            if (supported(Isa::AVX2)) result.push_back(&AVX2_KERNELS);
+#endif
+#if defined(PIXELS_NEON)
+            if (supported(Isa::NEON)) result.push_back(&NEON_KERNELS);
+#endif
+
+            return result;
+        }
+
+        auto finish_read(png_image& image, std::uint8_t* destination) -> void
+        {
+            if (png_image_finish_read(&image, nullptr, destination, 0, nullptr) == 0) throw std::runtime_error("Failed to load image.");
+        }
+    }
+
+    auto available() -> std::vector<const Kernels*>
+    {
+        return kernels();
+    }
+
+    auto best() -> const Kernels&
+    {
+        static const auto selected = kernels().back();
+
+        return *selected;
+    }
+
+    auto srgb_to_linear(const std::uint8_t* source, std::uint16_t* destination, size_t count) -> void
+    {
+        const auto& table = tables().to_linear;
+
+        for (size_t i = 0; i < count; ++i, source += 4, destination += 4)
+        {
+            destination[0] = table[source[0]];
+            destination[1] = table[source[1]];
+            destination[2] = table[source[2]];
+            destination[3] = static_cast<std::uint16_t>(source[3] * 257);
+        }
+    }
+
+    auto linear_to_srgb(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void
+    {
+        const auto& table = tables().to_srgb;
+
+        for (size_t i = 0; i < count; ++i, source += 4, destination += 4)
+        {
+            destination[0] = table[source[0] >> (16 - LINEAR_BITS)];
+            destination[1] = table[source[1] >> (16 - LINEAR_BITS)];
+            destination[2] = table[source[2] >> (16 - LINEAR_BITS)];
+            scalar::reduce_16_to_8(source + 3, destination + 3, 1);
+        }
+    }
+
+    auto read_png_rgba(png_image& image, std::uint8_t* destination) -> void
+    {
+        const auto count = static_cast<size_t>(image.width) * image.height;
+        const auto color = (image.format & PNG_FORMAT_FLAG_COLOR) != 0;
+        const auto alpha = (image.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+
+        if (color && alpha)
+        {
+            image.format = PNG_FORMAT_RGBA;
+
+            return finish_read(image, destination);
+        }
+
+        // Palettes without transparency come out as RGB, 16-bit files are reduced by libpng like before.
+        image.format = color ? PNG_FORMAT_RGB : alpha ? PNG_FORMAT_GA : PNG_FORMAT_GRAY;
+
+        std::vector<std::uint8_t> decoded(PNG_IMAGE_SIZE(image));
+
+        finish_read(image, decoded.data());
+
+        const auto& kernels = best();
+
+        if (color) kernels.rgb_to_rgba(decoded.data(), destination, count);
+        else if (alpha) kernels.gray_alpha_to_rgba(decoded.data(), destination, count);
+        else kernels.gray_to_rgba(decoded.data(), destination, count);
+    }
+
+    auto analyze_channels(const std::uint8_t* rgba, size_t count) -> ChannelLayout
+    {
+        std::array<std::uint8_t, 4> all = { 255, 255, 255, 255 };
+        std::array<std::uint8_t, 4> any = { 0, 0, 0, 0 };
+        std::uint8_t color = 0;
+
+        // Branch-free so the compiler vectorizes it, the image is usually still in cache from decoding.
+        for (size_t i = 0; i < count; ++i, rgba += 4)
+        {
+            for (size_t channel = 0; channel < 4; ++channel)
+            {
+                all[channel] &= rgba[channel];
+                any[channel] |= rgba[channel];
+            }
+
+            color |= static_cast<std::uint8_t>((rgba[0] ^ rgba[1]) | (rgba[1] ^ rgba[2]));
+        }
+
+        auto layout = ChannelLayout();
+
+        layout.channels = 0;
+
+        const auto place = [&](std::uint8_t channel) -> std::uint8_t
+        {
+            if (any[channel] == 0) return ChannelLayout::ZERO;
+            if (all[channel] == 255) return ChannelLayout::ONE;
+
+            layout.source[layout.channels] = channel;
+
+            return static_cast<std::uint8_t>(layout.channels++);
+        };
+
+        if (color == 0)
+        {
+            layout.swizzle[0] = layout.swizzle[1] = layout.swizzle[2] = place(0);
+        }
+        else
+        {
+            for (std::uint8_t channel = 0; channel < 3; ++channel) layout.swizzle[channel] = place(channel);
+        }
+
+        layout.swizzle[3] = place(3);
+
+        // A constant image still needs one channel to have a texture at all.
+        if (layout.channels == 0) layout.source[layout.channels++] = 0;
+
+        // Three channels stay RGBA8: drivers store RGB8 as RGBA8 anyway and RGB uploads leave the fast path.
+        if (layout.channels == 3) return ChannelLayout();
+
+        return layout;
+    }
+
+    auto pack_channels(const std::uint8_t* rgba, std::uint8_t* destination, size_t count, const ChannelLayout& layout) -> void
+    {
+        const auto& source = layout.source;
+
+        // Pixel i is read whole before it is written at i * channels, so packing in place never overtakes the reads.
+        switch (layout.channels)
+        {
+        case 1:
+            for (size_t i = 0; i < count; ++i, rgba += 4, destination += 1)
+            {
+                destination[0] = rgba[source[0]];
+            }
+
+            break;
+        case 2:
+            for (size_t i = 0; i < count; ++i, rgba += 4, destination += 2)
+            {
+                const auto a = rgba[source[0]];
+                const auto b = rgba[source[1]];
+
+                destination[0] = a;
+                destination[1] = b;
+            }
+
+            break;
+        default:
+            // All four kept means nothing moved.
+            if (destination != rgba) std::memcpy(destination, rgba, count * 4);
+
+            break;
+        }
+    }
+
+    auto downscale_half(const std::uint8_t* source, std::uint32_t width, std::uint32_t height, size_t channels, std::uint8_t* destination) -> void
+    {
+        const auto half_width = std::max<std::uint32_t>(width / 2, 1);
+        const auto half_height = std::max<std::uint32_t>(height / 2, 1);
+        const auto pitch = static_cast<size_t>(width) * channels;
+
+        for (std::uint32_t y = 0; y < half_height; ++y)
+        {
+            // Rows 2y and 2y + 1, or the single row of a one pixel high image.
+            const auto top = source + static_cast<size_t>(std::min(y * 2, height - 1)) * pitch;
+            const auto bottom = source + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * pitch;
+
+            for (std::uint32_t x = 0; x < half_width; ++x, destination += channels)
+            {
+                const auto left = static_cast<size_t>(std::min(x * 2, width - 1)) * channels;
+                const auto right = static_cast<size_t>(std::min(x * 2 + 1, width - 1)) * channels;
+
+                for (size_t channel = 0; channel < channels; ++channel)
+                {
+                    const auto sum = top[left + channel] + top[right + channel] + bottom[left + channel] + bottom[right + channel];
+
+                    destination[channel] = static_cast<std::uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
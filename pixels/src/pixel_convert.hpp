@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <png.h>
+
+// Pixel format conversions over decoded rows, `count` is always in pixels.
+// Each instruction set has its own table of kernels, best() picks the widest one the CPU supports at runtime.
+//
+//     pixels::best().rgb_to_rgba(rgb, rgba, width * height);
+namespace pixels
+{
+    enum class Isa
+    {
+        SCALAR,
+        SSSE3,
+        AVX2,
+        NEON,
+    };
+
+    struct Kernels
+    {
+        Isa         isa;
+        const char* name;
+
+        // Alpha of the expanded pixels is 255.
+        void (*rgb_to_rgba)(const std::uint8_t* source, std::uint8_t* destination, size_t count);
+        void (*gray_to_rgba)(const std::uint8_t* source, std::uint8_t* destination, size_t count);
+        void (*gray_alpha_to_rgba)(const std::uint8_t* source, std::uint8_t* destination, size_t count);
+        // In place, rounds c * a / 255.
+        void (*premultiply_alpha)(std::uint8_t* rgba, size_t count);
+        // destination[i] = source[order[i]] for the four bytes of every pixel, e.g. { 2, 1, 0, 3 } for RGBA <-> BGRA.
+        void (*swizzle)(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order);
+        // Native endian 16-bit channels to 8-bit, rounds v / 257. `count` is in channels.
+        void (*reduce_16_to_8)(const std::uint16_t* source, std::uint8_t* destination, size_t count);
+    };
+
+    // Every table the CPU can run, scalar first and best() last.
+    auto available() -> std::vector<const Kernels*>;
+    auto best() -> const Kernels&;
+
+    // Table lookups, the same on every instruction set. Alpha stays linear, it is only widened or narrowed.
+    auto srgb_to_linear(const std::uint8_t* source, std::uint16_t* destination, size_t count) -> void;
+    auto linear_to_srgb(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void;
+
+    // Finishes a png_image_begin_read_*() into tightly packed RGBA8. libpng only decodes the file's own
+    // channels and the expansion runs through best(), instead of libpng's per-pixel alpha and gray transforms.
+    auto read_png_rgba(png_image& image, std::uint8_t* destination) -> void;
+
+    // Channels of an RGBA8 image that carry information: channels that are 0 or 255 everywhere are dropped and
+    // come back through the swizzle, gray color is kept once. Three left over keep all four.
+    struct ChannelLayout
+    {
+        static constexpr std::uint8_t ZERO = 4;
+        static constexpr std::uint8_t ONE  = 5;
+
+        // Kept channels per pixel: 1, 2 or 4.
+        size_t                      channels = 4;
+        // RGBA channel stored in each kept one.
+        std::array<std::uint8_t, 4> source   = { 0, 1, 2, 3 };
+        // What sampling returns for R, G, B and A: a kept channel, ZERO or ONE.
+        std::array<std::uint8_t, 4> swizzle  = { 0, 1, 2, 3 };
+    };
+
+    auto analyze_channels(const std::uint8_t* rgba, size_t count) -> ChannelLayout;
+    // The kept channels of `layout`, tightly packed. `destination` may be `rgba`.
+    auto pack_channels(const std::uint8_t* rgba, std::uint8_t* destination, size_t count, const ChannelLayout& layout) -> void;
+
+    // Half of `width` x `height` pixels of `channels` bytes each, rounded down but at least one, as the rounded
+    // average of every 2x2 block. An odd last row or column is dropped, like GL's mip level sizes.
+    auto downscale_half(const std::uint8_t* source, std::uint32_t width, std::uint32_t height, size_t channels, std::uint8_t* destination) -> void;
+}
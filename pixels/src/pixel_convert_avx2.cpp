@@ -0,0 +1,184 @@
+#include "pixel_kernels.hpp"
+
+#include <immintrin.h>
+
+namespace pixels
+{
+    namespace
+    {
+        // Inline rather than a namespace scope constant: static initializers run before any CPU check.
+        inline auto opaque() -> __m256i
+        {
+            return _mm256_set1_epi32(static_cast<int>(0xFF000000));
+        }
+
+        // Both 128-bit lanes get their own 16 bytes, vpshufb never crosses lanes.
+        inline auto load_lanes(const std::uint8_t* low, const std::uint8_t* high) -> __m256i
+        {
+            const auto lane = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low)));
+
+            return _mm256_inserti128_si256(lane, _mm_loadu_si128(reinterpret_cast<const __m128i*>(high)), 1);
+        }
+
+        auto rgb_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const auto shuffle = _mm256_setr_epi8(
+                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+            );
+
+            size_t i = 0;
+
+            // Eight pixels from two overlapping 16 byte loads, the second one ends 4 bytes past the last pixel.
+            for (; i + 10 <= count; i += 8)
+            {
+                const auto rgb = load_lanes(source + i * 3, source + i * 3 + 12);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), opaque()));
+            }
+
+            scalar::rgb_to_rgba(source + i * 3, destination + i * 4, count - i);
+        }
+
+        auto gray_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const auto low = _mm256_setr_epi8(
+                0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1,
+                4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1
+            );
+            const auto high = _mm256_setr_epi8(
+                8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1,
+                12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1
+            );
+
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto gray = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(gray, low), opaque()));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4 + 32), _mm256_or_si256(_mm256_shuffle_epi8(gray, high), opaque()));
+            }
+
+            scalar::gray_to_rgba(source + i, destination + i * 4, count - i);
+        }
+
+        auto gray_alpha_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const auto shuffle = _mm256_setr_epi8(
+                0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7,
+                8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15
+            );
+
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto first = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2)));
+                const auto second = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16)));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_shuffle_epi8(first, shuffle));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4 + 32), _mm256_shuffle_epi8(second, shuffle));
+            }
+
+            scalar::gray_alpha_to_rgba(source + i * 2, destination + i * 4, count - i);
+        }
+
+        // Same arithmetic as the SSSE3 kernel, eight pixels at a time.
+        auto premultiply_alpha(std::uint8_t* rgba, size_t count) -> void
+        {
+            const auto broadcast = _mm256_setr_epi8(
+                3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1,
+                3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1
+            );
+            const auto zero = _mm256_setzero_si256();
+            const auto rounding = _mm256_set1_epi16(128);
+
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i * 4));
+                const auto factors = _mm256_or_si256(_mm256_shuffle_epi8(pixels, broadcast), opaque());
+
+                auto low = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pixels, zero), _mm256_unpacklo_epi8(factors, zero)), rounding);
+                auto high = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pixels, zero), _mm256_unpackhi_epi8(factors, zero)), rounding);
+
+                low = _mm256_srli_epi16(_mm256_add_epi16(low, _mm256_srli_epi16(low, 8)), 8);
+                high = _mm256_srli_epi16(_mm256_add_epi16(high, _mm256_srli_epi16(high, 8)), 8);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), _mm256_packus_epi16(low, high));
+            }
+
+            scalar::premultiply_alpha(rgba + i * 4, count - i);
+        }
+
+        auto swizzle(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order) -> void
+        {
+            alignas(32) std::uint8_t indices[32];
+
+            for (int pixel = 0; pixel < 8; ++pixel)
+            {
+                for (int channel = 0; channel < 4; ++channel) indices[pixel * 4 + channel] = static_cast<std::uint8_t>((pixel & 3) * 4 + (order[channel] & 3));
+            }
+
+            const auto shuffle = _mm256_load_si256(reinterpret_cast<const __m256i*>(indices));
+
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i * 4), _mm256_shuffle_epi8(pixels, shuffle));
+            }
+
+            scalar::swizzle(source + i * 4, destination + i * 4, count - i, order);
+        }
+
+        // Unpacks and packs are per lane, so the 16 values come back in order.
+        auto reduce(__m256i values) -> __m256i
+        {
+            const auto zero = _mm256_setzero_si256();
+            const auto rounding = _mm256_set1_epi32(128);
+
+            auto low = _mm256_add_epi32(_mm256_unpacklo_epi16(values, zero), rounding);
+            auto high = _mm256_add_epi32(_mm256_unpackhi_epi16(values, zero), rounding);
+
+            low = _mm256_srli_epi32(_mm256_sub_epi32(low, _mm256_srli_epi32(low, 8)), 8);
+            high = _mm256_srli_epi32(_mm256_sub_epi32(high, _mm256_srli_epi32(high, 8)), 8);
+
+            return _mm256_packs_epi32(low, high);
+        }
+
+        auto reduce_16_to_8(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 32 <= count; i += 32)
+            {
+                const auto low = reduce(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+                const auto high = reduce(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16)));
+
+                // The byte pack interleaves the lanes of both halves, put the 64-bit quarters back in order.
+                const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), packed);
+            }
+
+            scalar::reduce_16_to_8(source + i, destination + i, count - i);
+        }
+    }
+
+    const Kernels AVX2_KERNELS = {
+        Isa::AVX2,
+        "avx2",
+        rgb_to_rgba,
+        gray_to_rgba,
+        gray_alpha_to_rgba,
+        premultiply_alpha,
+        swizzle,
+        reduce_16_to_8,
+    };
+}
@@ -0,0 +1,128 @@
+#include "pixel_kernels.hpp"
+
+#include <arm_neon.h>
+
+namespace pixels
+{
+    namespace
+    {
+        // NEON has (de)interleaving loads and stores, so the expansions are a vldN / vst4 pair per 16 pixels.
+        auto rgb_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto rgb = vld3q_u8(source + i * 3);
+                const auto rgba = uint8x16x4_t{ { rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255) } };
+
+                vst4q_u8(destination + i * 4, rgba);
+            }
+
+            scalar::rgb_to_rgba(source + i * 3, destination + i * 4, count - i);
+        }
+
+        auto gray_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto gray = vld1q_u8(source + i);
+                const auto rgba = uint8x16x4_t{ { gray, gray, gray, vdupq_n_u8(255) } };
+
+                vst4q_u8(destination + i * 4, rgba);
+            }
+
+            scalar::gray_to_rgba(source + i, destination + i * 4, count - i);
+        }
+
+        auto gray_alpha_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto gray_alpha = vld2q_u8(source + i * 2);
+                const auto rgba = uint8x16x4_t{ { gray_alpha.val[0], gray_alpha.val[0], gray_alpha.val[0], gray_alpha.val[1] } };
+
+                vst4q_u8(destination + i * 4, rgba);
+            }
+
+            scalar::gray_alpha_to_rgba(source + i * 2, destination + i * 4, count - i);
+        }
+
+        // (c * a + 128 + ((c * a + 128) >> 8)) >> 8, vrshrn adds the 128 of the outer shift.
+        inline auto premultiply(uint8x8_t channel, uint8x8_t alpha) -> uint8x8_t
+        {
+            const auto product = vmull_u8(channel, alpha);
+
+            return vrshrn_n_u16(vrsraq_n_u16(product, product, 8), 8);
+        }
+
+        auto premultiply_alpha(std::uint8_t* rgba, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                auto pixels = vld4_u8(rgba + i * 4);
+
+                pixels.val[0] = premultiply(pixels.val[0], pixels.val[3]);
+                pixels.val[1] = premultiply(pixels.val[1], pixels.val[3]);
+                pixels.val[2] = premultiply(pixels.val[2], pixels.val[3]);
+
+                vst4_u8(rgba + i * 4, pixels);
+            }
+
+            scalar::premultiply_alpha(rgba + i * 4, count - i);
+        }
+
+        auto swizzle(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto pixels = vld4q_u8(source + i * 4);
+                const auto swizzled = uint8x16x4_t{ {
+                    pixels.val[order[0] & 3],
+                    pixels.val[order[1] & 3],
+                    pixels.val[order[2] & 3],
+                    pixels.val[order[3] & 3],
+                } };
+
+                vst4q_u8(destination + i * 4, swizzled);
+            }
+
+            scalar::swizzle(source + i * 4, destination + i * 4, count - i, order);
+        }
+
+        auto reduce_16_to_8(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                // v - (v + 128 >> 8) stays within 16 bits, the final rounding shift adds the 128 back.
+                const auto values = vld1q_u16(source + i);
+                const auto rounded = vsubq_u16(values, vshrq_n_u16(vaddq_u16(vshrq_n_u16(values, 1), vdupq_n_u16(64)), 7));
+
+                vst1_u8(destination + i, vrshrn_n_u16(rounded, 8));
+            }
+
+            scalar::reduce_16_to_8(source + i, destination + i, count - i);
+        }
+    }
+
+    const Kernels NEON_KERNELS = {
+        Isa::NEON,
+        "neon",
+        rgb_to_rgba,
+        gray_to_rgba,
+        gray_alpha_to_rgba,
+        premultiply_alpha,
+        swizzle,
+        reduce_16_to_8,
+    };
+}
@@ -0,0 +1,171 @@
+#include "pixel_kernels.hpp"
+
+#include <tmmintrin.h>
+
+namespace pixels
+{
+    namespace
+    {
+        // Inline rather than a namespace scope constant: static initializers run before any CPU check.
+        inline auto opaque() -> __m128i
+        {
+            return _mm_set1_epi32(static_cast<int>(0xFF000000));
+        }
+
+        auto rgb_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const auto shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+
+            size_t i = 0;
+
+            // Four pixels per 16 byte load, of which 12 are used: stop while the load still fits in the row.
+            for (; i + 6 <= count; i += 4)
+            {
+                const auto rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), opaque()));
+            }
+
+            scalar::rgb_to_rgba(source + i * 3, destination + i * 4, count - i);
+        }
+
+        auto gray_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const __m128i shuffles[] = {
+                _mm_setr_epi8(0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1),
+                _mm_setr_epi8(4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1),
+                _mm_setr_epi8(8, 8, 8, -1, 9, 9, 9, -1, 10, 10, 10, -1, 11, 11, 11, -1),
+                _mm_setr_epi8(12, 12, 12, -1, 13, 13, 13, -1, 14, 14, 14, -1, 15, 15, 15, -1),
+            };
+
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto gray = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+
+                for (int part = 0; part < 4; ++part)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + (i + part * 4) * 4), _mm_or_si128(_mm_shuffle_epi8(gray, shuffles[part]), opaque()));
+                }
+            }
+
+            scalar::gray_to_rgba(source + i, destination + i * 4, count - i);
+        }
+
+        auto gray_alpha_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            const auto low = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+            const auto high = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                const auto gray_alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_shuffle_epi8(gray_alpha, low));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4 + 16), _mm_shuffle_epi8(gray_alpha, high));
+            }
+
+            scalar::gray_alpha_to_rgba(source + i * 2, destination + i * 4, count - i);
+        }
+
+        // (c * a + 128 + ((c * a + 128) >> 8)) >> 8 on 16-bit lanes, alpha multiplies itself by 255 and stays the same.
+        auto premultiply(__m128i rgba, __m128i factors) -> __m128i
+        {
+            const auto zero = _mm_setzero_si128();
+            const auto rounding = _mm_set1_epi16(128);
+
+            auto low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(rgba, zero), _mm_unpacklo_epi8(factors, zero)), rounding);
+            auto high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(rgba, zero), _mm_unpackhi_epi8(factors, zero)), rounding);
+
+            low = _mm_srli_epi16(_mm_add_epi16(low, _mm_srli_epi16(low, 8)), 8);
+            high = _mm_srli_epi16(_mm_add_epi16(high, _mm_srli_epi16(high, 8)), 8);
+
+            return _mm_packus_epi16(low, high);
+        }
+
+        auto premultiply_alpha(std::uint8_t* rgba, size_t count) -> void
+        {
+            const auto broadcast = _mm_setr_epi8(3, 3, 3, -1, 7, 7, 7, -1, 11, 11, 11, -1, 15, 15, 15, -1);
+
+            size_t i = 0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i * 4));
+                const auto factors = _mm_or_si128(_mm_shuffle_epi8(pixels, broadcast), opaque());
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), premultiply(pixels, factors));
+            }
+
+            scalar::premultiply_alpha(rgba + i * 4, count - i);
+        }
+
+        auto swizzle(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order) -> void
+        {
+            alignas(16) std::uint8_t indices[16];
+
+            for (int pixel = 0; pixel < 4; ++pixel)
+            {
+                for (int channel = 0; channel < 4; ++channel) indices[pixel * 4 + channel] = static_cast<std::uint8_t>(pixel * 4 + (order[channel] & 3));
+            }
+
+            const auto shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(indices));
+
+            size_t i = 0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+            }
+
+            scalar::swizzle(source + i * 4, destination + i * 4, count - i, order);
+        }
+
+        // (v + 128 - ((v + 128) >> 8)) >> 8 needs 17 bits, so it runs on 32-bit lanes.
+        auto reduce(__m128i values) -> __m128i
+        {
+            const auto zero = _mm_setzero_si128();
+            const auto rounding = _mm_set1_epi32(128);
+
+            auto low = _mm_add_epi32(_mm_unpacklo_epi16(values, zero), rounding);
+            auto high = _mm_add_epi32(_mm_unpackhi_epi16(values, zero), rounding);
+
+            low = _mm_srli_epi32(_mm_sub_epi32(low, _mm_srli_epi32(low, 8)), 8);
+            high = _mm_srli_epi32(_mm_sub_epi32(high, _mm_srli_epi32(high, 8)), 8);
+
+            // Results are at most 255, so the signed packs cannot saturate.
+            return _mm_packs_epi32(low, high);
+        }
+
+        auto reduce_16_to_8(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void
+        {
+            size_t i = 0;
+
+            for (; i + 16 <= count; i += 16)
+            {
+                const auto low = reduce(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)));
+                const auto high = reduce(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8)));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(low, high));
+            }
+
+            scalar::reduce_16_to_8(source + i, destination + i, count - i);
+        }
+    }
+
+    const Kernels SSSE3_KERNELS = {
+        Isa::SSSE3,
+        "ssse3",
+        rgb_to_rgba,
+        gray_to_rgba,
+        gray_alpha_to_rgba,
+        premultiply_alpha,
+        swizzle,
+        reduce_16_to_8,
+    };
+}
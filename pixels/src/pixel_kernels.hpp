@@ -0,0 +1,23 @@
+#pragma once
+
+#include "pixel_convert.hpp"
+
+// Per instruction set tables, each defined in its own translation unit built with the matching compiler flags.
+// The vector kernels hand their remainder to the scalar ones.
+namespace pixels
+{
+    extern const Kernels SCALAR_KERNELS;
+    extern const Kernels SSSE3_KERNELS;
+    extern const Kernels AVX2_KERNELS;
+    extern const Kernels NEON_KERNELS;
+
+    namespace scalar
+    {
+        auto rgb_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void;
+        auto gray_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void;
+        auto gray_alpha_to_rgba(const std::uint8_t* source, std::uint8_t* destination, size_t count) -> void;
+        auto premultiply_alpha(std::uint8_t* rgba, size_t count) -> void;
+        auto swizzle(const std::uint8_t* source, std::uint8_t* destination, size_t count, std::array<std::uint8_t, 4> order) -> void;
+        auto reduce_16_to_8(const std::uint16_t* source, std::uint8_t* destination, size_t count) -> void;
+    }
+}
@@ -0,0 +1,203 @@
+#include "profiler.hpp"
+
+#if PROFILER_ENABLED
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#if PROFILER_RDTSC && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif
+#   define PROFILER_USE_RDTSC 1
+#else
+#   define PROFILER_USE_RDTSC 0
+#endif
+
+namespace profiler
+{
+    namespace
+    {
+        constexpr size_t CHUNK_SIZE = 4096;
+
+        struct Chunk
+        {
+            std::array<Event, CHUNK_SIZE> events;
+            std::atomic<size_t>           count = 0;
+            std::atomic<Chunk*>           next = nullptr;
+            std::unique_ptr<Chunk>        owned_next;
+        };
+
+        // Only the owning thread appends; write() reads the published counts, so recording never takes a lock.
+        struct Buffer
+        {
+            Buffer(std::uint32_t id):
+                id(id),
+                head(std::make_unique<Chunk>()),
+                tail(head.get())
+            {
+            }
+
+            auto push(const Event& event) -> void
+            {
+                auto count = tail->count.load(std::memory_order_relaxed);
+
+                if (count == CHUNK_SIZE)
+                {
+                    tail->owned_next = std::make_unique<Chunk>();
+                    tail->next.store(tail->owned_next.get(), std::memory_order_release);
+                    tail = tail->owned_next.get();
+                    count = 0;
+                }
+
+                tail->events[count] = event;
+                tail->count.store(count + 1, std::memory_order_release);
+            }
+
+            std::uint32_t            id;
+            std::atomic<const char*> name = nullptr;
+            std::unique_ptr<Chunk>   head;
+            Chunk*                   tail;
+        };
+
+        struct Calibration
+        {
+            static auto capture() -> Calibration
+            {
+                return { now(), std::chrono::steady_clock::now() };
+            }
+
+            std::uint64_t                         ticks;
+            std::chrono::steady_clock::time_point time;
+        };
+
+        struct Registry
+        {
+            std::mutex                           mutex;
+            std::vector<std::shared_ptr<Buffer>> buffers;
+        };
+
+        const auto START = Calibration::capture();
+
+        auto registry() -> Registry&
+        {
+            static Registry instance;
+
+            return instance;
+        }
+
+        auto buffer() -> Buffer&
+        {
+            thread_local const auto local = []
+            {
+                auto& r = registry();
+                auto lock = std::lock_guard(r.mutex);
+                auto b = std::make_shared<Buffer>(static_cast<std::uint32_t>(r.buffers.size() + 1));
+
+                r.buffers.push_back(b);
+
+                return b;
+            }();
+
+            return *local;
+        }
+
+        auto escape(std::ostream& stream, const char* text) -> void
+        {
+            for (auto c = text; *c; ++c)
+            {
+                switch (*c)
+                {
+                    case '"':  stream << "\\\""; break;
+                    case '\\': stream << "\\\\"; break;
+                    case '\n': stream << "\\n"; break;
+                    case '\t': stream << "\\t"; break;
+                    default:   stream << *c; break;
+                }
+            }
+        }
+    }
+
+    auto now() -> std::uint64_t
+    {
+#if PROFILER_USE_RDTSC
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    auto record(const char* name, std::uint64_t begin, std::uint64_t end) -> void
+    {
+        buffer().push({ name, begin, end });
+    }
+
+    auto name_thread(const char* name) -> void
+    {
+        buffer().name.store(name, std::memory_order_relaxed);
+    }
+
+    auto write(const std::string& path) -> void
+    {
+        const auto stop = Calibration::capture();
+        const auto elapsed = std::chrono::duration<double, std::micro>(stop.time - START.time).count();
+        const auto ticks_per_us = elapsed > 0.0 ? static_cast<double>(stop.ticks - START.ticks) / elapsed : 1000.0;
+
+        std::vector<std::shared_ptr<Buffer>> buffers;
+
+        {
+            auto& r = registry();
+            auto lock = std::lock_guard(r.mutex);
+
+            buffers = r.buffers;
+        }
+
+        std::ofstream stream(path);
+
+        if (!stream) throw std::runtime_error("Failed to open trace file " + path + ".");
+
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"opengl_in_a_nutshell\"}}";
+
+        stream.precision(3);
+        stream << std::fixed;
+
+        for (const auto& b : buffers)
+        {
+            if (const auto name = b->name.load(std::memory_order_relaxed))
+            {
+                stream << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->id << ",\"args\":{\"name\":\"";
+                escape(stream, name);
+                stream << "\"}}";
+            }
+
+            for (auto chunk = b->head.get(); chunk; chunk = chunk->next.load(std::memory_order_acquire))
+            {
+                const auto count = chunk->count.load(std::memory_order_acquire);
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const auto& event = chunk->events[i];
+                    const auto ts = static_cast<double>(static_cast<std::int64_t>(event.begin - START.ticks)) / ticks_per_us;
+                    const auto dur = static_cast<double>(event.end - event.begin) / ticks_per_us;
+
+                    stream << ",\n{\"name\":\"";
+                    escape(stream, event.name);
+                    stream << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->id << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+                }
+            }
+        }
+
+        stream << "\n]}\n";
+    }
+}
+
+#endif
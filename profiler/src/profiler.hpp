@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped CPU zones written as chrome://tracing / Perfetto JSON.
+// Configure with -DPROFILER_ENABLED=ON, otherwise every macro below expands to nothing.
+//
+//     PROFILE_SCOPE("Mesh::from");
+//     PROFILE_THREAD("loader");
+//     PROFILE_WRITE("depth_test.trace.json");
+
+#if PROFILER_ENABLED
+
+namespace profiler
+{
+    // Zone names are not copied, pass string literals only.
+    struct Event
+    {
+        const char*   name;
+        std::uint64_t begin;
+        std::uint64_t end;
+    };
+
+    auto now() -> std::uint64_t;
+    auto record(const char* name, std::uint64_t begin, std::uint64_t end) -> void;
+    auto name_thread(const char* name) -> void;
+    auto write(const std::string& path) -> void;
+
+    struct Zone
+    {
+        Zone(const char* name):
+            name(name),
+            begin(now())
+        {
+        }
+        Zone(const Zone&) = delete;
+        ~Zone()
+        {
+            record(name, begin, now());
+        }
+
+        auto operator=(const Zone&) -> Zone& = delete;
+
+        const char*   name;
+        std::uint64_t begin;
+    };
+}
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) ::profiler::Zone PROFILER_CONCAT(profiler_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) ::profiler::name_thread(name)
+#define PROFILE_WRITE(path) ::profiler::write(path)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#define PROFILE_WRITE(path) ((void)0)
+
+#endif
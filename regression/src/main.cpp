@@ -0,0 +1,309 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <png.h>
+
+constexpr int PASSED = 0;
+constexpr int FAILED = 1;
+
+struct Options
+{
+    static auto from(int argc, char** argv) -> Options
+    {
+        Options options;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto argument = std::string(argv[i]);
+            const auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument + ".");
+
+                return argv[++i];
+            };
+
+            if (argument == "--") { for (++i; i < argc; ++i) options.arguments.push_back(argv[i]); }
+            else if (argument == "--name") options.name = value();
+            else if (argument == "--sample") options.sample = value();
+            else if (argument == "--directory") options.directory = value();
+            else if (argument == "--golden") options.golden = value();
+            else if (argument == "--baseline") options.baseline = value();
+            else if (argument == "--output") options.output = value();
+            else if (argument == "--frames") options.frames = std::stoul(value());
+            else if (argument == "--pixel-threshold") options.pixel_threshold = std::stod(value());
+            else if (argument == "--max-mismatch") options.max_mismatch = std::stod(value());
+            else if (argument == "--time-tolerance") options.time_tolerance = std::stod(value());
+            else if (argument == "--time-slack") options.time_slack = std::stod(value());
+            else if (argument == "--startup-slack") options.startup_slack = std::stod(value());
+            else if (argument == "--timings") options.timings = true;
+            else if (argument == "--update") options.update = true;
+            else throw std::runtime_error("Unknown argument " + argument + ".");
+        }
+
+        if (options.name.empty() || options.sample.empty() || options.golden.empty() || options.baseline.empty() || options.output.empty())
+        {
+            throw std::runtime_error("Usage: regression --name <name> --sample <executable> --golden <png> --baseline <json> --output <directory> [--timings] [-- <sample arguments>]");
+        }
+
+        if (const auto update = std::getenv("REGRESSION_UPDATE"); update && std::string(update) == "1") options.update = true;
+
+        return options;
+    }
+
+    std::string              name;
+    std::string              sample;
+    std::string              directory = ".";
+    std::string              golden;
+    std::string              baseline;
+    std::string              output;
+    std::vector<std::string> arguments;
+    size_t                   frames          = 60;
+    double                   pixel_threshold = 0.1;   // Per pixel YIQ distance, 0..1 like pixelmatch.
+    double                   max_mismatch    = 0.001; // Share of pixels allowed to exceed it.
+    double                   time_tolerance  = 0.25;  // Allowed relative slowdown against the baseline.
+    double                   time_slack      = 2.0;   // Milliseconds on top, keeps tiny timings from flapping.
+    double                   startup_slack   = 25.0;  // The same for startup, context creation and shader JIT on llvmpipe jitter by tens of ms.
+    // Also hold startup and frame times to the baseline, which only means something on the machine that recorded it.
+    bool                     timings         = false;
+    bool                     update          = false;
+};
+
+struct Image
+{
+    static auto load(const std::string& path) -> Image
+    {
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+
+        if (png_image_begin_read_from_file(&image, path.c_str()) == 0) throw std::runtime_error("Failed to load image " + path + ".");
+
+        image.format = PNG_FORMAT_RGB;
+
+        Image result { image.width, image.height, std::vector<std::uint8_t>(PNG_IMAGE_SIZE(image)) };
+
+        if (png_image_finish_read(&image, nullptr, result.pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to load image " + path + ".");
+
+        return result;
+    }
+
+    auto save(const std::string& path) const -> void
+    {
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+        image.width = width;
+        image.height = height;
+        image.format = PNG_FORMAT_RGB;
+
+        if (png_image_write_to_file(&image, path.c_str(), 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to write image " + path + ".");
+    }
+
+    std::uint32_t             width;
+    std::uint32_t             height;
+    std::vector<std::uint8_t> pixels;
+};
+
+// Perceptual color distance in YIQ space, normalized to 0..1 (Kotsarenko and Ramos, as used by pixelmatch).
+auto distance(const std::uint8_t* a, const std::uint8_t* b) -> double
+{
+    const auto r = static_cast<double>(a[0]) - b[0];
+    const auto g = static_cast<double>(a[1]) - b[1];
+    const auto bl = static_cast<double>(a[2]) - b[2];
+
+    const auto y = r * 0.29889531 + g * 0.58662247 + bl * 0.11448223;
+    const auto i = r * 0.59597799 - g * 0.27417610 - bl * 0.32180189;
+    const auto q = r * 0.21147017 - g * 0.52261711 + bl * 0.31114694;
+
+    return std::sqrt((0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q) / 35215.0);
+}
+
+auto read_metrics(const std::string& path) -> std::string
+{
+    std::ifstream stream(path);
+
+    if (!stream) throw std::runtime_error("Failed to read metrics " + path + ".");
+
+    std::stringstream buffer;
+
+    buffer << stream.rdbuf();
+
+    return buffer.str();
+}
+
+auto number(const std::string& json, const std::string& key) -> double
+{
+    const auto position = json.find("\"" + key + "\"");
+
+    if (position == std::string::npos) throw std::runtime_error("Metrics have no " + key + ".");
+
+    const auto colon = json.find(':', position);
+
+    return std::strtod(json.c_str() + colon + 1, nullptr);
+}
+
+auto set_environment(const char* name, const std::string& value) -> void
+{
+#if defined(_WIN32)
+    _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), 1);
+#endif
+}
+
+auto quote(const std::string& text) -> std::string
+{
+    return "\"" + text + "\"";
+}
+
+auto run(const Options& options) -> int
+{
+    namespace fs = std::filesystem;
+
+    fs::create_directories(options.output);
+
+    const auto capture = fs::absolute(fs::path(options.output) / (options.name + ".png")).string();
+    const auto metrics = fs::absolute(fs::path(options.output) / (options.name + ".json")).string();
+    const auto diff = fs::absolute(fs::path(options.output) / (options.name + ".diff.png")).string();
+    const auto golden = fs::absolute(options.golden);
+    const auto baseline = fs::absolute(options.baseline);
+
+    fs::remove(capture);
+    fs::remove(metrics);
+    fs::remove(diff);
+
+    set_environment("NUTSHELL_CAPTURE", capture);
+    set_environment("NUTSHELL_CAPTURE_METRICS", metrics);
+    set_environment("NUTSHELL_CAPTURE_FRAMES", std::to_string(options.frames));
+
+    auto command = quote(fs::absolute(options.sample).string());
+
+    for (const auto& argument : options.arguments) command += " " + quote(argument);
+
+    fs::current_path(options.directory);
+
+    const auto status = std::system(command.c_str());
+
+    if (status != 0 || !fs::exists(capture) || !fs::exists(metrics))
+    {
+        std::cout << options.name << ": sample failed with status " << status << "." << std::endl;
+
+        return FAILED;
+    }
+
+    if (options.update)
+    {
+        fs::create_directories(golden.parent_path());
+        fs::create_directories(baseline.parent_path());
+        fs::copy_file(capture, golden, fs::copy_options::overwrite_existing);
+        fs::copy_file(metrics, baseline, fs::copy_options::overwrite_existing);
+
+        std::cout << options.name << ": golden image and baseline updated." << std::endl;
+
+        return PASSED;
+    }
+
+    if (!fs::exists(golden) || (options.timings && !fs::exists(baseline)))
+    {
+        std::cout << options.name << ": no golden image or baseline. Candidates are in " << options.output << ", accept them with REGRESSION_UPDATE=1." << std::endl;
+
+        return FAILED;
+    }
+
+    auto result = PASSED;
+
+    const auto actual = Image::load(capture);
+    const auto expected = Image::load(golden.string());
+
+    if (actual.width != expected.width || actual.height != expected.height)
+    {
+        std::cout << options.name << ": frame is " << actual.width << "x" << actual.height << ", golden is " << expected.width << "x" << expected.height << "." << std::endl;
+
+        return FAILED;
+    }
+
+    auto visual = expected;
+    size_t mismatched = 0;
+
+    for (size_t i = 0; i < actual.pixels.size(); i += 3)
+    {
+        const auto a = &actual.pixels[i];
+        const auto e = &expected.pixels[i];
+        const auto v = &visual.pixels[i];
+
+        if (distance(a, e) > options.pixel_threshold)
+        {
+            ++mismatched;
+
+            v[0] = 255;
+            v[1] = 0;
+            v[2] = 0;
+        }
+        else
+        {
+            const auto gray = static_cast<std::uint8_t>(128 + (e[0] * 30 + e[1] * 59 + e[2] * 11) / 400);
+
+            v[0] = v[1] = v[2] = gray;
+        }
+    }
+
+    const auto mismatch = static_cast<double>(mismatched) / static_cast<double>(actual.width * actual.height);
+
+    std::cout << options.name << ": " << mismatched << " pixels differ (" << mismatch * 100.0 << "%, limit " << options.max_mismatch * 100.0 << "%)." << std::endl;
+
+    if (mismatch > options.max_mismatch)
+    {
+        visual.save(diff);
+
+        std::cout << options.name << ": image regression, see " << diff << "." << std::endl;
+
+        result = FAILED;
+    }
+
+    if (!options.timings) return result;
+
+    const auto current_metrics = read_metrics(metrics);
+    const auto baseline_metrics = read_metrics(baseline.string());
+
+    for (const auto& [key, slack] : { std::pair("startup_ms", options.startup_slack), std::pair("frame_ms_median", options.time_slack) })
+    {
+        const auto current = number(current_metrics, key);
+        const auto reference = number(baseline_metrics, key);
+        const auto limit = reference * (1.0 + options.time_tolerance) + slack;
+
+        std::cout << options.name << ": " << key << " " << current << " (baseline " << reference << ", limit " << limit << ")." << std::endl;
+
+        if (current > limit)
+        {
+            std::cout << options.name << ": " << key << " regression." << std::endl;
+
+            result = FAILED;
+        }
+        else if (current < reference / (1.0 + options.time_tolerance) - slack)
+        {
+            std::cout << options.name << ": " << key << " improved beyond tolerance, consider updating the baseline." << std::endl;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    try {
+        return run(Options::from(argc, argv));
+    }
+    catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+
+        return FAILED;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
+#include <asset_file.hpp>
+
+// Read-only stream over an AssetFile: assimp's reads become copies out of the mapping (or the batch buffer).
+struct AssetIOStream : Assimp::IOStream
+{
+    explicit AssetIOStream(AssetFile file):
+        file(std::move(file))
+    {
+    }
+
+    auto Read(void* buffer, size_t size, size_t count) -> size_t override
+    {
+        if (size == 0) return 0;
+
+        const auto elements = std::min(count, (file.size() - position) / size);
+
+        std::memcpy(buffer, file.data() + position, elements * size);
+        position += elements * size;
+
+        return elements;
+    }
+
+    auto Write(const void*, size_t, size_t) -> size_t override
+    {
+        return 0;
+    }
+
+    auto Seek(size_t offset, aiOrigin origin) -> aiReturn override
+    {
+        const auto base = origin == aiOrigin_SET ? 0 : origin == aiOrigin_CUR ? position : file.size();
+
+        if (base + offset > file.size()) return aiReturn_FAILURE;
+
+        position = base + offset;
+
+        return aiReturn_SUCCESS;
+    }
+
+    auto Tell() const -> size_t override
+    {
+        return position;
+    }
+
+    auto FileSize() const -> size_t override
+    {
+        return file.size();
+    }
+
+    auto Flush() -> void override
+    {
+    }
+
+    AssetFile file;
+    size_t    position = 0;
+};
+
+// Hands every file assimp opens for reading (the scene and e.g. glTF buffers) to AssetFile, writes keep the default I/O.
+//
+//     importer.SetIOHandler(new AssetIOSystem());
+struct AssetIOSystem : Assimp::DefaultIOSystem
+{
+    auto Open(const char* path, const char* mode = "rb") -> Assimp::IOStream* override
+    {
+        if (std::string_view(mode).find_first_of("wa+") != std::string_view::npos) return DefaultIOSystem::Open(path, mode);
+
+        try
+        {
+            return new AssetIOStream(AssetFile::open(path));
+        }
+        catch (const std::runtime_error&)
+        {
+            // assimp expects nullptr for files that cannot be opened.
+            return nullptr;
+        }
+    }
+};
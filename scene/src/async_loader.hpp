@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <asset_file.hpp>
+#include <profiler.hpp>
+#include <asset_io_system.hpp>
+#include <gl_executor.hpp>
+#include <scene.hpp>
+#include <task.hpp>
+#include <thread_pool.hpp>
+
+// Coroutine front end of the scene loading code: file reads, decoding, import and vertex conversion run on
+// the pool, GL object creation and uploads on the GL executor. Independent loads overlap on their own,
+// load_scene() starts every texture and mesh of the scene at once and finishes when the last one is in.
+//
+//     auto pending = spawn(loader.load_scene("media/room.gltf"));
+//     while (!pending->ready()) gl.poll(2.0);
+//     const auto root = pending->get();
+//
+// The loader, the pool and the executor must outlive every task started through them.
+struct AsyncLoader
+{
+    AsyncLoader(ThreadPool& pool, GlExecutor& gl):
+        pool(pool),
+        gl(gl)
+    {
+    }
+
+    auto load_texture(std::string path) -> Task<GLuint>
+    {
+        co_await pool.schedule();
+
+        const auto image = Material::decode(AssetFile::open(path));
+
+        co_await gl.schedule();
+
+        co_return Material::upload(image);
+    }
+
+    // Encoded image in memory, e.g. a texture embedded in a scene, that must stay alive until the task completes.
+    auto load_texture(const std::uint8_t* data, size_t size) -> Task<GLuint>
+    {
+        co_await pool.schedule();
+
+        const auto image = Material::decode(data, size);
+
+        co_await gl.schedule();
+
+        co_return Material::upload(image);
+    }
+
+    // `source` belongs to an aiScene that must stay alive until the task completes.
+    auto load_mesh(const aiMesh* source, std::shared_ptr<Material> material) -> Task<std::shared_ptr<Mesh>>
+    {
+        co_await pool.schedule();
+
+        const auto converted = Mesh::convert(source);
+
+        co_await gl.schedule();
+
+        co_return Mesh::upload(converted, std::move(material));
+    }
+
+    auto load_scene(std::string path) -> Task<std::shared_ptr<Node>>
+    {
+        co_await pool.schedule();
+
+        Assimp::Importer importer;
+
+        importer.SetIOHandler(new AssetIOSystem());
+
+        const aiScene* scene;
+
+        {
+            PROFILE_SCOPE("assimp import");
+
+            scene = importer.ReadFile(path, aiProcess_Triangulate);
+        }
+
+        if (!scene) throw std::runtime_error(importer.GetErrorString());
+
+        // Materials exist up front so meshes can point at them while their textures are still loading.
+        std::vector<std::shared_ptr<Material>> materials;
+        std::vector<std::shared_ptr<Mesh>> meshes(scene->mNumMeshes);
+        std::vector<Task<void>> loads;
+
+        const auto directory = std::filesystem::path(path).parent_path();
+
+        for (size_t i = 0; i < scene->mNumMaterials; ++i)
+        {
+            auto texture = Material::texture_source(scene, i, directory);
+
+            materials.push_back(texture.empty() ? nullptr : std::make_shared<Material>(0));
+
+            if (materials.back()) loads.push_back(attach_texture(std::move(texture), materials.back()));
+        }
+
+        for (size_t i = 0; i < scene->mNumMeshes; ++i)
+        {
+            const auto index = scene->mMeshes[i]->mMaterialIndex;
+            const auto material = index < materials.size() ? materials[index] : nullptr;
+
+            loads.push_back(attach_mesh(scene->mMeshes[i], material, &meshes[i]));
+        }
+
+        co_await when_all(std::move(loads));
+
+        // The last load most likely finished on the GL thread, the tree is built on the pool again.
+        co_await pool.schedule();
+
+        co_return Node::from(scene->mRootNode, meshes);
+    }
+
+private:
+    auto attach_texture(Material::TextureSource source, std::shared_ptr<Material> material) -> Task<void>
+    {
+        if (source.data) material->texture = co_await load_texture(source.data, source.size);
+        else material->texture = co_await load_texture(std::move(source.path));
+    }
+
+    auto attach_mesh(const aiMesh* source, std::shared_ptr<Material> material, std::shared_ptr<Mesh>* mesh) -> Task<void>
+    {
+        *mesh = co_await load_mesh(source, std::move(material));
+    }
+
+    ThreadPool& pool;
+    GlExecutor& gl;
+};
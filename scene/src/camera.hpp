@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+enum CameraInput : std::uint8_t
+{
+    CAMERA_INPUT_UP    = 1 << 0,
+    CAMERA_INPUT_DOWN  = 1 << 1,
+    CAMERA_INPUT_LEFT  = 1 << 2,
+    CAMERA_INPUT_RIGHT = 1 << 3,
+};
+
+struct Camera
+{
+    // One full turn around the room over `frames` with a slow pitch sway, so headless runs always see the same views.
+    static auto scripted(size_t frame, size_t frames) -> Camera
+    {
+        const auto t = frames > 0 ? static_cast<float>(frame) / static_cast<float>(frames) : 0.0f;
+
+        return {
+            glm::radians(30.0f) + glm::radians(15.0f) * glm::sin(t * glm::radians(720.0f)),
+            glm::radians(45.0f) + glm::radians(360.0f) * t,
+        };
+    }
+
+    // 60 degrees per second, the former 1 degree per frame at 60 Hz, but independent of the frame rate.
+    auto update(std::uint8_t input, float dt) -> void
+    {
+        const auto step = glm::radians(60.0f) * dt;
+
+        if (input & CAMERA_INPUT_UP) x += step;
+        if (input & CAMERA_INPUT_DOWN) x -= step;
+        if (input & CAMERA_INPUT_RIGHT) y += step;
+        if (input & CAMERA_INPUT_LEFT) y -= step;
+    }
+
+    auto view_projection(float aspect) const -> glm::mat4
+    {
+        auto rx = glm::transpose(glm::mat3(
+            +1.0f, +0.0f,         +0.0f,
+            +0.0f, +glm::cos(-x), +glm::sin(-x),
+            +0.0f, -glm::sin(-x), +glm::cos(-x)
+        ));
+        auto ry = glm::transpose(glm::mat3(
+            +glm::cos(-y), +0.0f, -glm::sin(-y),
+            +0.0f,         +1.0f, +0.0f,
+            +glm::sin(-y), +0.0f, +glm::cos(-y)
+        ));
+        auto t = glm::transpose(glm::mat3x4(
+            +1.0f, +0.0f, +0.0f, +0.0f,
+            +0.0f, +1.0f, +0.0f, -0.5f,
+            +0.0f, +0.0f, +1.0f, -3.0f
+        ));
+
+        glm::mat4 view = glm::mat4(t) * glm::mat4(rx) * glm::mat4(ry);
+
+        const auto fov = glm::radians(60.0f);
+        const auto z_near = 0.01f;
+        const auto z_far = 100.0f;
+
+        glm::mat4 projection = glm::transpose(glm::mat4(
+            aspect / glm::cos(fov / 2.0f), 0.0f,                        0.0f,                             0.0f,
+            0.0f,                          1.0f / glm::cos(fov / 2.0f), 0.0f,                             0.0f,
+            0.0f,                          0.0f,                        -(z_far*z_near)/(z_far - z_near), -(2.0f*z_far*z_near)/(z_far - z_near),
+            0.0f,                          0.0f,                        -1.0f,                            0.0f
+        ));
+
+        return projection * view;
+    }
+
+    float x = glm::radians(30.0f);
+    float y = glm::radians(45.0f);
+};
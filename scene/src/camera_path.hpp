@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "camera.hpp"
+
+// Camera input sampled once per tick of a fixed-rate simulation. Only changes of the input are stored.
+// File layout, little endian: "CAMP", version u32, rate f32, start x/y f32, ticks u32, events count u32,
+// then { tick u32, input u8 } per event.
+struct CameraPath
+{
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint8_t  INPUTS  = CAMERA_INPUT_UP | CAMERA_INPUT_DOWN | CAMERA_INPUT_LEFT | CAMERA_INPUT_RIGHT;
+
+    struct Event
+    {
+        std::uint32_t tick;
+        std::uint8_t  input;
+    };
+
+    static auto load(const std::string& path) -> CameraPath
+    {
+        std::ifstream stream(path, std::ios::binary);
+
+        if (!stream) throw std::runtime_error("Failed to open camera path " + path + ".");
+
+        const auto u8 = [&]
+        {
+            char byte;
+
+            if (!stream.get(byte)) throw std::runtime_error("Camera path " + path + " is truncated.");
+
+            return static_cast<std::uint8_t>(byte);
+        };
+        const auto u32 = [&]
+        {
+            std::uint32_t value = 0;
+
+            for (int i = 0; i < 4; ++i) value |= std::uint32_t(u8()) << (8 * i);
+
+            return value;
+        };
+        const auto f32 = [&]
+        {
+            return std::bit_cast<float>(u32());
+        };
+
+        if (u8() != 'C' || u8() != 'A' || u8() != 'M' || u8() != 'P') throw std::runtime_error(path + " is not a camera path.");
+        if (u32() != VERSION) throw std::runtime_error("Camera path " + path + " has unsupported version.");
+
+        CameraPath result;
+
+        const auto invalid = [&](const std::string& what)
+        {
+            return std::runtime_error("Camera path " + path + " has " + what + ".");
+        };
+
+        result.rate = f32();
+        result.start.x = f32();
+        result.start.y = f32();
+        result.ticks = u32();
+
+        if (!(result.rate > 0.0f) || !std::isfinite(result.rate)) throw invalid("invalid rate");
+        if (!std::isfinite(result.start.x) || !std::isfinite(result.start.y)) throw invalid("invalid start");
+        if (result.ticks == 0) throw invalid("no ticks");
+
+        // Events are changes of the input, at most one per tick.
+        const auto count = u32();
+
+        if (count > result.ticks) throw invalid("more events than ticks");
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const auto tick = u32();
+            const auto input = u8();
+
+            if (tick >= result.ticks) throw invalid("an event after the last tick");
+            if (!result.events.empty() && tick <= result.events.back().tick) throw invalid("events out of order");
+            if (input & ~INPUTS) throw invalid("an unknown input");
+
+            result.events.push_back({ tick, input });
+        }
+
+        if (stream.peek() != std::ifstream::traits_type::eof()) throw invalid("trailing data");
+
+        return result;
+    }
+
+    auto save(const std::string& path) const -> void
+    {
+        std::ofstream stream(path, std::ios::binary);
+
+        if (!stream) throw std::runtime_error("Failed to open camera path " + path + ".");
+
+        const auto u8 = [&](std::uint8_t value)
+        {
+            stream.put(static_cast<char>(value));
+        };
+        const auto u32 = [&](std::uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i) u8(static_cast<std::uint8_t>(value >> (8 * i)));
+        };
+        const auto f32 = [&](float value)
+        {
+            u32(std::bit_cast<std::uint32_t>(value));
+        };
+
+        u8('C'); u8('A'); u8('M'); u8('P');
+        u32(VERSION);
+        f32(rate);
+        f32(start.x);
+        f32(start.y);
+        u32(ticks);
+        u32(static_cast<std::uint32_t>(events.size()));
+
+        for (const auto& event : events)
+        {
+            u32(event.tick);
+            u8(event.input);
+        }
+
+        if (!stream) throw std::runtime_error("Failed to write camera path " + path + ".");
+    }
+
+    auto step() const -> float
+    {
+        return 1.0f / rate;
+    }
+
+    // Appends the input of the next tick.
+    auto record(std::uint8_t input) -> void
+    {
+        if (events.empty() ? input != 0 : events.back().input != input) events.push_back({ ticks, input });
+
+        ++ticks;
+    }
+
+    auto input(std::uint32_t tick) const -> std::uint8_t
+    {
+        const auto next = std::upper_bound(events.begin(), events.end(), tick, [](std::uint32_t t, const Event& event) { return t < event.tick; });
+
+        return next == events.begin() ? 0 : std::prev(next)->input;
+    }
+
+    // Camera state after every tick, the views a replay renders.
+    auto cameras() const -> std::vector<Camera>
+    {
+        std::vector<Camera> result;
+        auto camera = start;
+
+        result.reserve(ticks);
+
+        for (std::uint32_t tick = 0; tick < ticks; ++tick)
+        {
+            camera.update(input(tick), step());
+            result.push_back(camera);
+        }
+
+        return result;
+    }
+
+    float              rate = 60.0f;
+    Camera             start;
+    std::uint32_t      ticks = 0;
+    std::vector<Event> events;
+};
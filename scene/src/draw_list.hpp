@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <job_system.hpp>
+#include <profiler.hpp>
+#include <scene.hpp>
+
+// One draw, 16 bytes. The transformation lives in the owning batch and is shared by all meshes of a node.
+struct DrawCommand
+{
+    std::uint32_t matrix;
+    GLuint        vertex_arrays;
+    GLuint        texture;
+    GLsizei       indices_count;
+};
+
+// Flattens the node tree once, then rebuilds the per-frame draws as jobs on `jobs` (the caller included).
+// Nodes are cut into contiguous batches, several per thread so stealing can even out uneven ones. Every batch
+// has its own matrices and commands, so building takes no locks and replaying the batches in order issues
+// the draws in the same order as Node::render.
+struct DrawList
+{
+    struct Batch
+    {
+        size_t                   begin = 0;
+        size_t                   end   = 0;
+        std::vector<glm::mat4>   matrices;
+        std::vector<DrawCommand> commands;
+    };
+
+    DrawList(const Node& root, JobSystem& jobs):
+        jobs(jobs)
+    {
+        flatten(root);
+
+        const auto count = std::clamp<size_t>(jobs.threads() * BATCHES_PER_THREAD, 1, std::max<size_t>(1, nodes.size()));
+
+        // Balance the ranges by mesh count, not node count, since nodes without meshes cost next to nothing.
+        size_t meshes = 0;
+
+        for (const auto node : nodes) meshes += node->meshes.size();
+
+        batches.resize(count);
+
+        size_t node = 0;
+        size_t covered = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto target = meshes * (i + 1) / count;
+
+            batches[i].begin = node;
+
+            while (node < nodes.size() && (covered < target || i + 1 == count))
+            {
+                covered += nodes[node++]->meshes.size();
+            }
+
+            batches[i].end = node;
+        }
+    }
+    DrawList(const DrawList&) = delete;
+
+    auto operator=(const DrawList&) -> DrawList& = delete;
+
+    // A non-zero `frame` is stamped into Material::used of every material drawn, for TextureManager. With the
+    // `viewport` size in pixels as well, each drawn mesh also raises Material::feedback to its pixels per UV unit.
+    auto build(const glm::mat4& vp, std::uint64_t frame = 0, const glm::vec2& viewport = glm::vec2(0.0f)) -> void
+    {
+        PROFILE_SCOPE("DrawList::build");
+
+        jobs.parallel_for(0, batches.size(), [&](size_t begin, size_t end)
+        {
+            PROFILE_SCOPE("DrawList::record");
+
+            for (auto i = begin; i < end; ++i) record(batches[i], vp, frame, viewport);
+        }, 1);
+    }
+
+    auto submit(GLuint program) const -> size_t
+    {
+        PROFILE_SCOPE("DrawList::submit");
+
+        GLuint vertex_arrays = 0;
+        GLuint texture = 0;
+        size_t draws = 0;
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        for (const auto& batch : batches)
+        {
+            auto matrix = static_cast<std::uint32_t>(-1);
+
+            for (const auto& command : batch.commands)
+            {
+                if (command.matrix != matrix)
+                {
+                    matrix = command.matrix;
+                    glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, glm::value_ptr(batch.matrices[matrix]));
+                }
+
+                if (command.texture != texture)
+                {
+                    texture = command.texture;
+                    glBindTexture(GL_TEXTURE_2D, texture);
+                }
+
+                if (command.vertex_arrays != vertex_arrays)
+                {
+                    vertex_arrays = command.vertex_arrays;
+                    glBindVertexArray(vertex_arrays);
+                }
+
+                glDrawElements(GL_TRIANGLES, command.indices_count, GL_UNSIGNED_INT, 0);
+            }
+
+            draws += batch.commands.size();
+        }
+
+        return draws;
+    }
+
+    auto threads() const -> size_t
+    {
+        return jobs.threads();
+    }
+
+    // Conservative clip-space test of the mesh bounds: culled only when all eight corners are outside one plane.
+    static auto visible(const glm::mat4& mvp, const Mesh& mesh) -> bool
+    {
+        std::uint32_t inside[6] = {};
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const auto point = glm::vec4(
+                corner & 1 ? mesh.maximum.x : mesh.minimum.x,
+                corner & 2 ? mesh.maximum.y : mesh.minimum.y,
+                corner & 4 ? mesh.maximum.z : mesh.minimum.z,
+                1.0f
+            );
+            const auto clip = mvp * point;
+
+            inside[0] |= clip.x >= -clip.w;
+            inside[1] |= clip.x <= +clip.w;
+            inside[2] |= clip.y >= -clip.w;
+            inside[3] |= clip.y <= +clip.w;
+            inside[4] |= clip.z >= -clip.w;
+            inside[5] |= clip.z <= +clip.w;
+        }
+
+        return inside[0] && inside[1] && inside[2] && inside[3] && inside[4] && inside[5];
+    }
+    // Screen pixels per object space unit of the mesh: the larger side of its projected bounds over their
+    // largest extent. Infinite when a corner is behind the eye, the mesh may then fill the screen.
+    static auto pixels_per_unit(const glm::mat4& mvp, const Mesh& mesh, const glm::vec2& viewport) -> float
+    {
+        constexpr auto INFINITE = std::numeric_limits<float>::infinity();
+
+        auto low = glm::vec2(INFINITE);
+        auto high = glm::vec2(-INFINITE);
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const auto point = glm::vec4(
+                corner & 1 ? mesh.maximum.x : mesh.minimum.x,
+                corner & 2 ? mesh.maximum.y : mesh.minimum.y,
+                corner & 4 ? mesh.maximum.z : mesh.minimum.z,
+                1.0f
+            );
+            const auto clip = mvp * point;
+
+            if (clip.w <= 1e-6f) return INFINITE;
+
+            const auto ndc = glm::vec2(clip.x, clip.y) / clip.w;
+
+            low = glm::min(low, ndc);
+            high = glm::max(high, ndc);
+        }
+
+        const auto size = mesh.maximum - mesh.minimum;
+        const auto extent = std::max({ size.x, size.y, size.z });
+
+        if (!(extent > 0.0f)) return INFINITE;
+
+        const auto span = (high - low) * 0.5f * viewport;
+
+        return std::max(span.x, span.y) / extent;
+    }
+
+    std::vector<const Node*> nodes;
+    std::vector<Batch>       batches;
+
+private:
+    auto flatten(const Node& node) -> void
+    {
+        nodes.push_back(&node);
+
+        for (const auto& child : node.children) flatten(*child);
+    }
+
+    auto record(Batch& batch, const glm::mat4& vp, std::uint64_t frame, const glm::vec2& viewport) const -> void
+    {
+        batch.matrices.clear();
+        batch.commands.clear();
+
+        for (auto i = batch.begin; i < batch.end; ++i)
+        {
+            const auto node = nodes[i];
+
+            if (node->meshes.empty()) continue;
+
+            const auto mvp = vp * node->transformation;
+            const auto matrix = static_cast<std::uint32_t>(batch.matrices.size());
+            auto used = false;
+
+            for (const auto& mesh : node->meshes)
+            {
+                // Meshes still streaming in have no vertex arrays yet.
+                if (mesh->vertex_arrays == 0 || !visible(mvp, *mesh)) continue;
+
+                // Evicted textures are drawn as 0 but still stamped, so they are loaded again. The load first keeps
+                // the shared cache line clean for materials that are drawn many times.
+                if (frame != 0 && mesh->material && mesh->material->used.load(std::memory_order_relaxed) != frame)
+                {
+                    mesh->material->used.store(frame, std::memory_order_relaxed);
+                }
+
+                // Unknown UV density asks for the finest level.
+                if (frame != 0 && mesh->material && viewport.y > 0.0f)
+                {
+                    const auto density = mesh->uv_density > 0.0f
+                        ? pixels_per_unit(mvp, *mesh, viewport) / mesh->uv_density
+                        : std::numeric_limits<float>::infinity();
+
+                    auto& feedback = mesh->material->feedback;
+                    auto current = feedback.load(std::memory_order_relaxed);
+
+                    while (current < density && !feedback.compare_exchange_weak(current, density, std::memory_order_relaxed))
+                    {
+                    }
+                }
+
+                batch.commands.push_back({
+                    matrix,
+                    mesh->vertex_arrays,
+                    mesh->material ? mesh->material->texture : 0,
+                    static_cast<GLsizei>(mesh->indices_count),
+                });
+                used = true;
+            }
+
+            if (used) batch.matrices.push_back(mvp);
+        }
+    }
+
+    static constexpr size_t BATCHES_PER_THREAD = 4;
+
+    JobSystem& jobs;
+};
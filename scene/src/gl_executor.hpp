@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+
+#include <profiler.hpp>
+
+// Queue of coroutines waiting for the thread that owns the GL context: `co_await gl.schedule()` continues
+// the coroutine inside the next poll(), which the render loop calls once per frame.
+struct GlExecutor
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto schedule()
+    {
+        struct Awaiter
+        {
+            auto await_ready() const noexcept -> bool
+            {
+                return false;
+            }
+
+            auto await_suspend(std::coroutine_handle<> handle) -> void
+            {
+                auto lock = std::lock_guard(executor.mutex);
+
+                executor.queue.push_back(handle);
+            }
+
+            auto await_resume() const noexcept -> void
+            {
+            }
+
+            GlExecutor& executor;
+        };
+
+        return Awaiter{ *this };
+    }
+
+    // Resumes queued coroutines until the queue is empty or `milliseconds` have passed, at least one per call
+    // so a single expensive upload cannot stall loading. Returns how many ran.
+    auto poll(double milliseconds) -> size_t
+    {
+        PROFILE_SCOPE("GlExecutor::poll");
+
+        const auto begin = Clock::now();
+        size_t resumed = 0;
+
+        for (;;)
+        {
+            if (resumed > 0 && std::chrono::duration<double, std::milli>(Clock::now() - begin).count() >= milliseconds) break;
+
+            std::coroutine_handle<> handle;
+
+            {
+                auto lock = std::lock_guard(mutex);
+
+                if (queue.empty()) break;
+
+                handle = queue.front();
+                queue.pop_front();
+            }
+
+            handle.resume();
+            ++resumed;
+        }
+
+        return resumed;
+    }
+
+private:
+    std::mutex                          mutex;
+    std::deque<std::coroutine_handle<>> queue;
+};
@@ -0,0 +1,1050 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <png.h>
+#include <assimp/scene.h>
+#include <asset_file.hpp>
+#include <gltf_scene.hpp>
+#include <job_system.hpp>
+#include <pixel_convert.hpp>
+#include <profiler.hpp>
+#include <staging_ring.hpp>
+#include <vertex_weld.hpp>
+
+struct Vertex {
+    glm::vec3 position;
+    glm::vec2 mapping;
+};
+
+// Mesh::convert_vertices writes vertices as five packed floats.
+static_assert(sizeof(Vertex) == 5 * sizeof(float));
+
+struct Material
+{
+    // Diffuse texture of a material: compressed image bytes inside the scene, which stay valid as long as it
+    // does, or a file to read. Both are empty when the material has no texture.
+    struct TextureSource
+    {
+        const std::uint8_t* data = nullptr;
+        size_t              size = 0;
+        std::string         path;
+
+        auto empty() const -> bool
+        {
+            return !data && path.empty();
+        }
+    };
+    // Embedded textures (GLB, data URIs, generated scenes) are returned as their pcData, files referenced by the
+    // scene resolve against `directory`, the one holding the scene file, like GltfScene::load resolves URIs.
+    static auto texture_source(const aiScene* scene, size_t index, const std::filesystem::path& directory) -> TextureSource
+    {
+        const auto material = scene->mMaterials[index];
+
+        aiString path;
+
+        material->GetTexture(aiTextureType::aiTextureType_DIFFUSE, 0, &path, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+        if (path.length == 0) return {};
+
+        const auto embedded = scene->GetEmbeddedTexture(path.C_Str());
+
+        if (!embedded) return { nullptr, 0, (directory / path.C_Str()).generic_string() };
+
+        // mHeight 0 means pcData holds mWidth bytes of an encoded file instead of texels.
+        if (embedded->mHeight != 0) throw std::runtime_error("Uncompressed embedded textures are not supported.");
+
+        return { reinterpret_cast<const std::uint8_t*>(embedded->pcData), embedded->mWidth };
+    }
+    // Decodes and uploads the diffuse texture of `index`, 0 when the material has none.
+    static auto load_texture(const aiScene* scene, size_t index, const std::filesystem::path& directory, StagingRing* ring = nullptr) -> GLuint
+    {
+        const auto source = texture_source(scene, index, directory);
+
+        if (source.data) return load_texture(source.data, source.size, ring);
+        if (source.path.empty()) return 0;
+
+        return load_texture(AssetFile::open(source.path), ring);
+    }
+    static auto load_texture(const AssetFile& file, StagingRing* ring = nullptr) -> GLuint
+    {
+        return load_texture(file.data(), file.size(), ring);
+    }
+    // With a staging ring the texels are written straight into its mapping, which is write-only and often
+    // write-combined, so nothing is read back from it: without channel analysis the PNG decodes right into the
+    // ring, otherwise it decodes to client memory for the analysis and is packed into the ring from there.
+    static auto load_texture(const std::uint8_t* data, size_t size, StagingRing* ring = nullptr) -> GLuint
+    {
+        const auto [width, height] = Material::dimensions(data, size);
+        const auto count = static_cast<size_t>(width) * height;
+
+        if (ring && !Material::compact_formats() && count * 4 <= ring->capacity)
+        {
+            const auto staging = ring->allocate(count * 4);
+
+            Material::decode_rgba(data, size, staging.data);
+
+            return Material::upload(width, height, {}, *ring, staging);
+        }
+
+        auto decoded = Material::decode_rgba(data, size);
+        const auto layout = Material::analyze(decoded.data.data(), count);
+
+        if (ring && count * layout.channels <= ring->capacity)
+        {
+            const auto staging = ring->allocate(count * layout.channels);
+
+            pixels::pack_channels(decoded.data.data(), staging.data, count, layout);
+
+            return Material::upload(width, height, layout, *ring, staging);
+        }
+
+        pixels::pack_channels(decoded.data.data(), decoded.data.data(), count, layout);
+
+        decoded.layout = layout;
+        decoded.data.resize(count * layout.channels);
+
+        return Material::upload(decoded);
+    }
+    // Decoded texture, packed into the channels it needs.
+    struct Image
+    {
+        std::uint32_t             width  = 0;
+        std::uint32_t             height = 0;
+        pixels::ChannelLayout     layout;
+        std::vector<std::uint8_t> data;
+    };
+    // Decodes and packs in client memory, safe on any thread.
+    static auto decode(const AssetFile& file) -> Image
+    {
+        return decode(file.data(), file.size());
+    }
+    static auto decode(const std::uint8_t* data, size_t size) -> Image
+    {
+        auto decoded = Material::decode_rgba(data, size);
+        const auto count = static_cast<size_t>(decoded.width) * decoded.height;
+
+        decoded.layout = Material::compact(decoded.data.data(), count);
+        decoded.data.resize(count * decoded.layout.channels);
+
+        return decoded;
+    }
+    // Decodes to plain RGBA8, for consumers that need one format for every image.
+    static auto decode_rgba(const std::uint8_t* data, size_t size) -> Image
+    {
+        const auto [width, height] = Material::dimensions(data, size);
+
+        auto decoded = Image{ width, height, {}, std::vector<std::uint8_t>(static_cast<size_t>(width) * height * 4) };
+
+        Material::decode_rgba(data, size, decoded.data.data());
+
+        return decoded;
+    }
+    // Into `destination`, which takes width * height * 4 bytes and is only written.
+    static auto decode_rgba(const std::uint8_t* data, size_t size, std::uint8_t* destination) -> void
+    {
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+
+        if (png_image_begin_read_from_memory(&image, data, size) == 0) throw std::runtime_error("Failed to load image.");
+
+        PROFILE_SCOPE("png decode");
+
+        pixels::read_png_rgba(image, destination);
+    }
+    // Width and height from the header, without decoding.
+    static auto dimensions(const std::uint8_t* data, size_t size) -> std::pair<std::uint32_t, std::uint32_t>
+    {
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+
+        if (png_image_begin_read_from_memory(&image, data, size) == 0) throw std::runtime_error("Failed to load image.");
+
+        png_image_free(&image);
+
+        return { image.width, image.height };
+    }
+    static auto upload(const Image& image) -> GLuint
+    {
+        PROFILE_SCOPE("texture upload");
+
+        const auto texture = Material::create(image.width, image.height, image.layout);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, Material::formats(image.layout).second, GL_UNSIGNED_BYTE, image.data.data());
+
+        return texture;
+    }
+    // From packed texels in a staging allocation, which is committed.
+    static auto upload(std::uint32_t width, std::uint32_t height, const pixels::ChannelLayout& layout, StagingRing& ring, const StagingRing::Allocation& staging) -> GLuint
+    {
+        PROFILE_SCOPE("texture upload");
+
+        const auto texture = Material::create(width, height, layout);
+
+        ring.upload_texture(texture, staging, width, height, Material::formats(layout).second, GL_UNSIGNED_BYTE);
+
+        return texture;
+    }
+    // NUTSHELL_TEXTURE_FORMATS: "rgba8" uploads every texture as RGBA8, otherwise each gets the smallest
+    // uncompressed format that holds its content.
+    static auto compact_formats() -> bool
+    {
+        static const auto enabled = []
+        {
+            const auto value = std::getenv("NUTSHELL_TEXTURE_FORMATS");
+
+            return !value || std::string(value) != "rgba8";
+        }();
+
+        return enabled;
+    }
+    // Channels decoded RGBA8 pixels need, see pixels::analyze_channels. Only reads `rgba`.
+    static auto analyze(const std::uint8_t* rgba, size_t count) -> pixels::ChannelLayout
+    {
+        if (!compact_formats()) return {};
+
+        PROFILE_SCOPE("channel analysis");
+
+        return pixels::analyze_channels(rgba, count);
+    }
+    // Analyzes and packs in place.
+    static auto compact(std::uint8_t* rgba, size_t count) -> pixels::ChannelLayout
+    {
+        const auto layout = Material::analyze(rgba, count);
+
+        pixels::pack_channels(rgba, rgba, count, layout);
+
+        return layout;
+    }
+    // Internal format and pixel transfer format of the packed channels.
+    static auto formats(const pixels::ChannelLayout& layout) -> std::pair<GLenum, GLenum>
+    {
+        switch (layout.channels)
+        {
+        case 1:  return { GL_R8, GL_RED };
+        case 2:  return { GL_RG8, GL_RG };
+        default: return { GL_RGBA8, GL_RGBA };
+        }
+    }
+    // Storage for the packed channels, swizzled so shaders still sample the original RGBA. `levels` halves
+    // `width` and `height` each level, rounding down.
+    static auto create(GLsizei width, GLsizei height, const pixels::ChannelLayout& layout, GLsizei levels = 1) -> GLuint
+    {
+        GLuint texture;
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        glTextureStorage2D(texture, levels, Material::formats(layout).first, width, height);
+
+        constexpr GLint CHANNELS[] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE };
+
+        const GLint swizzle[] = { CHANNELS[layout.swizzle[0]], CHANNELS[layout.swizzle[1]], CHANNELS[layout.swizzle[2]], CHANNELS[layout.swizzle[3]] };
+
+        glTextureParameteriv(texture, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+
+        const auto count = Material::texels(width, height, levels);
+
+        auto& usage = Material::memory();
+
+        usage.textures.fetch_add(1, std::memory_order_relaxed);
+        usage.rgba8.fetch_add(count * 4, std::memory_order_relaxed);
+        usage.stored.fetch_add(count * layout.channels, std::memory_order_relaxed);
+
+        return texture;
+    }
+    // Deletes a texture made by create() and takes it out of memory(), `texture` becomes 0.
+    static auto destroy(GLuint& texture) -> void
+    {
+        if (texture == 0) return;
+
+        GLint width, height, levels;
+
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+
+        const auto count = Material::texels(width, height, levels);
+        const auto channels = Material::bytes(texture) / (static_cast<size_t>(width) * static_cast<size_t>(height));
+
+        auto& usage = Material::memory();
+
+        usage.textures.fetch_sub(1, std::memory_order_relaxed);
+        usage.rgba8.fetch_sub(count * 4, std::memory_order_relaxed);
+        usage.stored.fetch_sub(count * channels, std::memory_order_relaxed);
+
+        glDeleteTextures(1, &texture);
+
+        texture = 0;
+    }
+    // Texels of every level.
+    static auto texels(GLsizei width, GLsizei height, GLsizei levels) -> size_t
+    {
+        size_t count = 0;
+
+        for (GLsizei level = 0; level < levels; ++level)
+        {
+            count += static_cast<size_t>(std::max(width >> level, 1)) * static_cast<size_t>(std::max(height >> level, 1));
+        }
+
+        return count;
+    }
+    // Size of level 0 of a texture made by create().
+    static auto bytes(GLuint texture) -> size_t
+    {
+        GLint width, height, format;
+
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+        const size_t channels = format == GL_R8 ? 1 : format == GL_RG8 ? 2 : 4;
+
+        return static_cast<size_t>(width) * static_cast<size_t>(height) * channels;
+    }
+    // Texture memory of the textures made by create() and not destroyed yet, next to what they would take as RGBA8.
+    struct Memory
+    {
+        std::atomic<size_t> textures = 0;
+        std::atomic<size_t> rgba8    = 0;
+        std::atomic<size_t> stored   = 0;
+    };
+    static auto memory() -> Memory&
+    {
+        static auto instance = Memory();
+
+        return instance;
+    }
+    // Encoded images to textures through a staging ring. With `jobs` they go a ring's worth at a time: the jobs
+    // decode a group in parallel, each image into its own slice of one staging allocation (packed there after the
+    // channel analysis, or decoded right into it without), then the calling thread uploads them one by one. Images
+    // larger than the ring upload from client memory.
+    static auto load_textures(const std::vector<std::pair<const std::uint8_t*, size_t>>& sources, JobSystem* jobs = nullptr) -> std::vector<GLuint>
+    {
+        auto ring = StagingRing();
+
+        std::vector<GLuint> textures;
+
+        if (!jobs)
+        {
+            for (const auto& [data, size] : sources) textures.push_back(Material::load_texture(data, size, &ring));
+
+            return textures;
+        }
+
+        const auto aligned = [](size_t bytes) { return (bytes + StagingRing::ALIGNMENT - 1) / StagingRing::ALIGNMENT * StagingRing::ALIGNMENT; };
+        const auto analyze = Material::compact_formats();
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> sizes;
+
+        for (const auto& [data, size] : sources) sizes.push_back(Material::dimensions(data, size));
+
+        textures.resize(sources.size());
+
+        for (size_t begin = 0; begin < sources.size();)
+        {
+            const auto texels = [&](size_t i) { return static_cast<size_t>(sizes[i].first) * sizes[i].second; };
+
+            // As RGBA8 the group fits the ring, packing only shrinks it.
+            auto end = begin;
+
+            for (size_t bytes = 0; end < sources.size() && bytes + aligned(texels(end) * 4) <= ring.capacity; ++end) bytes += aligned(texels(end) * 4);
+
+            if (end == begin)
+            {
+                textures[begin] = Material::upload(Material::decode(sources[begin].first, sources[begin].second));
+                ++begin;
+
+                continue;
+            }
+
+            std::vector<Image> decoded(end - begin);
+            std::vector<pixels::ChannelLayout> layouts(end - begin);
+
+            if (analyze)
+            {
+                jobs->parallel_for(begin, end, [&](size_t first, size_t last)
+                {
+                    for (auto i = first; i < last; ++i)
+                    {
+                        decoded[i - begin] = Material::decode_rgba(sources[i].first, sources[i].second);
+                        layouts[i - begin] = Material::analyze(decoded[i - begin].data.data(), texels(i));
+                    }
+                }, 1);
+            }
+
+            std::vector<size_t> offsets(end - begin + 1, 0);
+
+            for (auto i = begin; i < end; ++i) offsets[i - begin + 1] = offsets[i - begin] + aligned(texels(i) * layouts[i - begin].channels);
+
+            const auto staging = ring.allocate(offsets.back());
+
+            jobs->parallel_for(begin, end, [&](size_t first, size_t last)
+            {
+                for (auto i = first; i < last; ++i)
+                {
+                    const auto destination = staging.data + offsets[i - begin];
+
+                    if (analyze)
+                    {
+                        pixels::pack_channels(decoded[i - begin].data.data(), destination, texels(i), layouts[i - begin]);
+
+                        decoded[i - begin] = {};
+                    }
+                    else
+                    {
+                        Material::decode_rgba(sources[i].first, sources[i].second, destination);
+                    }
+                }
+            }, 1);
+
+            for (auto i = begin; i < end; ++i)
+            {
+                const auto offset = offsets[i - begin];
+                const auto slice = StagingRing::Allocation{ staging.offset + offset, texels(i) * layouts[i - begin].channels, staging.data + offset };
+
+                textures[i] = Material::upload(sizes[i].first, sizes[i].second, layouts[i - begin], ring, slice);
+            }
+
+            begin = end;
+        }
+
+        return textures;
+    }
+    // Textures embedded in the scene decode straight from its memory, only those in files are read, in one batch.
+    static auto from(const aiScene* scene, const std::filesystem::path& directory, JobSystem* jobs = nullptr)
+    {
+        PROFILE_SCOPE("Material::from");
+
+        std::vector<TextureSource> textures;
+        std::vector<std::string> paths;
+
+        for (size_t i = 0; i < scene->mNumMaterials; ++i)
+        {
+            textures.push_back(Material::texture_source(scene, i, directory));
+
+            if (!textures.back().path.empty()) paths.push_back(textures.back().path);
+        }
+
+        // A single io_uring submission with NUTSHELL_ASSET_IO=uring.
+        std::vector<AssetFile> files;
+
+        {
+            PROFILE_SCOPE("texture read");
+
+            files = AssetFile::open_all(paths);
+        }
+
+        std::vector<std::pair<const std::uint8_t*, size_t>> sources;
+        size_t file = 0;
+
+        for (const auto& texture : textures)
+        {
+            if (texture.data) sources.emplace_back(texture.data, texture.size);
+            else if (!texture.path.empty()) sources.emplace_back(files[file].data(), files[file].size()), ++file;
+        }
+
+        const auto loaded = Material::load_textures(sources, jobs);
+
+        std::vector<std::shared_ptr<Material>> materials;
+        size_t source = 0;
+
+        for (const auto& texture : textures)
+        {
+            materials.push_back(texture.empty() ? nullptr : std::make_shared<Material>(loaded[source++]));
+        }
+
+        return materials;
+    }
+    // Base color textures of a native glTF scene, each image decoded once however many materials share it.
+    // Images inside the scene's buffers decode straight from memory, files next to it are read in one batch.
+    static auto from(const GltfScene& scene, JobSystem* jobs = nullptr) -> std::vector<std::shared_ptr<Material>>
+    {
+        PROFILE_SCOPE("Material::from glTF");
+
+        std::vector<size_t> images;
+
+        for (const auto& material : scene.materials)
+        {
+            if (material.base_color != GltfScene::NONE) images.push_back(material.base_color);
+        }
+
+        std::sort(images.begin(), images.end());
+        images.erase(std::unique(images.begin(), images.end()), images.end());
+
+        std::vector<std::string> paths;
+
+        for (const auto image : images)
+        {
+            if (!scene.images[image].data) paths.push_back(scene.images[image].path);
+        }
+
+        std::vector<AssetFile> files;
+
+        {
+            PROFILE_SCOPE("texture read");
+
+            files = AssetFile::open_all(paths);
+        }
+
+        std::vector<std::pair<const std::uint8_t*, size_t>> sources;
+        size_t file = 0;
+
+        for (const auto image : images)
+        {
+            if (scene.images[image].data) sources.emplace_back(scene.images[image].data, scene.images[image].size);
+            else sources.emplace_back(files[file].data(), files[file].size()), ++file;
+        }
+
+        std::vector<std::shared_ptr<Material>> textures;
+
+        for (const auto texture : Material::load_textures(sources, jobs)) textures.push_back(std::make_shared<Material>(texture));
+
+        std::vector<std::shared_ptr<Material>> materials;
+
+        for (const auto& material : scene.materials)
+        {
+            const auto image = std::lower_bound(images.begin(), images.end(), material.base_color);
+
+            materials.push_back(material.base_color != GltfScene::NONE ? textures[image - images.begin()] : nullptr);
+        }
+
+        return materials;
+    }
+
+    Material(GLuint texture):
+        texture(texture)
+    {
+    }
+
+    GLuint texture;
+    // Frame of the last draw list that referenced the material, see TextureManager.
+    std::atomic<std::uint64_t> used = 0;
+    // Largest screen pixels per UV unit any of its meshes covered in the last draw list, infinite when the camera
+    // is inside one. TextureManager picks the mip level from it and resets it every frame.
+    std::atomic<float> feedback = 0.0f;
+};
+
+struct Mesh
+{
+    // Vertices [begin, end) of `source` into `destination`, flipping v. Four vertices per step on SSE2: three
+    // loads each of positions and UVs, shuffled into five stores of interleaved vertices.
+    static auto convert_vertices(const aiMesh* source, Vertex* destination, size_t begin, size_t end) -> void
+    {
+        auto i = begin;
+
+#if defined(__SSE2__) || defined(_M_X64)
+        const auto positions = reinterpret_cast<const float*>(source->mVertices);
+        const auto mappings = reinterpret_cast<const float*>(source->mTextureCoords[0]);
+        const auto output = reinterpret_cast<float*>(destination);
+        const auto ones = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= end; i += 4)
+        {
+            // x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3, the UVs likewise with u v w.
+            const auto p0 = _mm_loadu_ps(positions + i * 3 + 0);
+            const auto p1 = _mm_loadu_ps(positions + i * 3 + 4);
+            const auto p2 = _mm_loadu_ps(positions + i * 3 + 8);
+            const auto m0 = _mm_loadu_ps(mappings + i * 3 + 0);
+            const auto m1 = _mm_loadu_ps(mappings + i * 3 + 4);
+            const auto m2 = _mm_loadu_ps(mappings + i * 3 + 8);
+
+            // u0 v0 u1 v1 and u2 v2 u3 v3, then v flipped as 1 - v like the scalar loop.
+            auto uv01 = _mm_shuffle_ps(m0, _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 1, 0));
+            auto uv23 = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));
+
+            uv01 = _mm_shuffle_ps(uv01, _mm_sub_ps(ones, uv01), _MM_SHUFFLE(3, 1, 2, 0));
+            uv01 = _mm_shuffle_ps(uv01, uv01, _MM_SHUFFLE(3, 1, 2, 0));
+            uv23 = _mm_shuffle_ps(uv23, _mm_sub_ps(ones, uv23), _MM_SHUFFLE(3, 1, 2, 0));
+            uv23 = _mm_shuffle_ps(uv23, uv23, _MM_SHUFFLE(3, 1, 2, 0));
+
+            // x0 y0 z0 u0 | v0 x1 y1 z1 | u1 v1 x2 y2 | z2 u2 v2 x3 | y3 z3 u3 v3
+            const auto o0 = _mm_shuffle_ps(p0, _mm_shuffle_ps(p0, uv01, _MM_SHUFFLE(0, 0, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+            const auto o1 = _mm_shuffle_ps(_mm_shuffle_ps(uv01, p0, _MM_SHUFFLE(3, 3, 1, 1)), p1, _MM_SHUFFLE(1, 0, 2, 0));
+            const auto o2 = _mm_shuffle_ps(uv01, p1, _MM_SHUFFLE(3, 2, 3, 2));
+            const auto o3 = _mm_shuffle_ps(_mm_shuffle_ps(p2, uv23, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(uv23, p2, _MM_SHUFFLE(1, 1, 1, 1)), _MM_SHUFFLE(2, 0, 2, 0));
+            const auto o4 = _mm_shuffle_ps(p2, uv23, _MM_SHUFFLE(3, 2, 3, 2));
+
+            _mm_storeu_ps(output + i * 5 + 0, o0);
+            _mm_storeu_ps(output + i * 5 + 4, o1);
+            _mm_storeu_ps(output + i * 5 + 8, o2);
+            _mm_storeu_ps(output + i * 5 + 12, o3);
+            _mm_storeu_ps(output + i * 5 + 16, o4);
+        }
+#endif
+
+        for (; i < end; ++i)
+        {
+            const auto position = source->mVertices[i];
+            const auto mapping = source->mTextureCoords[0][i];
+
+            destination[i] = {
+                { position.x, position.y, position.z },
+                { mapping.x, 1.0f - mapping.y },
+            };
+        }
+    }
+    // Faces [begin, end) as triangles into `destination`. assimp allocates every face's indices separately,
+    // so each face is one 12-byte copy with the faces a few steps ahead prefetched.
+    static auto convert_indices(const aiMesh* source, std::uint32_t* destination, size_t begin, size_t end) -> void
+    {
+        static_assert(sizeof(unsigned int) == sizeof(std::uint32_t));
+
+        constexpr size_t PREFETCH_DISTANCE = 16;
+
+        for (auto i = begin; i < end; ++i)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            if (i + PREFETCH_DISTANCE < end) __builtin_prefetch(source->mFaces[i + PREFETCH_DISTANCE].mIndices);
+#endif
+
+            std::memcpy(destination + i * 3, source->mFaces[i].mIndices, 3 * sizeof(std::uint32_t));
+        }
+    }
+    // Large meshes are split into ranges on `jobs`, every range converts with the kernels above.
+    static auto convert_vertices(const aiMesh* source, JobSystem* jobs = nullptr) -> std::vector<Vertex>
+    {
+        auto vertices = std::vector<Vertex>(source->mNumVertices);
+
+        if (jobs)
+        {
+            jobs->parallel_for(0, vertices.size(), [&](size_t begin, size_t end) { convert_vertices(source, vertices.data(), begin, end); }, CONVERT_GRAIN);
+        }
+        else
+        {
+            convert_vertices(source, vertices.data(), 0, vertices.size());
+        }
+
+        return vertices;
+    }
+    static auto convert_indices(const aiMesh* source, JobSystem* jobs = nullptr) -> std::vector<std::uint32_t>
+    {
+        auto indices = std::vector<std::uint32_t>(source->mNumFaces * 3);
+
+        if (jobs)
+        {
+            jobs->parallel_for(0, source->mNumFaces, [&](size_t begin, size_t end) { convert_indices(source, indices.data(), begin, end); }, CONVERT_GRAIN);
+        }
+        else
+        {
+            convert_indices(source, indices.data(), 0, source->mNumFaces);
+        }
+
+        return indices;
+    }
+    static auto bounds(const std::vector<Vertex>& vertices) -> std::pair<glm::vec3, glm::vec3>
+    {
+        auto minimum = glm::vec3(0.0f);
+        auto maximum = glm::vec3(0.0f);
+
+        if (!vertices.empty())
+        {
+            minimum = maximum = vertices.front().position;
+
+            for (const auto& vertex : vertices)
+            {
+                minimum = glm::min(minimum, vertex.position);
+                maximum = glm::max(maximum, vertex.position);
+            }
+        }
+
+        return { minimum, maximum };
+    }
+    // Square root of the UV area over the object space area of all triangles: how many UV units one unit of the
+    // surface spans on average. 0 for meshes without area or without UVs.
+    static auto density(const std::vector<Vertex>& vertices, const std::vector<std::uint32_t>& indices) -> float
+    {
+        double surface = 0.0;
+        double mapped = 0.0;
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const auto& a = vertices[indices[i + 0]];
+            const auto& b = vertices[indices[i + 1]];
+            const auto& c = vertices[indices[i + 2]];
+
+            const auto edges = glm::cross(b.position - a.position, c.position - a.position);
+            const auto u = b.mapping - a.mapping;
+            const auto v = c.mapping - a.mapping;
+
+            surface += glm::length(edges);
+            mapped += std::abs(u.x * v.y - u.y * v.x);
+        }
+
+        return surface > 0.0 ? static_cast<float>(std::sqrt(mapped / surface)) : 0.0f;
+    }
+    // Vertex arrays are not shared between contexts, so they are created separately from the buffers.
+    static auto create_vertex_arrays(GLuint vertex_buffer, GLuint index_buffer) -> GLuint
+    {
+        GLuint vertex_arrays;
+
+        glCreateVertexArrays(1, &vertex_arrays);
+        glVertexArrayVertexBuffer(vertex_arrays, 0, vertex_buffer, 0, sizeof(Vertex));
+
+        glVertexArrayAttribBinding(vertex_arrays, 0, 0);
+        glVertexArrayAttribFormat(vertex_arrays, 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+        glEnableVertexArrayAttrib(vertex_arrays, 0);
+
+        glVertexArrayAttribBinding(vertex_arrays, 1, 0);
+        glVertexArrayAttribFormat(vertex_arrays, 1, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, mapping));
+        glEnableVertexArrayAttrib(vertex_arrays, 1);
+
+        glVertexArrayElementBuffer(vertex_arrays, index_buffer);
+
+        return vertex_arrays;
+    }
+    // CPU side of a mesh, ready to upload.
+    struct Converted
+    {
+        std::vector<Vertex>        vertices;
+        std::vector<std::uint32_t> indices;
+        glm::vec3                  minimum;
+        glm::vec3                  maximum;
+        float                      uv_density = 0.0f;
+    };
+
+    // Welds duplicate vertices with `weld_epsilon` unless it is empty, see VertexWeld.
+    static auto convert(const aiMesh* source, JobSystem* jobs = nullptr, std::optional<float> weld_epsilon = VertexWeld::configured()) -> Converted
+    {
+        PROFILE_SCOPE("Mesh::convert");
+
+        auto converted = Converted{ Mesh::convert_vertices(source, jobs), Mesh::convert_indices(source, jobs) };
+
+        if (weld_epsilon) VertexWeld::weld(converted.vertices, converted.indices, *weld_epsilon, jobs);
+
+        std::tie(converted.minimum, converted.maximum) = Mesh::bounds(converted.vertices);
+        converted.uv_density = Mesh::density(converted.vertices, converted.indices);
+
+        return converted;
+    }
+    // A native glTF primitive read from the mapped buffers straight into Vertex layout, positions and UVs
+    // written in place by the accessor readers. UVs stay as stored, glTF's origin is already the top left.
+    static auto convert(const GltfScene& scene, const GltfScene::Primitive& primitive, JobSystem* jobs = nullptr, std::optional<float> weld_epsilon = VertexWeld::configured()) -> Converted
+    {
+        PROFILE_SCOPE("Mesh::convert glTF");
+
+        const auto& positions = scene.accessors[primitive.position];
+        const auto mappings = primitive.mapping != GltfScene::NONE ? scene.accessors[primitive.mapping] : GltfScene::Accessor();
+
+        auto converted = Converted{ std::vector<Vertex>(positions.count), std::vector<std::uint32_t>(scene.triangles(primitive) * 3) };
+
+        const auto output = reinterpret_cast<float*>(converted.vertices.data());
+        const auto read_vertices = [&](size_t begin, size_t end)
+        {
+            GltfScene::read(positions, output + offsetof(Vertex, position) / sizeof(float), 5, 3, begin, end);
+            GltfScene::read(mappings, output + offsetof(Vertex, mapping) / sizeof(float), 5, 2, begin, end);
+        };
+        const auto read_indices = [&](size_t begin, size_t end)
+        {
+            scene.read_triangles(primitive, converted.indices.data(), begin, end);
+        };
+
+        if (jobs)
+        {
+            jobs->parallel_for(0, converted.vertices.size(), read_vertices, CONVERT_GRAIN);
+            jobs->parallel_for(0, converted.indices.size() / 3, read_indices, CONVERT_GRAIN);
+        }
+        else
+        {
+            read_vertices(0, converted.vertices.size());
+            read_indices(0, converted.indices.size() / 3);
+        }
+
+        if (weld_epsilon) VertexWeld::weld(converted.vertices, converted.indices, *weld_epsilon, jobs);
+
+        std::tie(converted.minimum, converted.maximum) = Mesh::bounds(converted.vertices);
+        converted.uv_density = Mesh::density(converted.vertices, converted.indices);
+
+        return converted;
+    }
+    static auto upload(const Converted& converted, std::shared_ptr<Material> material) -> std::shared_ptr<Mesh>
+    {
+        PROFILE_SCOPE("mesh upload");
+
+        GLuint vertex_buffer;
+
+        glCreateBuffers(1, &vertex_buffer);
+        glNamedBufferStorage(vertex_buffer, sizeof(Vertex) * converted.vertices.size(), converted.vertices.data(), 0);
+
+        GLuint index_buffer;
+
+        glCreateBuffers(1, &index_buffer);
+        glNamedBufferStorage(index_buffer, sizeof(std::uint32_t) * converted.indices.size(), converted.indices.data(), 0);
+
+        return std::make_shared<Mesh>(vertex_buffer, index_buffer, Mesh::create_vertex_arrays(vertex_buffer, index_buffer), converted.indices.size(), material, converted.minimum, converted.maximum, converted.uv_density);
+    }
+    static auto from(const aiMesh* source, const std::vector<std::shared_ptr<Material>>& materials)
+    {
+        PROFILE_SCOPE("Mesh::from");
+
+        const auto material = source->mMaterialIndex < materials.size() ? materials[source->mMaterialIndex] : nullptr;
+
+        return Mesh::upload(Mesh::convert(source), material);
+    }
+    // With `jobs` every mesh converts in parallel, large ones split further, then all upload on the calling thread.
+    static auto from(const aiScene* source, const std::vector<std::shared_ptr<Material>>& materials, JobSystem* jobs = nullptr)
+    {
+        std::vector<std::shared_ptr<Mesh>> meshes;
+
+        if (!jobs)
+        {
+            for (size_t i = 0; i < source->mNumMeshes; ++i)
+            {
+                meshes.push_back(Mesh::from(source->mMeshes[i], materials));
+            }
+
+            return meshes;
+        }
+
+        PROFILE_SCOPE("Mesh::from scene");
+
+        std::vector<Converted> converted(source->mNumMeshes);
+
+        jobs->parallel_for(0, converted.size(), [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) converted[i] = Mesh::convert(source->mMeshes[i], jobs);
+        }, 1);
+
+        for (size_t i = 0; i < converted.size(); ++i)
+        {
+            const auto index = source->mMeshes[i]->mMaterialIndex;
+
+            meshes.push_back(Mesh::upload(converted[i], index < materials.size() ? materials[index] : nullptr));
+
+            converted[i] = {};
+        }
+
+        return meshes;
+    }
+
+    // Meshes of every glTF mesh, one per primitive. With `jobs` all primitives convert in parallel, large ones
+    // split further, then upload on the calling thread.
+    static auto from(const GltfScene& scene, const std::vector<std::shared_ptr<Material>>& materials, JobSystem* jobs = nullptr) -> std::vector<std::vector<std::shared_ptr<Mesh>>>
+    {
+        PROFILE_SCOPE("Mesh::from glTF");
+
+        std::vector<std::pair<size_t, size_t>> primitives;
+
+        for (size_t mesh = 0; mesh < scene.meshes.size(); ++mesh)
+        {
+            for (size_t primitive = 0; primitive < scene.meshes[mesh].primitives.size(); ++primitive) primitives.emplace_back(mesh, primitive);
+        }
+
+        std::vector<Converted> converted(primitives.size());
+
+        const auto convert_primitives = [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) converted[i] = Mesh::convert(scene, scene.meshes[primitives[i].first].primitives[primitives[i].second], jobs);
+        };
+
+        if (jobs) jobs->parallel_for(0, primitives.size(), convert_primitives, 1);
+        else convert_primitives(0, primitives.size());
+
+        std::vector<std::vector<std::shared_ptr<Mesh>>> meshes(scene.meshes.size());
+
+        for (size_t i = 0; i < primitives.size(); ++i)
+        {
+            const auto material = scene.meshes[primitives[i].first].primitives[primitives[i].second].material;
+
+            meshes[primitives[i].first].push_back(Mesh::upload(converted[i], material != GltfScene::NONE ? materials[material] : nullptr));
+
+            converted[i] = {};
+        }
+
+        return meshes;
+    }
+
+    Mesh(
+        GLuint vertex_buffer,
+        GLuint index_buffer,
+        GLuint vertex_arrays,
+        size_t indices_count,
+        std::shared_ptr<Material> material,
+        const glm::vec3& minimum = glm::vec3(0.0f),
+        const glm::vec3& maximum = glm::vec3(0.0f),
+        float uv_density = 0.0f
+    ):
+        vertex_buffer(vertex_buffer),
+        index_buffer(index_buffer),
+        vertex_arrays(vertex_arrays),
+        indices_count(indices_count),
+        material(material),
+        minimum(minimum),
+        maximum(maximum),
+        uv_density(uv_density)
+    {
+    }
+
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    GLuint vertex_arrays;
+    size_t indices_count;
+    std::shared_ptr<Material> material;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+    // UV units per object space unit, 0 when unknown.
+    float uv_density;
+
+private:
+    // Vertices or faces per job when a single mesh is split.
+    static constexpr size_t CONVERT_GRAIN = 16384;
+};
+
+struct Node
+{
+    static auto from(const aiNode* source, const std::vector<std::shared_ptr<Mesh>>& source_meshes, const std::shared_ptr<Node>& parent = nullptr) -> std::shared_ptr<Node>
+    {
+        PROFILE_SCOPE("Node::from");
+
+        std::vector<std::shared_ptr<Mesh>> meshes;
+
+        for (size_t i = 0; i < source->mNumMeshes; ++i)
+        {
+            meshes.push_back(source_meshes[source->mMeshes[i]]);
+        }
+
+        auto m = source->mTransformation;
+        auto transformation = glm::transpose(glm::mat4(
+            +m.a1, +m.a2, +m.a3, +m.a4,
+            +m.b1, +m.b2, +m.b3, +m.b4,
+            +m.c1, +m.c2, +m.c3, +m.c4,
+            +m.d1, +m.d2, +m.d3, +m.d4
+        ));
+
+        if (parent) transformation = parent->transformation * transformation;
+
+        auto node = std::make_shared<Node>(meshes, transformation);
+
+        for (size_t i = 0; i < source->mNumChildren; ++i)
+        {
+            node->children.push_back(Node::from(source->mChildren[i], source_meshes, node));
+        }
+
+        return node;
+    }
+    // `directory` holds the scene file, see Material::texture_source.
+    static auto from(const aiScene* scene, const std::filesystem::path& directory, JobSystem* jobs = nullptr) -> std::shared_ptr<Node>
+    {
+        return Node::from(scene, Material::from(scene, directory, jobs), jobs);
+    }
+    // With materials made elsewhere, e.g. by a TextureManager.
+    static auto from(const aiScene* scene, const std::vector<std::shared_ptr<Material>>& materials, JobSystem* jobs = nullptr) -> std::shared_ptr<Node>
+    {
+        PROFILE_SCOPE("Node::from scene");
+
+        auto meshes = Mesh::from(scene, materials, jobs);
+
+        return Node::from(scene->mRootNode, meshes);
+    }
+
+    static auto from(const GltfScene& scene, size_t index, const std::vector<std::vector<std::shared_ptr<Mesh>>>& meshes, const std::shared_ptr<Node>& parent = nullptr) -> std::shared_ptr<Node>
+    {
+        const auto& source = scene.nodes[index];
+
+        auto transformation = glm::make_mat4(source.matrix);
+
+        if (parent) transformation = parent->transformation * transformation;
+
+        auto node = std::make_shared<Node>(source.mesh != GltfScene::NONE ? meshes[source.mesh] : std::vector<std::shared_ptr<Mesh>>(), transformation);
+
+        for (const auto child : source.children)
+        {
+            node->children.push_back(Node::from(scene, child, meshes, node));
+        }
+
+        return node;
+    }
+    static auto from(const GltfScene& scene, JobSystem* jobs = nullptr) -> std::shared_ptr<Node>
+    {
+        return Node::from(scene, Material::from(scene, jobs), jobs);
+    }
+    static auto from(const GltfScene& scene, const std::vector<std::shared_ptr<Material>>& materials, JobSystem* jobs = nullptr) -> std::shared_ptr<Node>
+    {
+        PROFILE_SCOPE("Node::from glTF");
+
+        return Node::from(scene, Mesh::from(scene, materials, jobs));
+    }
+    // With the meshes of every glTF mesh made elsewhere, e.g. the placeholders of a SceneStreamer. Several
+    // top-level nodes hang below an identity root, the way assimp imports them.
+    static auto from(const GltfScene& scene, const std::vector<std::vector<std::shared_ptr<Mesh>>>& meshes) -> std::shared_ptr<Node>
+    {
+        if (scene.roots.size() == 1) return Node::from(scene, scene.roots.front(), meshes);
+
+        auto root = std::make_shared<Node>(std::vector<std::shared_ptr<Mesh>>(), glm::mat4(1.0f));
+
+        for (const auto index : scene.roots)
+        {
+            root->children.push_back(Node::from(scene, index, meshes, root));
+        }
+
+        return root;
+    }
+
+    Node(
+        const std::vector<std::shared_ptr<Mesh>>& meshes,
+        const glm::mat4& transformation
+    ):
+        meshes(meshes),
+        transformation(transformation)
+    {
+    }
+
+    auto render(GLuint program, const glm::mat4& vp) -> size_t
+    {
+        PROFILE_SCOPE("Node::render");
+
+        glProgramUniformMatrix4fv(program, 0, 1, GL_FALSE, glm::value_ptr(vp * transformation));
+
+        for (const auto &mesh : meshes)
+        {
+            glActiveTexture(GL_TEXTURE0);
+
+            if (mesh->material)
+            {
+                glBindTexture(GL_TEXTURE_2D, mesh->material->texture);
+            }
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, 0);
+            }
+
+            glBindVertexArray(mesh->vertex_arrays);
+            glDrawElements(GL_TRIANGLES, mesh->indices_count, GL_UNSIGNED_INT, 0);
+        }
+
+        auto draws = meshes.size();
+
+        for (const auto &child : children)
+        {
+            draws += child->render(program, vp);
+        }
+
+        return draws;
+    }
+
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    std::vector<std::shared_ptr<Node>> children;
+    glm::mat4                          transformation;
+};
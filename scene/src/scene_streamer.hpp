@@ -0,0 +1,389 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <asset_io_system.hpp>
+#include <gltf_scene.hpp>
+#include <job_system.hpp>
+#include <profiler.hpp>
+#include <scene.hpp>
+
+// Imports a scene on a loader thread that owns a second context sharing objects with the render context.
+// The loader publishes the node tree as soon as the import is done, then decodes and uploads textures and
+// mesh buffers one by one, each followed by a fence. The render thread calls adopt() once per frame to take
+// over the uploads whose fences have signaled, within a byte and time budget, so a frame never stalls on
+// loading. Until then meshes are skipped and materials show a placeholder texture.
+// With the native importer .gltf and .glb load through GltfScene, anything else through assimp; `jobs` splits
+// the conversion of large meshes and may be shared with the render thread.
+struct SceneStreamer
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Budget
+    {
+        double megabytes    = 16.0;
+        double milliseconds = 2.0;
+    };
+
+    // `attach` and `detach` make the shared context current on the loader thread and release it again.
+    // Construct with the render context current, the placeholder texture is created right away.
+    SceneStreamer(const std::string& path, const std::string& importer, JobSystem* jobs, std::function<void()> attach, std::function<void()> detach, Budget budget):
+        budget(budget),
+        started(Clock::now()),
+        jobs(jobs)
+    {
+        const std::uint8_t pixels[] = { 160, 160, 160, 255 };
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &placeholder);
+        glTextureStorage2D(placeholder, 1, GL_RGBA8, 1, 1);
+        glTextureSubImage2D(placeholder, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+        loader = std::thread([this, path, importer, attach, detach]
+        {
+            PROFILE_THREAD("loader");
+
+            attach();
+
+            try
+            {
+                const auto extension = std::filesystem::path(path).extension();
+
+                if (importer == "native" && (extension == ".gltf" || extension == ".glb")) load_native(path);
+                else load_assimp(path);
+            }
+            catch (...)
+            {
+                auto lock = std::lock_guard(mutex);
+
+                failure = std::current_exception();
+            }
+
+            detach();
+
+            loaded.store(true, std::memory_order_release);
+        });
+    }
+    SceneStreamer(const SceneStreamer&) = delete;
+    ~SceneStreamer()
+    {
+        cancelled.store(true, std::memory_order_relaxed);
+        loader.join();
+    }
+
+    auto operator=(const SceneStreamer&) -> SceneStreamer& = delete;
+
+    // Call on the render thread every frame. Returns true when the node tree has just become available.
+    auto adopt() -> bool
+    {
+        PROFILE_SCOPE("SceneStreamer::adopt");
+
+        const auto begin = Clock::now();
+        auto structure = false;
+
+        {
+            auto lock = std::lock_guard(mutex);
+
+            if (failure) std::rethrow_exception(failure);
+
+            if (!root && pending_root)
+            {
+                root = std::move(pending_root);
+                materials = std::move(pending_materials);
+                meshes = std::move(pending_meshes);
+                structure = true;
+
+                for (const auto& material : materials)
+                {
+                    if (material) material->texture = placeholder;
+                }
+            }
+        }
+
+        if (!root) return structure;
+
+        size_t bytes = 0;
+        size_t adopted = 0;
+
+        for (;;)
+        {
+            const auto elapsed = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+            // At least one upload per frame, so a single resource above the budget cannot stall streaming.
+            if (adopted > 0 && (static_cast<double>(bytes) >= budget.megabytes * 1024.0 * 1024.0 || elapsed >= budget.milliseconds)) break;
+
+            Upload upload;
+
+            {
+                auto lock = std::lock_guard(mutex);
+
+                if (uploads.empty()) break;
+
+                upload = uploads.front();
+            }
+
+            if (glClientWaitSync(upload.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+
+            glDeleteSync(upload.fence);
+
+            {
+                auto lock = std::lock_guard(mutex);
+
+                uploads.pop_front();
+            }
+
+            if (upload.mesh)
+            {
+                auto& mesh = *meshes[upload.index];
+
+                mesh.vertex_buffer = upload.vertex_buffer;
+                mesh.index_buffer = upload.index_buffer;
+                mesh.indices_count = upload.indices_count;
+                mesh.minimum = upload.minimum;
+                mesh.maximum = upload.maximum;
+                mesh.uv_density = upload.uv_density;
+                mesh.vertex_arrays = Mesh::create_vertex_arrays(upload.vertex_buffer, upload.index_buffer);
+            }
+            else
+            {
+                materials[upload.index]->texture = upload.texture;
+            }
+
+            bytes += upload.bytes;
+            adopted_bytes += upload.bytes;
+            ++adopted;
+        }
+
+        if (!complete() && loaded.load(std::memory_order_acquire))
+        {
+            auto lock = std::lock_guard(mutex);
+
+            if (uploads.empty()) completed = Clock::now();
+        }
+
+        return structure;
+    }
+
+    auto complete() const -> bool
+    {
+        return completed != Clock::time_point();
+    }
+
+    Budget                                 budget;
+    Clock::time_point                      started;
+    Clock::time_point                      completed;
+    GLuint                                 placeholder = 0;
+    size_t                                 adopted_bytes = 0;
+    std::shared_ptr<Node>                  root;
+    std::vector<std::shared_ptr<Material>> materials;
+    std::vector<std::shared_ptr<Mesh>>     meshes;
+
+private:
+    struct Upload
+    {
+        bool          mesh = false;
+        size_t        index = 0;
+        GLuint        texture = 0;
+        GLuint        vertex_buffer = 0;
+        GLuint        index_buffer = 0;
+        size_t        indices_count = 0;
+        glm::vec3     minimum = glm::vec3(0.0f);
+        glm::vec3     maximum = glm::vec3(0.0f);
+        float         uv_density = 0.0f;
+        size_t        bytes = 0;
+        GLsync        fence = nullptr;
+    };
+
+    auto publish(Upload upload) -> void
+    {
+        upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        // Fences only become visible to the other context once the commands before them are flushed.
+        glFlush();
+
+        auto lock = std::lock_guard(mutex);
+
+        uploads.push_back(upload);
+    }
+
+    auto publish(size_t index, GLuint texture) -> void
+    {
+        Upload upload;
+
+        upload.index = index;
+        upload.texture = texture;
+        upload.bytes = Material::bytes(texture);
+
+        publish(upload);
+    }
+
+    auto publish(size_t index, const Mesh::Converted& converted) -> void
+    {
+        const auto& vertices = converted.vertices;
+        const auto& indices = converted.indices;
+
+        Upload upload;
+
+        upload.mesh = true;
+        upload.index = index;
+        upload.indices_count = indices.size();
+        upload.minimum = converted.minimum;
+        upload.maximum = converted.maximum;
+        upload.uv_density = converted.uv_density;
+        upload.bytes = sizeof(Vertex) * vertices.size() + sizeof(std::uint32_t) * indices.size();
+
+        glCreateBuffers(1, &upload.vertex_buffer);
+        glNamedBufferStorage(upload.vertex_buffer, sizeof(Vertex) * vertices.size(), vertices.data(), 0);
+        glCreateBuffers(1, &upload.index_buffer);
+        glNamedBufferStorage(upload.index_buffer, sizeof(std::uint32_t) * indices.size(), indices.data(), 0);
+
+        publish(upload);
+    }
+
+    // Hands the skeleton to the render thread, it can start culling and drawing while resources trickle in.
+    auto publish(std::shared_ptr<Node> scene_root, std::vector<std::shared_ptr<Material>> scene_materials, std::vector<std::shared_ptr<Mesh>> scene_meshes) -> void
+    {
+        auto lock = std::lock_guard(mutex);
+
+        pending_root = std::move(scene_root);
+        pending_materials = std::move(scene_materials);
+        pending_meshes = std::move(scene_meshes);
+    }
+
+    auto load_assimp(const std::string& path) -> void
+    {
+        Assimp::Importer importer;
+
+        importer.SetIOHandler(new AssetIOSystem());
+
+        const aiScene* scene;
+
+        {
+            PROFILE_SCOPE("assimp import");
+
+            scene = importer.ReadFile(path, aiProcess_Triangulate);
+        }
+
+        if (!scene) throw std::runtime_error(importer.GetErrorString());
+
+        std::vector<std::shared_ptr<Material>> scene_materials;
+        std::vector<std::shared_ptr<Mesh>> scene_meshes;
+
+        for (size_t i = 0; i < scene->mNumMaterials; ++i)
+        {
+            aiString texture_path;
+
+            scene->mMaterials[i]->GetTexture(aiTextureType::aiTextureType_DIFFUSE, 0, &texture_path, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+            scene_materials.push_back(texture_path.length > 0 ? std::make_shared<Material>(0) : nullptr);
+        }
+
+        for (size_t i = 0; i < scene->mNumMeshes; ++i)
+        {
+            const auto index = scene->mMeshes[i]->mMaterialIndex;
+            const auto material = index < scene_materials.size() ? scene_materials[index] : nullptr;
+
+            scene_meshes.push_back(std::make_shared<Mesh>(0, 0, 0, 0, material));
+        }
+
+        publish(Node::from(scene->mRootNode, scene_meshes), std::move(scene_materials), std::move(scene_meshes));
+
+        auto ring = StagingRing();
+        const auto directory = std::filesystem::path(path).parent_path();
+
+        for (size_t i = 0; i < scene->mNumMaterials && !cancelled.load(std::memory_order_relaxed); ++i)
+        {
+            const auto texture = Material::load_texture(scene, i, directory, &ring);
+
+            if (texture != 0) publish(i, texture);
+        }
+
+        for (size_t i = 0; i < scene->mNumMeshes && !cancelled.load(std::memory_order_relaxed); ++i)
+        {
+            PROFILE_SCOPE("Mesh::from");
+
+            publish(i, Mesh::convert(scene->mMeshes[i], jobs));
+        }
+    }
+
+    // Materials sharing a base color image share one Material, so every image decodes once; meshes are the
+    // primitives of all glTF meshes in order.
+    auto load_native(const std::string& path) -> void
+    {
+        const auto scene = GltfScene::load(path, jobs);
+
+        std::vector<size_t> images;
+
+        for (const auto& material : scene.materials)
+        {
+            if (material.base_color != GltfScene::NONE) images.push_back(material.base_color);
+        }
+
+        std::sort(images.begin(), images.end());
+        images.erase(std::unique(images.begin(), images.end()), images.end());
+
+        std::vector<std::shared_ptr<Material>> scene_materials;
+        std::vector<std::shared_ptr<Mesh>> scene_meshes;
+        std::vector<std::vector<std::shared_ptr<Mesh>>> node_meshes(scene.meshes.size());
+        std::vector<const GltfScene::Primitive*> primitives;
+
+        for (size_t i = 0; i < images.size(); ++i) scene_materials.push_back(std::make_shared<Material>(0));
+
+        for (size_t i = 0; i < scene.meshes.size(); ++i)
+        {
+            for (const auto& primitive : scene.meshes[i].primitives)
+            {
+                const auto image = primitive.material != GltfScene::NONE ? scene.materials[primitive.material].base_color : GltfScene::NONE;
+                const auto material = image != GltfScene::NONE ? scene_materials[std::lower_bound(images.begin(), images.end(), image) - images.begin()] : nullptr;
+
+                scene_meshes.push_back(std::make_shared<Mesh>(0, 0, 0, 0, material));
+                node_meshes[i].push_back(scene_meshes.back());
+                primitives.push_back(&primitive);
+            }
+        }
+
+        publish(Node::from(scene, node_meshes), std::move(scene_materials), std::move(scene_meshes));
+
+        auto ring = StagingRing();
+
+        for (size_t i = 0; i < images.size() && !cancelled.load(std::memory_order_relaxed); ++i)
+        {
+            const auto& image = scene.images[images[i]];
+
+            publish(i, image.data ? Material::load_texture(image.data, image.size, &ring) : Material::load_texture(AssetFile::open(image.path), &ring));
+        }
+
+        for (size_t i = 0; i < primitives.size() && !cancelled.load(std::memory_order_relaxed); ++i)
+        {
+            PROFILE_SCOPE("Mesh::from glTF");
+
+            publish(i, Mesh::convert(scene, *primitives[i], jobs));
+        }
+    }
+
+    JobSystem*                             jobs;
+    std::thread                            loader;
+    std::mutex                             mutex;
+    std::deque<Upload>                     uploads;
+    std::exception_ptr                     failure;
+    std::atomic<bool>                      loaded    = false;
+    std::atomic<bool>                      cancelled = false;
+    std::shared_ptr<Node>                  pending_root;
+    std::vector<std::shared_ptr<Material>> pending_materials;
+    std::vector<std::shared_ptr<Mesh>>     pending_meshes;
+};
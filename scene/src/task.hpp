@@ -0,0 +1,363 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Lazy coroutine: nothing runs until it is co_awaited, then it runs on the awaiting thread until it awaits
+// an executor (ThreadPool::schedule(), GlExecutor::schedule()) itself. Completion resumes the awaiting
+// coroutine right away on the thread that finished, through symmetric transfer, so chains never grow the stack.
+//
+//     auto load(ThreadPool& pool, std::string path) -> Task<std::vector<std::uint8_t>>
+//     {
+//         co_await pool.schedule();
+//         co_return read(path);
+//     }
+template <typename T = void>
+struct Task;
+
+namespace task_detail
+{
+    struct FinalAwaiter
+    {
+        auto await_ready() const noexcept -> bool
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) const noexcept -> std::coroutine_handle<>
+        {
+            const auto continuation = handle.promise().continuation;
+
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        auto await_resume() const noexcept -> void
+        {
+        }
+    };
+
+    struct PromiseBase
+    {
+        auto initial_suspend() const noexcept -> std::suspend_always
+        {
+            return {};
+        }
+
+        auto final_suspend() const noexcept -> FinalAwaiter
+        {
+            return {};
+        }
+
+        std::coroutine_handle<> continuation;
+    };
+
+    template <typename T>
+    struct Promise : PromiseBase
+    {
+        auto get_return_object() -> Task<T>;
+
+        template <typename U>
+        auto return_value(U&& value) -> void
+        {
+            result.template emplace<1>(std::forward<U>(value));
+        }
+
+        auto unhandled_exception() -> void
+        {
+            result.template emplace<2>(std::current_exception());
+        }
+
+        auto take() -> T
+        {
+            if (result.index() == 2) std::rethrow_exception(std::get<2>(result));
+
+            return std::move(std::get<1>(result));
+        }
+
+        std::variant<std::monostate, T, std::exception_ptr> result;
+    };
+
+    template <>
+    struct Promise<void> : PromiseBase
+    {
+        auto get_return_object() -> Task<void>;
+
+        auto return_void() -> void
+        {
+        }
+
+        auto unhandled_exception() -> void
+        {
+            failure = std::current_exception();
+        }
+
+        auto take() -> void
+        {
+            if (failure) std::rethrow_exception(failure);
+        }
+
+        std::exception_ptr failure;
+    };
+
+    // Eager, self-destroying coroutine used to start tasks without awaiting them.
+    struct Detached
+    {
+        struct promise_type
+        {
+            auto get_return_object() -> Detached
+            {
+                return {};
+            }
+
+            auto initial_suspend() const noexcept -> std::suspend_never
+            {
+                return {};
+            }
+
+            auto final_suspend() const noexcept -> std::suspend_never
+            {
+                return {};
+            }
+
+            auto return_void() -> void
+            {
+            }
+
+            auto unhandled_exception() -> void
+            {
+                std::terminate();
+            }
+        };
+    };
+}
+
+template <typename T>
+struct Task
+{
+    using promise_type = task_detail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle):
+        handle(handle)
+    {
+    }
+    Task(Task&& other) noexcept:
+        handle(std::exchange(other.handle, nullptr))
+    {
+    }
+    Task(const Task&) = delete;
+    ~Task()
+    {
+        if (handle) handle.destroy();
+    }
+
+    auto operator=(Task&& other) noexcept -> Task&
+    {
+        if (this != &other)
+        {
+            if (handle) handle.destroy();
+
+            handle = std::exchange(other.handle, nullptr);
+        }
+
+        return *this;
+    }
+    auto operator=(const Task&) -> Task& = delete;
+
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            auto await_ready() const noexcept -> bool
+            {
+                return false;
+            }
+
+            auto await_suspend(std::coroutine_handle<> awaiting) noexcept -> std::coroutine_handle<>
+            {
+                handle.promise().continuation = awaiting;
+
+                return handle;
+            }
+
+            auto await_resume() -> T
+            {
+                return handle.promise().take();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+        };
+
+        return Awaiter{ handle };
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+auto task_detail::Promise<T>::get_return_object() -> Task<T>
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline auto task_detail::Promise<void>::get_return_object() -> Task<void>
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// Runs all tasks concurrently and resumes once the last one finished, on the thread that finished it.
+// Every task runs to completion even when one fails, then the first exception is rethrown.
+template <typename T>
+auto when_all(std::vector<Task<T>> tasks) -> Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>
+{
+    struct State
+    {
+        // One extra count held by the awaiting coroutine until it has suspended.
+        std::atomic<size_t>      remaining;
+        std::coroutine_handle<>  awaiting;
+        std::mutex               mutex;
+        std::exception_ptr       failure;
+        std::conditional_t<std::is_void_v<T>, std::monostate, std::vector<std::optional<T>>> results;
+
+        auto finish() -> void
+        {
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) awaiting.resume();
+        }
+    };
+
+    struct Awaiter
+    {
+        static auto run(Task<T> task, State& state, size_t index) -> task_detail::Detached
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    co_await std::move(task);
+                }
+                else
+                {
+                    state.results[index].emplace(co_await std::move(task));
+                }
+            }
+            catch (...)
+            {
+                auto lock = std::lock_guard(state.mutex);
+
+                if (!state.failure) state.failure = std::current_exception();
+            }
+
+            state.finish();
+        }
+
+        auto await_ready() const noexcept -> bool
+        {
+            return tasks.empty();
+        }
+
+        auto await_suspend(std::coroutine_handle<> handle) -> bool
+        {
+            state.awaiting = handle;
+
+            for (size_t i = 0; i < tasks.size(); ++i) run(std::move(tasks[i]), state, i);
+
+            // Everything may have completed inline, then there is nothing to wait for.
+            return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+
+        auto await_resume() const noexcept -> void
+        {
+        }
+
+        std::vector<Task<T>>& tasks;
+        State&                state;
+    };
+
+    State state;
+
+    state.remaining.store(tasks.size() + 1, std::memory_order_relaxed);
+
+    if constexpr (!std::is_void_v<T>) state.results.resize(tasks.size());
+
+    co_await Awaiter{ tasks, state };
+
+    if (state.failure) std::rethrow_exception(state.failure);
+
+    if constexpr (!std::is_void_v<T>)
+    {
+        std::vector<T> results;
+
+        results.reserve(state.results.size());
+
+        for (auto& result : state.results) results.push_back(std::move(*result));
+
+        co_return results;
+    }
+}
+
+// Result slot of a task started with spawn(), for callers outside of coroutines such as a frame loop.
+template <typename T>
+struct Pending
+{
+    auto ready() const -> bool
+    {
+        return done.load(std::memory_order_acquire);
+    }
+
+    // Only once ready(), rethrows the task's exception.
+    auto get() -> std::conditional_t<std::is_void_v<T>, void, T>
+    {
+        if (failure) std::rethrow_exception(failure);
+
+        if constexpr (!std::is_void_v<T>) return std::move(*result);
+    }
+
+    std::atomic<bool>  done = false;
+    std::exception_ptr failure;
+    std::conditional_t<std::is_void_v<T>, std::monostate, std::optional<T>> result;
+};
+
+namespace task_detail
+{
+    template <typename T>
+    auto spawn(Task<T> task, std::shared_ptr<Pending<T>> pending) -> Detached
+    {
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                co_await std::move(task);
+            }
+            else
+            {
+                pending->result.emplace(co_await std::move(task));
+            }
+        }
+        catch (...)
+        {
+            pending->failure = std::current_exception();
+        }
+
+        pending->done.store(true, std::memory_order_release);
+    }
+}
+
+// Starts the task on the calling thread right away, it continues wherever its awaits take it.
+template <typename T>
+auto spawn(Task<T> task) -> std::shared_ptr<Pending<T>>
+{
+    auto pending = std::make_shared<Pending<T>>();
+
+    task_detail::spawn(std::move(task), pending);
+
+    return pending;
+}
@@ -0,0 +1,550 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <png.h>
+#include <assimp/scene.h>
+#include <asset_file.hpp>
+#include <gltf_scene.hpp>
+#include <job_system.hpp>
+#include <pixel_convert.hpp>
+#include <profiler.hpp>
+#include <scene.hpp>
+
+// Keeps the textures of a scene within `budget` bytes of texture memory, each only as detailed as the last frame
+// showed it. The manager makes the materials and keeps their encoded images, textures are only uploaded once a
+// draw list references them and their Material stays at texture 0 until then. Each frame update() loads what the
+// last frame drew but is not resident: least recently drawn textures are evicted to make room, and when that is
+// not enough the new ones are downscaled by powers of two at load until they fit.
+//
+// Textures hold the mip level the draw list feedback asks for and every coarser one, never the finer ones. The
+// coarsest levels upload first and GL_TEXTURE_BASE_LEVEL follows the finest one uploaded, so a texture is drawn
+// at some size right away and sharpens over the next frames as `upload_budget` allows. Surfaces that come
+// closer get a larger texture made from the encoded image, with the levels they had copied over, and ones that
+// move away drop to a smaller one. Sample them with a mipmapped min filter, the coarser levels count against the
+// budget and only that reads them.
+//
+//     auto textures = TextureManager(256 * 1024 * 1024, &jobs);
+//     const auto root = Node::from(scene, textures.materials(scene, directory), &jobs);
+//     // every frame, on the GL thread
+//     textures.update();
+//     draw_list.build(vp, textures.frame, glm::vec2(width, height));
+//
+// Textures are shared per encoded image. Missing ones draw as texture 0 for the frame or two it takes to
+// notice and load them. Draw lists built without a viewport give no feedback and get every texture at full size.
+struct TextureManager
+{
+    // Halvings of each side a texture may get at load, a 4096 x 4096 image still has 64 x 64 texels.
+    static constexpr std::uint32_t MAX_DOWNSCALE = 6;
+    // Mip bytes uploaded per update, on top of the first level of every texture that has none yet.
+    static constexpr size_t UPLOAD_BUDGET = 8 * 1024 * 1024;
+
+    struct Stats
+    {
+        size_t budget         = 0;
+        size_t resident_bytes = 0;
+        size_t resident       = 0;
+        // Drawn by the last frame but not resident after the update.
+        size_t missing        = 0;
+        size_t loaded         = 0;
+        size_t evicted        = 0;
+        // Loads that did not fit at the level the feedback asked for.
+        size_t downscaled     = 0;
+        // Resident textures swapped for finer or coarser ones to follow the feedback.
+        size_t refined        = 0;
+        size_t coarsened      = 0;
+        // Mip levels uploaded.
+        size_t streamed       = 0;
+        double update_ms      = 0.0;
+    };
+
+    TextureManager(size_t budget, JobSystem* jobs = nullptr):
+        budget(budget),
+        jobs(jobs)
+    {
+    }
+    TextureManager(const TextureManager&) = delete;
+    ~TextureManager()
+    {
+        for (auto& entry : entries)
+        {
+            Material::destroy(entry.texture);
+
+            entry.material->texture = 0;
+        }
+    }
+
+    auto operator=(const TextureManager&) -> TextureManager& = delete;
+
+    // Materials of an assimp scene for Node::from, one texture per embedded image or file however many materials
+    // use it. Embedded images are copied, the scene may go away after. `directory` holds the scene file.
+    auto materials(const aiScene* scene, const std::filesystem::path& directory) -> std::vector<std::shared_ptr<Material>>
+    {
+        std::map<std::pair<const std::uint8_t*, std::string>, std::shared_ptr<Material>> images;
+        std::vector<std::shared_ptr<Material>> materials;
+
+        for (size_t i = 0; i < scene->mNumMaterials; ++i)
+        {
+            const auto source = Material::texture_source(scene, i, directory);
+
+            if (source.empty())
+            {
+                materials.push_back(nullptr);
+
+                continue;
+            }
+
+            auto& shared = images[{ source.data, source.path }];
+
+            if (!shared) shared = add(source.data, source.size, source.path);
+
+            materials.push_back(shared);
+        }
+
+        return materials;
+    }
+    // Materials of a native glTF scene, one texture per image however many materials use it.
+    auto materials(const GltfScene& scene) -> std::vector<std::shared_ptr<Material>>
+    {
+        std::vector<std::shared_ptr<Material>> images(scene.images.size());
+        std::vector<std::shared_ptr<Material>> materials;
+
+        for (const auto& material : scene.materials)
+        {
+            if (material.base_color == GltfScene::NONE)
+            {
+                materials.push_back(nullptr);
+
+                continue;
+            }
+
+            auto& shared = images[material.base_color];
+            const auto& image = scene.images[material.base_color];
+
+            if (!shared) shared = add(image.data, image.size, image.path);
+
+            materials.push_back(shared);
+        }
+
+        return materials;
+    }
+
+    // Once per frame on the GL thread, before the draw list is built with `frame`.
+    auto update() -> void
+    {
+        PROFILE_SCOPE("TextureManager::update");
+
+        const auto started = std::chrono::steady_clock::now();
+        const auto drawn = frame;
+
+        ++frame;
+
+        stats = { budget };
+
+        std::vector<Entry*> loads;
+
+        for (auto& entry : entries)
+        {
+            entry.used = entry.material->used.load(std::memory_order_relaxed);
+            entry.feedback = entry.material->feedback.exchange(0.0f, std::memory_order_relaxed);
+
+            if (drawn == 0 || entry.used != drawn) continue;
+
+            // Coarser only two levels past the wanted one, so a surface on the edge does not flip every frame.
+            if (entry.texture == 0 || wanted(entry) < entry.top) loads.push_back(&entry);
+            else if (entry.pending.empty() && wanted(entry) >= entry.top + 2) coarsen(entry);
+        }
+
+        if (!loads.empty()) load(loads, drawn);
+
+        stream();
+
+        for (const auto& entry : entries)
+        {
+            if (entry.material->texture != 0) ++stats.resident;
+            else if (drawn != 0 && entry.used == drawn) ++stats.missing;
+        }
+
+        stats.resident_bytes = resident;
+        stats.update_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+        loads_total += stats.loaded;
+        evictions_total += stats.evicted;
+        downscales_total += stats.downscaled;
+        refines_total += stats.refined;
+        coarsens_total += stats.coarsened;
+        streamed_total += stats.streamed;
+        update_ms_max = std::max(update_ms_max, stats.update_ms);
+    }
+
+    size_t        budget;
+    size_t        upload_budget = UPLOAD_BUDGET;
+    // Stamp for DrawList::build, advanced by update().
+    std::uint64_t frame = 0;
+    // Of the last update().
+    Stats         stats;
+    size_t        resident         = 0;
+    size_t        loads_total      = 0;
+    size_t        evictions_total  = 0;
+    size_t        downscales_total = 0;
+    size_t        refines_total    = 0;
+    size_t        coarsens_total   = 0;
+    size_t        streamed_total   = 0;
+    double        update_ms_max    = 0.0;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Material> material;
+        // Image bytes copied out of the scene, or the file to read them from.
+        std::vector<std::uint8_t> encoded;
+        std::string               path;
+        // The material only gets the texture once a level of it is uploaded.
+        GLuint                    texture    = 0;
+        size_t                    bytes      = 0;
+        std::uint64_t             used       = 0;
+        float                     feedback   = 0.0f;
+        // Of the full size image, known after the first decode.
+        std::uint32_t             width      = 0;
+        std::uint32_t             height     = 0;
+        std::uint32_t             levels     = 0;
+        pixels::ChannelLayout     layout;
+        // Image level stored as level 0 of the texture, and the finest texture level uploaded so far.
+        std::uint32_t             top        = 0;
+        std::uint32_t             base       = 0;
+        // Image levels top .. top + base - 1 still to upload, finest first.
+        std::vector<Material::Image> pending;
+    };
+
+    struct Load
+    {
+        Entry*                       entry  = nullptr;
+        Material::Image              image;
+        std::uint32_t                target = 0;
+        std::vector<Material::Image> chain;
+    };
+
+    auto add(const std::uint8_t* data, size_t size, const std::string& path) -> std::shared_ptr<Material>
+    {
+        auto& entry = entries.emplace_back();
+
+        entry.material = std::make_shared<Material>(0);
+
+        if (data) entry.encoded.assign(data, data + size);
+        else entry.path = path;
+
+        return entry.material;
+    }
+
+    auto load(const std::vector<Entry*>& loads, std::uint64_t drawn) -> void
+    {
+        // Decoding and downscaling run on the jobs, only the uploads stay on this thread. Sizes are only known
+        // after the first decode, which picks the format from the content.
+        std::vector<Load> batch(loads.size());
+
+        parallel(loads.size(), [&](size_t i)
+        {
+            const auto entry = loads[i];
+
+            batch[i].entry = entry;
+
+            if (entry->levels != 0) return;
+
+            batch[i].image = decode(*entry);
+
+            entry->width = batch[i].image.width;
+            entry->height = batch[i].image.height;
+            entry->levels = std::bit_width(std::max(entry->width, entry->height));
+            entry->layout = batch[i].image.layout;
+        });
+
+        // Bytes the batch adds with `extra` halvings past the wanted levels. Resident textures that would not get
+        // finer are left out.
+        const auto needed = [&](std::uint32_t extra)
+        {
+            size_t total = 0;
+
+            for (const auto& item : batch)
+            {
+                const auto& entry = *item.entry;
+                const auto target = std::min(wanted(entry) + extra, entry.levels - 1);
+
+                if (entry.texture == 0) total += chain_bytes(entry, target);
+                else if (target < entry.top) total += chain_bytes(entry, target) - entry.bytes;
+            }
+
+            return total;
+        };
+
+        evict(needed(0), drawn);
+
+        // One downscale for the whole batch: the fewest halvings that fit everything into what is left.
+        const auto available = budget > resident ? budget - resident : 0;
+
+        std::uint32_t extra = 0;
+
+        while (extra < MAX_DOWNSCALE && needed(extra) > available) ++extra;
+
+        std::erase_if(batch, [&](Load& item)
+        {
+            const auto& entry = *item.entry;
+
+            item.target = std::min(wanted(entry) + extra, entry.levels - 1);
+
+            return entry.texture != 0 && item.target >= entry.top;
+        });
+
+        {
+            PROFILE_SCOPE("texture mip chain");
+
+            parallel(batch.size(), [&](size_t i)
+            {
+                auto& item = batch[i];
+
+                if (item.image.data.empty()) item.image = decode(*item.entry);
+
+                item.chain = chain(std::move(item.image), item.target);
+            });
+        }
+
+        for (auto& item : batch)
+        {
+            auto& entry = *item.entry;
+            const auto bytes = chain_bytes(entry, item.target);
+            const auto freed = entry.texture != 0 ? entry.bytes : 0;
+
+            // Still too big even at the smallest size, tried again the next frame it is drawn.
+            if (resident - freed + bytes > budget) continue;
+
+            if (entry.texture != 0) ++stats.refined;
+            else ++stats.loaded;
+
+            if (item.target > wanted(entry)) ++stats.downscaled;
+
+            allocate(entry, item.target, std::move(item.chain));
+        }
+    }
+
+    // Moves a texture that is finer than the last frame needed to a smaller one, the levels are all resident.
+    auto coarsen(Entry& entry) -> void
+    {
+        allocate(entry, wanted(entry), {});
+
+        ++stats.coarsened;
+    }
+
+    // Replaces the texture of `entry` with one whose level 0 is image level `top`. Levels the old texture holds
+    // are copied over, `chain` has the images from `top` down for the rest.
+    auto allocate(Entry& entry, std::uint32_t top, std::vector<Material::Image> chain) -> void
+    {
+        PROFILE_SCOPE("texture allocate");
+
+        const auto count = entry.levels - top;
+        const auto texture = Material::create(level_width(entry, top), level_height(entry, top), entry.layout, count);
+
+        auto base = count;
+
+        if (entry.texture != 0)
+        {
+            const auto first = std::max(entry.top + entry.base, top);
+
+            for (auto level = first; level < entry.levels; ++level)
+            {
+                glCopyImageSubData(
+                    entry.texture, GL_TEXTURE_2D, level - entry.top, 0, 0, 0,
+                    texture, GL_TEXTURE_2D, level - top, 0, 0, 0,
+                    level_width(entry, level), level_height(entry, level), 1
+                );
+            }
+
+            base = first - top;
+
+            Material::destroy(entry.texture);
+
+            resident -= entry.bytes;
+        }
+
+        chain.resize(std::min<size_t>(chain.size(), base));
+
+        entry.texture = texture;
+        entry.top = top;
+        entry.base = base;
+        entry.bytes = chain_bytes(entry, top);
+        entry.pending = std::move(chain);
+
+        resident += entry.bytes;
+
+        show(entry);
+    }
+
+    // Uploads pending levels coarsest first, within the upload budget except for the first level of a texture.
+    auto stream() -> void
+    {
+        PROFILE_SCOPE("texture stream");
+
+        size_t uploaded = 0;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (auto& entry : entries)
+        {
+            while (!entry.pending.empty() && (uploaded < upload_budget || entry.material->texture == 0))
+            {
+                const auto& image = entry.pending.back();
+
+                glTextureSubImage2D(entry.texture, entry.base - 1, 0, 0, image.width, image.height, Material::formats(entry.layout).second, GL_UNSIGNED_BYTE, image.data.data());
+
+                uploaded += image.data.size();
+
+                entry.pending.pop_back();
+                --entry.base;
+
+                ++stats.streamed;
+
+                show(entry);
+            }
+        }
+    }
+
+    // Sampling starts at the finest uploaded level. TEXTURE_MIN_LOD is relative to the base level, so it stays 0.
+    static auto show(Entry& entry) -> void
+    {
+        if (entry.base >= entry.levels - entry.top)
+        {
+            entry.material->texture = 0;
+
+            return;
+        }
+
+        glTextureParameteri(entry.texture, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.base));
+
+        entry.material->texture = entry.texture;
+    }
+
+    // Frees at least `needed` bytes if it can, least recently drawn first, never what the last frame drew.
+    auto evict(size_t needed, std::uint64_t drawn) -> void
+    {
+        if (resident + needed <= budget) return;
+
+        std::vector<Entry*> candidates;
+
+        for (auto& entry : entries)
+        {
+            if (entry.texture != 0 && entry.used != drawn) candidates.push_back(&entry);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) { return a->used < b->used; });
+
+        for (const auto entry : candidates)
+        {
+            if (resident + needed <= budget) break;
+
+            Material::destroy(entry->texture);
+
+            entry->material->texture = 0;
+            entry->pending.clear();
+            resident -= entry->bytes;
+            entry->bytes = 0;
+
+            ++stats.evicted;
+        }
+    }
+
+    // Mip level the feedback of the last frame asks for: the one with about a texel per pixel. Without feedback,
+    // or with the camera inside a mesh, the full size.
+    static auto wanted(const Entry& entry) -> std::uint32_t
+    {
+        if (!(entry.feedback > 0.0f) || std::isinf(entry.feedback) || entry.levels == 0) return 0;
+
+        const auto texels = static_cast<float>(std::max(entry.width, entry.height)) / entry.feedback;
+
+        if (!(texels >= 2.0f)) return 0;
+
+        return std::min(static_cast<std::uint32_t>(std::log2(texels)), entry.levels - 1);
+    }
+
+    static auto level_width(const Entry& entry, std::uint32_t level) -> GLsizei
+    {
+        return static_cast<GLsizei>(std::max<std::uint32_t>(entry.width >> level, 1));
+    }
+    static auto level_height(const Entry& entry, std::uint32_t level) -> GLsizei
+    {
+        return static_cast<GLsizei>(std::max<std::uint32_t>(entry.height >> level, 1));
+    }
+    // Bytes of image levels `top` down to 1 x 1.
+    static auto chain_bytes(const Entry& entry, std::uint32_t top) -> size_t
+    {
+        size_t total = 0;
+
+        for (auto level = top; level < entry.levels; ++level)
+        {
+            total += static_cast<size_t>(level_width(entry, level)) * static_cast<size_t>(level_height(entry, level)) * entry.layout.channels;
+        }
+
+        return total;
+    }
+
+    static auto decode(const Entry& entry) -> Material::Image
+    {
+        if (entry.encoded.empty()) return Material::decode(AssetFile::open(entry.path));
+
+        return Material::decode(entry.encoded.data(), entry.encoded.size());
+    }
+
+    // The full size image halved down to level `top`, then every level from there to 1 x 1.
+    static auto chain(Material::Image image, std::uint32_t top) -> std::vector<Material::Image>
+    {
+        for (std::uint32_t level = 0; level < top; ++level) image = half(image);
+
+        std::vector<Material::Image> chain;
+
+        chain.push_back(std::move(image));
+
+        while (chain.back().width > 1 || chain.back().height > 1) chain.push_back(half(chain.back()));
+
+        return chain;
+    }
+
+    static auto half(const Material::Image& image) -> Material::Image
+    {
+        auto result = Material::Image{ std::max<std::uint32_t>(image.width / 2, 1), std::max<std::uint32_t>(image.height / 2, 1), image.layout };
+
+        result.data.resize(static_cast<size_t>(result.width) * result.height * image.layout.channels);
+
+        pixels::downscale_half(image.data.data(), image.width, image.height, image.layout.channels, result.data.data());
+
+        return result;
+    }
+
+    template <typename Function>
+    auto parallel(size_t count, const Function& function) -> void
+    {
+        if (!jobs)
+        {
+            for (size_t i = 0; i < count; ++i) function(i);
+
+            return;
+        }
+
+        jobs->parallel_for(0, count, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) function(i);
+        }, 1);
+    }
+
+    JobSystem*         jobs;
+    // Stable addresses, loads keep pointers to entries.
+    std::deque<Entry>  entries;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <profiler.hpp>
+
+// Worker threads that resume coroutines: `co_await pool.schedule()` continues the coroutine on one of them.
+// Destroy it only once no task can schedule onto it any more, queued coroutines are not resumed after that.
+struct ThreadPool
+{
+    // 0 uses every core.
+    explicit ThreadPool(size_t threads = 0)
+    {
+        threads = std::max<size_t>(1, threads == 0 ? std::thread::hardware_concurrency() : threads);
+
+        for (size_t i = 0; i < threads; ++i)
+        {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ~ThreadPool()
+    {
+        {
+            auto lock = std::lock_guard(mutex);
+
+            stopping = true;
+        }
+
+        available.notify_all();
+
+        for (auto& worker : workers) worker.join();
+    }
+
+    auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+    auto schedule()
+    {
+        struct Awaiter
+        {
+            auto await_ready() const noexcept -> bool
+            {
+                return false;
+            }
+
+            auto await_suspend(std::coroutine_handle<> handle) -> void
+            {
+                pool.push(handle);
+            }
+
+            auto await_resume() const noexcept -> void
+            {
+            }
+
+            ThreadPool& pool;
+        };
+
+        return Awaiter{ *this };
+    }
+
+    auto threads() const -> size_t
+    {
+        return workers.size();
+    }
+
+private:
+    auto push(std::coroutine_handle<> handle) -> void
+    {
+        {
+            auto lock = std::lock_guard(mutex);
+
+            queue.push_back(handle);
+        }
+
+        available.notify_one();
+    }
+
+    auto work() -> void
+    {
+        PROFILE_THREAD("pool");
+
+        for (;;)
+        {
+            std::coroutine_handle<> handle;
+
+            {
+                auto lock = std::unique_lock(mutex);
+
+                available.wait(lock, [this] { return stopping || !queue.empty(); });
+
+                if (stopping) return;
+
+                handle = queue.front();
+                queue.pop_front();
+            }
+
+            handle.resume();
+        }
+    }
+
+    std::vector<std::thread>            workers;
+    std::mutex                          mutex;
+    std::condition_variable             available;
+    std::deque<std::coroutine_handle<>> queue;
+    bool                                stopping = false;
+};
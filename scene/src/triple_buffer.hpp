@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer hand-off of the latest value without locks.
+// The producer fills write() and publish()es it; the consumer calls update() and reads read() until the next update.
+// Neither side ever waits: a slow consumer just skips the values it was too late for.
+template <typename T>
+struct TripleBuffer
+{
+    auto write() -> T&
+    {
+        return slots[back];
+    }
+
+    auto publish() -> void
+    {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Returns whether a newer value was taken.
+    auto update() -> bool
+    {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+
+        return true;
+    }
+
+    auto read() const -> const T&
+    {
+        return slots[front];
+    }
+
+private:
+    static constexpr std::uint8_t INDEX = 0x3;
+    static constexpr std::uint8_t FRESH = 0x4;
+
+    std::array<T, 3>          slots = {};
+    std::atomic<std::uint8_t> middle = 1;
+    std::uint8_t              front  = 0;
+    std::uint8_t              back   = 2;
+};
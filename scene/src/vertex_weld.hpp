@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <job_system.hpp>
+#include <profiler.hpp>
+
+// Merges vertices whose position and UV fall on the same point of an `epsilon` grid and remaps the indices,
+// replacing assimp's single-threaded aiProcess_JoinIdenticalVertices. Every phase is a parallel_for on
+// `jobs`: quantize, insert into a lock-free open addressing table that keeps the lowest index per key,
+// look up each vertex's representative, compact by a blocked prefix sum, remap. Survivors keep their
+// order, so the output does not depend on the thread count.
+//
+// An epsilon of 0 merges bit-identical vertices only (+0 and -0 count as equal). With a positive epsilon
+// two vertices closer than epsilon can still land in neighbouring cells and stay apart.
+struct VertexWeld
+{
+    // NUTSHELL_WELD: "off" keeps the vertices as imported, a number sets the epsilon, exact merging otherwise.
+    static auto configured() -> std::optional<float>
+    {
+        static const auto epsilon = []() -> std::optional<float>
+        {
+            const auto value = std::getenv("NUTSHELL_WELD");
+
+            if (!value || std::string(value).empty()) return 0.0f;
+            if (std::string(value) == "off") return std::nullopt;
+
+            const auto epsilon = std::stof(value);
+
+            if (!(epsilon >= 0.0f)) throw std::runtime_error("NUTSHELL_WELD must be off or a non-negative epsilon.");
+
+            return epsilon;
+        }();
+
+        return epsilon;
+    }
+
+    // Any vertex type with glm `position` and `mapping` members.
+    template <typename Vertex>
+    static auto weld(std::vector<Vertex>& vertices, std::vector<std::uint32_t>& indices, float epsilon = 0.0f, JobSystem* jobs = nullptr) -> void
+    {
+        PROFILE_SCOPE("VertexWeld::weld");
+
+        const auto count = vertices.size();
+
+        if (count < 2) return;
+        if (count >= EMPTY) throw std::runtime_error("Too many vertices to weld.");
+
+        const auto for_range = [&](size_t end, auto&& body)
+        {
+            if (jobs) jobs->parallel_for(0, end, body, GRAIN);
+            else body(0, end);
+        };
+
+        const auto scale = epsilon > 0.0f ? 1.0f / epsilon : 0.0f;
+
+        std::vector<Key> keys(count);
+
+        for_range(count, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) keys[i] = key(vertices[i], scale);
+        });
+
+        const auto capacity = std::bit_ceil(count * 2);
+        const auto mask = capacity - 1;
+        const auto table = std::make_unique<std::atomic<std::uint32_t>[]>(capacity);
+
+        for_range(capacity, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) table[i].store(EMPTY, std::memory_order_relaxed);
+        });
+
+        // Slots hold the lowest vertex index seen for their key, raced down with compare-exchange.
+        for_range(count, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                const auto index = static_cast<std::uint32_t>(i);
+
+                for (auto slot = keys[i].hash & mask;;)
+                {
+                    auto current = table[slot].load(std::memory_order_relaxed);
+
+                    if (current == EMPTY)
+                    {
+                        if (table[slot].compare_exchange_weak(current, index, std::memory_order_relaxed)) break;
+
+                        continue;
+                    }
+
+                    if (keys[current] == keys[i])
+                    {
+                        while (current > index && !table[slot].compare_exchange_weak(current, index, std::memory_order_relaxed))
+                        {
+                        }
+
+                        break;
+                    }
+
+                    slot = (slot + 1) & mask;
+                }
+            }
+        });
+
+        // Representative of every vertex: the first vertex with its key.
+        std::vector<std::uint32_t> representatives(count);
+
+        for_range(count, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                auto slot = keys[i].hash & mask;
+
+                while (!(keys[table[slot].load(std::memory_order_relaxed)] == keys[i])) slot = (slot + 1) & mask;
+
+                representatives[i] = table[slot].load(std::memory_order_relaxed);
+            }
+        });
+
+        // Survivors per block, then each block numbers its survivors from the running total.
+        const auto blocks = (count + GRAIN - 1) / GRAIN;
+
+        std::vector<std::uint32_t> offsets(blocks + 1);
+
+        for_range(blocks, [&](size_t begin, size_t end)
+        {
+            for (auto block = begin; block < end; ++block)
+            {
+                std::uint32_t survivors = 0;
+
+                for (auto i = block * GRAIN; i < std::min(count, (block + 1) * GRAIN); ++i) survivors += representatives[i] == i;
+
+                offsets[block + 1] = survivors;
+            }
+        });
+
+        for (size_t block = 0; block < blocks; ++block) offsets[block + 1] += offsets[block];
+
+        const auto welded_count = offsets[blocks];
+
+        if (welded_count == count) return;
+
+        std::vector<std::uint32_t> remap(count);
+        std::vector<Vertex> welded(welded_count);
+
+        for_range(blocks, [&](size_t begin, size_t end)
+        {
+            for (auto block = begin; block < end; ++block)
+            {
+                auto next = offsets[block];
+
+                for (auto i = block * GRAIN; i < std::min(count, (block + 1) * GRAIN); ++i)
+                {
+                    if (representatives[i] != i) continue;
+
+                    remap[i] = next;
+                    welded[next++] = vertices[i];
+                }
+            }
+        });
+
+        // Duplicates take their representative's new index, set above since representatives are survivors.
+        for_range(count, [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                if (representatives[i] != i) remap[i] = remap[representatives[i]];
+            }
+        });
+
+        for_range(indices.size(), [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i) indices[i] = remap[indices[i]];
+        });
+
+        vertices = std::move(welded);
+    }
+
+private:
+    struct Key
+    {
+        std::uint32_t values[5];
+        std::uint32_t hash;
+
+        auto operator==(const Key& other) const -> bool
+        {
+            return std::equal(std::begin(values), std::end(values), std::begin(other.values));
+        }
+    };
+
+    static constexpr std::uint32_t EMPTY = 0xffffffffu;
+    static constexpr size_t        GRAIN = 16384;
+
+    // Grid cell with `scale` = 1 / epsilon, the float bits with a scale of 0.
+    static auto quantize(float value, float scale) -> std::uint32_t
+    {
+        if (scale == 0.0f) return value == 0.0f ? 0u : std::bit_cast<std::uint32_t>(value);
+
+        const auto cell = std::floor(static_cast<double>(value) * scale + 0.5);
+
+        return static_cast<std::uint32_t>(static_cast<std::int32_t>(std::clamp(cell, -2147483648.0, 2147483647.0)));
+    }
+
+    template <typename Vertex>
+    static auto key(const Vertex& vertex, float scale) -> Key
+    {
+        auto key = Key{ {
+            quantize(vertex.position.x, scale),
+            quantize(vertex.position.y, scale),
+            quantize(vertex.position.z, scale),
+            quantize(vertex.mapping.x, scale),
+            quantize(vertex.mapping.y, scale),
+        }, 0 };
+
+        // 64-bit multiply-xorshift over the five words, folded to 32 bits.
+        std::uint64_t hash = 0x9e3779b97f4a7c15ull;
+
+        for (const auto value : key.values)
+        {
+            hash = (hash ^ value) * 0xff51afd7ed558ccdull;
+            hash ^= hash >> 32;
+        }
+
+        key.hash = static_cast<std::uint32_t>(hash);
+
+        return key;
+    }
+};
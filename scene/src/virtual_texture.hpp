@@ -0,0 +1,1113 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <assimp/scene.h>
+#include <asset_file.hpp>
+#include <draw_list.hpp>
+#include <gltf_scene.hpp>
+#include <job_system.hpp>
+#include <pixel_convert.hpp>
+#include <profiler.hpp>
+#include <scene.hpp>
+
+// Tiled cache file of virtual textures: every image resampled to whole PAGE x PAGE pages of RGBA8, with its mip
+// levels down to a single page, each level cut into pages stored row by row. Pages are read straight from the
+// mapped file, so only the ones touched take memory.
+//
+//     header   "NSVT", version, PAGE, texture count, key of the sources, offset of the texture table
+//     pages    PAGE * PAGE * 4 bytes each, from DATA_OFFSET, texture by texture, level 0 first
+//     table    pages_x, pages_y, levels, first page of every texture
+//
+// Levels halve the page count of each side down to one, a side already at one page stays there.
+struct VirtualTextureCache
+{
+    static constexpr std::uint32_t VERSION     = 2;
+    static constexpr std::uint32_t PAGE        = 128;
+    static constexpr size_t        PAGE_BYTES  = static_cast<size_t>(PAGE) * PAGE * 4;
+    static constexpr size_t        DATA_OFFSET = 4096;
+    // Pages per side of level 0, the feedback pass packs page coordinates into 8 bits.
+    static constexpr std::uint32_t MAX_PAGES   = 256;
+
+    struct Texture
+    {
+        std::uint32_t pages_x = 0;
+        std::uint32_t pages_y = 0;
+        std::uint32_t levels  = 0;
+        std::uint64_t first   = 0;
+
+        auto level_pages(std::uint32_t level) const -> std::pair<std::uint32_t, std::uint32_t>
+        {
+            return { std::max<std::uint32_t>(pages_x >> level, 1), std::max<std::uint32_t>(pages_y >> level, 1) };
+        }
+        // Page of level + 1 covering the start of page x, y: side lengths need not halve evenly, as when a side is
+        // clamped to one page or has an odd page count. Matches virtualPage() in the shader.
+        auto parent(std::uint32_t level, std::uint32_t x, std::uint32_t y) const -> std::pair<std::uint32_t, std::uint32_t>
+        {
+            const auto [width, height] = level_pages(level);
+            const auto [above_width, above_height] = level_pages(level + 1);
+
+            return { static_cast<std::uint32_t>(static_cast<std::uint64_t>(x) * above_width / width), static_cast<std::uint32_t>(static_cast<std::uint64_t>(y) * above_height / height) };
+        }
+        // Index of a page in the file.
+        auto page(std::uint32_t level, std::uint32_t x, std::uint32_t y) const -> std::uint64_t
+        {
+            auto index = first;
+
+            for (std::uint32_t above = 0; above < level; ++above)
+            {
+                const auto [width, height] = level_pages(above);
+
+                index += static_cast<std::uint64_t>(width) * height;
+            }
+
+            return index + static_cast<std::uint64_t>(y) * level_pages(level).first + x;
+        }
+    };
+
+    // Identifies the sources without decoding them: every byte of embedded images, paths, file sizes and
+    // modification times of the others.
+    static auto key(const std::vector<Material::TextureSource>& sources) -> std::uint64_t
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+
+        const auto mix = [&](const void* data, size_t size)
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ static_cast<const std::uint8_t*>(data)[i]) * 0x100000001b3ull;
+            }
+        };
+        const auto mix_value = [&](std::uint64_t value)
+        {
+            mix(&value, sizeof(value));
+        };
+
+        mix_value(sources.size());
+
+        for (const auto& source : sources)
+        {
+            if (source.data)
+            {
+                mix_value(source.size);
+                mix(source.data, source.size);
+            }
+            else
+            {
+                mix(source.path.data(), source.path.size());
+
+                auto error = std::error_code();
+                const auto size = std::filesystem::file_size(source.path, error);
+
+                mix_value(error ? 0 : size);
+
+                const auto time = std::filesystem::last_write_time(source.path, error);
+
+                mix_value(error ? 0 : static_cast<std::uint64_t>(time.time_since_epoch().count()));
+            }
+        }
+
+        return hash;
+    }
+
+    // The cache at `path` when it was built from sources with `key`, nothing when it is missing or stale.
+    static auto open(const std::string& path, std::uint64_t key) -> std::optional<VirtualTextureCache>
+    {
+        if (!std::filesystem::exists(path)) return std::nullopt;
+
+        auto cache = VirtualTextureCache();
+
+        cache.file = AssetFile::open(path, AssetFile::Mode::MMAP);
+
+        const auto data = cache.file.data();
+        const auto size = cache.file.size();
+
+        const auto u32 = [&](size_t offset)
+        {
+            std::uint32_t value = 0;
+
+            for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(data[offset + i]) << (8 * i);
+
+            return value;
+        };
+        const auto u64 = [&](size_t offset)
+        {
+            return static_cast<std::uint64_t>(u32(offset)) | static_cast<std::uint64_t>(u32(offset + 4)) << 32;
+        };
+
+        if (size < DATA_OFFSET || std::memcmp(data, "NSVT", 4) != 0) return std::nullopt;
+        if (u32(4) != VERSION || u32(8) != PAGE || u64(16) != key) return std::nullopt;
+
+        const auto count = u32(12);
+        const auto table = u64(24);
+
+        if (table < DATA_OFFSET || table > size || (size - table) / 24 < count) return std::nullopt;
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            const auto offset = table + 24 * static_cast<size_t>(i);
+            const auto texture = Texture{ u32(offset), u32(offset + 4), u32(offset + 8), u64(offset + 16) };
+
+            // The last page of the texture has to lie before the table.
+            if (texture.levels == 0 || texture.pages_x == 0 || texture.pages_y == 0) return std::nullopt;
+            if (texture.page(texture.levels - 1, 0, 0) >= (table - DATA_OFFSET) / PAGE_BYTES) return std::nullopt;
+
+            cache.textures.push_back(texture);
+        }
+
+        return cache;
+    }
+
+    // Decodes every source and writes its pages to `path`. Images decode in groups of one per thread, so memory
+    // stays at a few decoded images however large the scene is.
+    static auto build(const std::string& path, const std::vector<Material::TextureSource>& sources, std::uint64_t key, JobSystem* jobs = nullptr) -> void
+    {
+        PROFILE_SCOPE("VirtualTextureCache::build");
+
+        std::ofstream stream(path, std::ios::binary);
+
+        if (!stream) throw std::runtime_error("Failed to open virtual texture cache " + path + ".");
+
+        const auto u8 = [&](std::uint8_t value)
+        {
+            stream.put(static_cast<char>(value));
+        };
+        const auto u32 = [&](std::uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i) u8(static_cast<std::uint8_t>(value >> (8 * i)));
+        };
+        const auto u64 = [&](std::uint64_t value)
+        {
+            u32(static_cast<std::uint32_t>(value));
+            u32(static_cast<std::uint32_t>(value >> 32));
+        };
+
+        stream.seekp(DATA_OFFSET);
+
+        std::vector<Texture> textures;
+        std::uint64_t pages = 0;
+
+        const auto group = jobs ? std::max<size_t>(jobs->threads(), 1) : 1;
+
+        for (size_t begin = 0; begin < sources.size(); begin += group)
+        {
+            const auto end = std::min(begin + group, sources.size());
+
+            std::vector<std::vector<Material::Image>> levels(end - begin);
+
+            const auto cut = [&](size_t first, size_t last)
+            {
+                for (auto i = first; i < last; ++i) levels[i - begin] = VirtualTextureCache::levels(sources[i]);
+            };
+
+            if (jobs) jobs->parallel_for(begin, end, cut, 1);
+            else cut(begin, end);
+
+            for (const auto& chain : levels)
+            {
+                textures.push_back({ chain.front().width / PAGE, chain.front().height / PAGE, static_cast<std::uint32_t>(chain.size()), pages });
+
+                for (const auto& image : chain)
+                {
+                    for (std::uint32_t y = 0; y < image.height / PAGE; ++y)
+                    {
+                        for (std::uint32_t x = 0; x < image.width / PAGE; ++x)
+                        {
+                            for (std::uint32_t row = 0; row < PAGE; ++row)
+                            {
+                                const auto offset = ((static_cast<size_t>(y) * PAGE + row) * image.width + static_cast<size_t>(x) * PAGE) * 4;
+
+                                stream.write(reinterpret_cast<const char*>(image.data.data() + offset), PAGE * 4);
+                            }
+
+                            ++pages;
+                        }
+                    }
+                }
+            }
+        }
+
+        const auto table = DATA_OFFSET + pages * PAGE_BYTES;
+
+        for (const auto& texture : textures)
+        {
+            u32(texture.pages_x);
+            u32(texture.pages_y);
+            u32(texture.levels);
+            u32(0);
+            u64(texture.first);
+        }
+
+        stream.seekp(0);
+
+        u8('N'); u8('S'); u8('V'); u8('T');
+        u32(VERSION);
+        u32(PAGE);
+        u32(static_cast<std::uint32_t>(textures.size()));
+        u64(key);
+        u64(table);
+
+        if (!stream) throw std::runtime_error("Failed to write virtual texture cache " + path + ".");
+    }
+
+    auto page(std::uint64_t index) const -> const std::uint8_t*
+    {
+        return file.data() + DATA_OFFSET + index * PAGE_BYTES;
+    }
+
+    std::vector<Texture> textures;
+    AssetFile            file;
+
+private:
+    // Every level of a source, each resampled to the whole pages of its level.
+    static auto levels(const Material::TextureSource& source) -> std::vector<Material::Image>
+    {
+        auto image = Material::Image();
+
+        if (source.data)
+        {
+            image = Material::decode_rgba(source.data, source.size);
+        }
+        else
+        {
+            const auto file = AssetFile::open(source.path);
+
+            image = Material::decode_rgba(file.data(), file.size());
+        }
+
+        // Halved down to MAX_PAGES first, so resize() below never drops more than a page of texels.
+        while (image.width > MAX_PAGES * PAGE || image.height > MAX_PAGES * PAGE)
+        {
+            auto half = Material::Image{ std::max<std::uint32_t>(image.width / 2, 1), std::max<std::uint32_t>(image.height / 2, 1) };
+
+            half.data.resize(static_cast<size_t>(half.width) * half.height * 4);
+
+            pixels::downscale_half(image.data.data(), image.width, image.height, 4, half.data.data());
+
+            image = std::move(half);
+        }
+
+        const auto pages = [](std::uint32_t size) { return std::clamp<std::uint32_t>((size + PAGE - 1) / PAGE, 1, MAX_PAGES); };
+        const auto texture = Texture{ pages(image.width), pages(image.height), 0, 0 };
+        const auto levels = static_cast<std::uint32_t>(std::bit_width(std::max(texture.pages_x, texture.pages_y)));
+
+        std::vector<Material::Image> chain;
+
+        chain.push_back(resize(image, texture.pages_x * PAGE, texture.pages_y * PAGE));
+
+        for (std::uint32_t level = 1; level < levels; ++level)
+        {
+            const auto& last = chain.back();
+            const auto [width, height] = texture.level_pages(level);
+
+            auto half = Material::Image{ last.width / 2, last.height / 2 };
+
+            half.data.resize(static_cast<size_t>(half.width) * half.height * 4);
+
+            pixels::downscale_half(last.data.data(), last.width, last.height, 4, half.data.data());
+
+            // A side already down to one page, or not halving evenly, is stretched to the pages of the level.
+            chain.push_back(resize(half, width * PAGE, height * PAGE));
+        }
+
+        return chain;
+    }
+
+    // Nearest neighbour, images only change by less than a page here.
+    static auto resize(Material::Image& image, std::uint32_t width, std::uint32_t height) -> Material::Image
+    {
+        if (image.width == width && image.height == height) return std::move(image);
+
+        auto result = Material::Image{ width, height };
+
+        result.data.resize(static_cast<size_t>(width) * height * 4);
+
+        for (std::uint32_t y = 0; y < height; ++y)
+        {
+            const auto source = static_cast<size_t>(y) * image.height / height;
+
+            for (std::uint32_t x = 0; x < width; ++x)
+            {
+                const auto column = static_cast<size_t>(x) * image.width / width;
+
+                std::memcpy(&result.data[(static_cast<size_t>(y) * width + x) * 4], &image.data[(source * image.width + column) * 4], 4);
+            }
+        }
+
+        return result;
+    }
+};
+
+// Software virtual texturing over a VirtualTextureCache, without sparse textures. Resident pages live in one
+// RGBA8 atlas of `atlas_pages` x `atlas_pages` pages; every material's texture is its indirection texture, one
+// RGBA16UI texel per virtual page and level holding the atlas page to read, the level that page has (the
+// closest resident one) and the texture index.
+//
+// Each frame update() renders the draw list at 1 / FEEDBACK_SCALE resolution with a shader that writes the page
+// every pixel needs, and reads it back through a ring of pixel buffers. Readbacks are consumed once their fence
+// has passed, frames later, so the GPU never waits for the CPU. Requested pages and their coarser ancestors are
+// copied from the mapped cache on the jobs and uploaded, coarsest first, `pages_per_frame` at a time, evicting the
+// pages the last feedback did not ask for, least recently asked first. The coarsest page of every texture stays
+// resident while they fit in half the atlas.
+//
+//     auto virtual_texture = VirtualTexture("scene.vtc", &jobs);
+//     const auto root = Node::from(scene, virtual_texture.materials(scene, directory), &jobs);
+//     // every frame, on the GL thread, after draw_list.build()
+//     virtual_texture.update(draw_list, width, height);
+//     glBindTextureUnit(VirtualTexture::ATLAS_UNIT, virtual_texture.atlas);
+//
+// Shaders sample with virtualTexture() from glsl(), with the indirection texture bound to unit 0 by DrawList.
+struct VirtualTexture
+{
+    static constexpr std::uint32_t PAGE            = VirtualTextureCache::PAGE;
+    static constexpr GLuint        ATLAS_UNIT      = 1;
+    static constexpr std::uint32_t ATLAS_PAGES     = 32;
+    static constexpr std::uint32_t FEEDBACK_SCALE  = 8;
+    // Readbacks in flight, the oldest one is dropped when all are.
+    static constexpr size_t        READBACKS       = 3;
+    static constexpr size_t        PAGES_PER_FRAME = 32;
+    // Indirection texel level of a page with nothing resident for it.
+    static constexpr std::uint16_t NONE            = 0xFFFF;
+
+    struct Stats
+    {
+        size_t resident  = 0;
+        // Pages the newest feedback asked for that are not resident.
+        size_t requested = 0;
+        size_t loaded    = 0;
+        size_t evicted   = 0;
+        size_t readbacks = 0;
+        double update_ms = 0.0;
+    };
+
+    // GLSL for the fragment shaders: virtualTexture(mapping) samples the material's virtual texture, the other
+    // functions are shared with the feedback pass.
+    static auto glsl() -> std::string
+    {
+        return R"(
+layout (binding = 0) uniform usampler2D virtualIndirection;
+layout (binding = )" + std::to_string(ATLAS_UNIT) + R"() uniform sampler2D virtualAtlas;
+
+const int VIRTUAL_PAGE = )" + std::to_string(PAGE) + R"(;
+
+// Level with about one texel per pixel, from the derivatives of the unwrapped texel position.
+int virtualLevel(vec2 mapping, float bias) {
+    vec2 texels = mapping * vec2(textureSize(virtualIndirection, 0) * VIRTUAL_PAGE);
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + bias;
+
+    return clamp(int(floor(lod)), 0, textureQueryLevels(virtualIndirection) - 1);
+}
+
+ivec2 virtualPage(vec2 mapping, int level) {
+    ivec2 pages = textureSize(virtualIndirection, level);
+
+    return min(ivec2(fract(mapping) * vec2(pages)), pages - 1);
+}
+
+vec4 virtualTexture(vec2 mapping) {
+    if (textureQueryLevels(virtualIndirection) == 0) return vec4(0.0, 0.0, 0.0, 1.0);
+
+    int level = virtualLevel(mapping, 0.0);
+    uvec4 entry = texelFetch(virtualIndirection, virtualPage(mapping, level), level);
+
+    if (entry.z == 0xFFFFu) return vec4(0.5, 0.5, 0.5, 1.0);
+
+    // Position inside the page of the level that is resident.
+    vec2 resident = fract(mapping) * vec2(textureSize(virtualIndirection, int(entry.z)));
+    ivec2 inside = min(ivec2(fract(resident) * VIRTUAL_PAGE), ivec2(VIRTUAL_PAGE - 1));
+
+    return texelFetch(virtualAtlas, ivec2(entry.xy) * VIRTUAL_PAGE + inside, 0);
+}
+)";
+    }
+
+    VirtualTexture(const std::string& cache_path, JobSystem* jobs = nullptr, std::uint32_t atlas_pages = ATLAS_PAGES):
+        cache_path(cache_path),
+        jobs(jobs)
+    {
+        GLint limit = 0;
+
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &limit);
+
+        atlas_side = std::clamp<std::uint32_t>(atlas_pages, 1, static_cast<std::uint32_t>(limit) / PAGE);
+        slots.resize(static_cast<size_t>(atlas_side) * atlas_side);
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &atlas);
+        glTextureStorage2D(atlas, 1, GL_RGBA8, atlas_side * PAGE, atlas_side * PAGE);
+        glTextureParameteri(atlas, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(atlas, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        program = link_feedback_program();
+
+        glProgramUniform1f(program, 1, -std::log2(static_cast<float>(FEEDBACK_SCALE)));
+
+        for (auto& readback : readbacks)
+        {
+            glCreateBuffers(1, &readback.buffer);
+        }
+    }
+    VirtualTexture(const VirtualTexture&) = delete;
+    ~VirtualTexture()
+    {
+        for (auto& texture : textures)
+        {
+            glDeleteTextures(1, &texture.indirection);
+
+            if (texture.material) texture.material->texture = 0;
+        }
+
+        for (auto& readback : readbacks)
+        {
+            if (readback.fence) glDeleteSync(readback.fence);
+
+            glDeleteBuffers(1, &readback.buffer);
+        }
+
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &requests_texture);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteProgram(program);
+        glDeleteTextures(1, &atlas);
+    }
+
+    auto operator=(const VirtualTexture&) -> VirtualTexture& = delete;
+
+    // Materials of an assimp scene for Node::from, the cache is built first when it is missing or stale.
+    // `directory` holds the scene file.
+    auto materials(const aiScene* scene, const std::filesystem::path& directory) -> std::vector<std::shared_ptr<Material>>
+    {
+        std::vector<Material::TextureSource> sources;
+        std::vector<size_t> indices;
+
+        for (size_t i = 0; i < scene->mNumMaterials; ++i)
+        {
+            auto source = Material::texture_source(scene, i, directory);
+
+            indices.push_back(source.empty() ? NO_TEXTURE : sources.size());
+
+            if (!source.empty()) sources.push_back(std::move(source));
+        }
+
+        return materials(sources, indices);
+    }
+    // Materials of a native glTF scene, one virtual texture per image however many materials use it.
+    auto materials(const GltfScene& scene) -> std::vector<std::shared_ptr<Material>>
+    {
+        std::vector<Material::TextureSource> sources;
+        std::vector<size_t> images(scene.images.size(), NO_TEXTURE);
+        std::vector<size_t> indices;
+
+        for (const auto& material : scene.materials)
+        {
+            if (material.base_color == GltfScene::NONE)
+            {
+                indices.push_back(NO_TEXTURE);
+
+                continue;
+            }
+
+            auto& index = images[material.base_color];
+
+            if (index == NO_TEXTURE)
+            {
+                const auto& image = scene.images[material.base_color];
+
+                index = sources.size();
+                sources.push_back({ image.data, image.size, image.path });
+            }
+
+            indices.push_back(index);
+        }
+
+        return materials(sources, indices);
+    }
+
+    // Once per frame on the GL thread, after `draw_list` is built for the frame: takes in finished readbacks,
+    // streams pages and renders the feedback of this frame. Leaves the draw framebuffer and viewport as they were.
+    auto update(const DrawList& draw_list, GLsizei width, GLsizei height) -> void
+    {
+        PROFILE_SCOPE("VirtualTexture::update");
+
+        const auto started = std::chrono::steady_clock::now();
+
+        ++frame;
+
+        stats = {};
+
+        collect();
+        stream();
+        refresh();
+        feedback(draw_list, width, height);
+
+        for (const auto& slot : slots)
+        {
+            if (slot.texture != EMPTY) ++stats.resident;
+        }
+
+        for (const auto& request : requests)
+        {
+            const auto& texture = textures[request.texture];
+
+            if (texture.slots[texture.pages.page(request.level, request.x, request.y) - texture.pages.first] == EMPTY) ++stats.requested;
+        }
+        stats.update_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+        loads_total += stats.loaded;
+        evictions_total += stats.evicted;
+        readbacks_total += stats.readbacks;
+        update_ms_max = std::max(update_ms_max, stats.update_ms);
+    }
+
+    auto atlas_bytes() const -> size_t
+    {
+        return slots.size() * VirtualTextureCache::PAGE_BYTES;
+    }
+    auto cache_bytes() const -> size_t
+    {
+        return cache ? cache->file.size() : 0;
+    }
+
+    GLuint        atlas = 0;
+    // Of the last update().
+    Stats         stats;
+    size_t        pages_per_frame  = PAGES_PER_FRAME;
+    size_t        loads_total      = 0;
+    size_t        evictions_total  = 0;
+    size_t        readbacks_total  = 0;
+    // Feedback frames skipped because every readback was still in flight.
+    size_t        dropped_total    = 0;
+    double        update_ms_max    = 0.0;
+
+private:
+    static constexpr size_t        NO_TEXTURE = static_cast<size_t>(-1);
+    static constexpr std::uint32_t EMPTY      = static_cast<std::uint32_t>(-1);
+
+    struct Texture
+    {
+        VirtualTextureCache::Texture  pages;
+        std::shared_ptr<Material>     material;
+        GLuint                        indirection = 0;
+        // Atlas slot of every page, level 0 first, EMPTY when not resident.
+        std::vector<std::uint32_t>    slots;
+        bool                          dirty = true;
+    };
+
+    struct Slot
+    {
+        std::uint32_t texture = EMPTY;
+        std::uint32_t page    = 0;
+        std::uint64_t used    = 0;
+        bool          pinned  = false;
+    };
+
+    struct Request
+    {
+        std::uint32_t texture;
+        std::uint32_t level;
+        std::uint32_t x;
+        std::uint32_t y;
+    };
+
+    struct Readback
+    {
+        GLuint  buffer = 0;
+        GLsync  fence  = nullptr;
+        GLsizei width  = 0;
+        GLsizei height = 0;
+    };
+
+    auto materials(const std::vector<Material::TextureSource>& sources, const std::vector<size_t>& indices) -> std::vector<std::shared_ptr<Material>>
+    {
+        PROFILE_SCOPE("VirtualTexture::materials");
+
+        if (sources.empty()) return std::vector<std::shared_ptr<Material>>(indices.size());
+        if (sources.size() > NONE) throw std::runtime_error("Too many virtual textures.");
+
+        const auto key = VirtualTextureCache::key(sources);
+
+        cache = VirtualTextureCache::open(cache_path, key);
+
+        if (!cache)
+        {
+            VirtualTextureCache::build(cache_path, sources, key, jobs);
+
+            cache = VirtualTextureCache::open(cache_path, key);
+
+            if (!cache) throw std::runtime_error("Failed to read virtual texture cache " + cache_path + ".");
+        }
+
+        for (const auto& pages : cache->textures)
+        {
+            auto& texture = textures.emplace_back();
+            const auto [width, height] = pages.level_pages(0);
+
+            texture.pages = pages;
+            texture.material = std::make_shared<Material>(0);
+            texture.slots.assign(pages.page(pages.levels - 1, 0, 0) + 1 - pages.first, EMPTY);
+
+            glCreateTextures(GL_TEXTURE_2D, 1, &texture.indirection);
+            glTextureStorage2D(texture.indirection, static_cast<GLsizei>(pages.levels), GL_RGBA16UI, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+
+            texture.material->texture = texture.indirection;
+        }
+
+        // The coarsest page of every texture, so nothing draws without one while the rest streams in.
+        std::vector<Request> coarsest;
+
+        for (std::uint32_t i = 0; i < textures.size() && coarsest.size() < slots.size() / 2; ++i)
+        {
+            coarsest.push_back({ i, textures[i].pages.levels - 1, 0, 0 });
+        }
+
+        load(coarsest, true);
+        refresh();
+
+        std::vector<std::shared_ptr<Material>> materials;
+
+        for (const auto index : indices) materials.push_back(index == NO_TEXTURE ? nullptr : textures[index].material);
+
+        return materials;
+    }
+
+    // Turns every readback that has finished into requests, the newest one wins.
+    auto collect() -> void
+    {
+        while (readbacks[oldest].fence)
+        {
+            auto& readback = readbacks[oldest];
+
+            if (glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED) break;
+
+            glDeleteSync(readback.fence);
+
+            readback.fence = nullptr;
+
+            const auto count = static_cast<size_t>(readback.width) * readback.height;
+            const auto pixels = static_cast<const std::uint32_t*>(glMapNamedBufferRange(readback.buffer, 0, count * 8, GL_MAP_READ_BIT));
+
+            if (pixels)
+            {
+                interpret(pixels, count);
+
+                glUnmapNamedBuffer(readback.buffer);
+            }
+
+            ++stats.readbacks;
+
+            oldest = (oldest + 1) % READBACKS;
+        }
+    }
+
+    // Pixels are the texture index + 1 (0 where nothing was drawn) and the level, row and column of the page.
+    auto interpret(const std::uint32_t* pixels, size_t count) -> void
+    {
+        PROFILE_SCOPE("virtual texture feedback");
+
+        std::vector<std::uint64_t> keys;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (pixels[2 * i] != 0) keys.push_back(static_cast<std::uint64_t>(pixels[2 * i] - 1) << 32 | pixels[2 * i + 1]);
+        }
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        requests.clear();
+        seen = frame;
+
+        for (const auto key : keys)
+        {
+            const auto index = static_cast<std::uint32_t>(key >> 32);
+            const auto packed = static_cast<std::uint32_t>(key);
+
+            if (index >= textures.size()) continue;
+
+            auto& texture = textures[index];
+
+            auto level = packed >> 16;
+            auto x = packed & 0xFF;
+            auto y = (packed >> 8) & 0xFF;
+
+            // The page and every coarser one it falls back to.
+            for (; level < texture.pages.levels; ++level)
+            {
+                const auto [width, height] = texture.pages.level_pages(level);
+
+                if (x >= width || y >= height) break;
+
+                const auto slot = texture.slots[texture.pages.page(level, x, y) - texture.pages.first];
+
+                if (slot == EMPTY) requests.push_back({ index, level, x, y });
+                else slots[slot].used = frame;
+
+                std::tie(x, y) = texture.pages.parent(level, x, y);
+            }
+        }
+
+        std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b)
+        {
+            return std::tie(b.level, a.texture, a.y, a.x) < std::tie(a.level, b.texture, b.y, b.x);
+        });
+        requests.erase(std::unique(requests.begin(), requests.end(), [](const Request& a, const Request& b)
+        {
+            return a.texture == b.texture && a.level == b.level && a.x == b.x && a.y == b.y;
+        }), requests.end());
+    }
+
+    auto stream() -> void
+    {
+        std::vector<Request> batch;
+
+        for (const auto& request : requests)
+        {
+            if (batch.size() >= pages_per_frame) break;
+
+            const auto& texture = textures[request.texture];
+
+            if (texture.slots[texture.pages.page(request.level, request.x, request.y) - texture.pages.first] == EMPTY) batch.push_back(request);
+        }
+
+        if (!batch.empty()) load(batch, false);
+    }
+
+    // Copies the pages out of the mapped cache on the jobs, then uploads them into free or evicted slots.
+    auto load(const std::vector<Request>& batch, bool pinned) -> void
+    {
+        PROFILE_SCOPE("virtual texture pages");
+
+        std::vector<std::uint32_t> targets;
+        std::vector<std::uint32_t> candidates;
+
+        for (std::uint32_t i = 0; i < slots.size(); ++i)
+        {
+            if (slots[i].texture == EMPTY) targets.push_back(i);
+            else if (!slots[i].pinned && slots[i].used != seen) candidates.push_back(i);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [&](std::uint32_t a, std::uint32_t b) { return slots[a].used < slots[b].used; });
+
+        // Only pages the newest feedback did not ask for make room, the rest waits for a later frame.
+        for (size_t i = 0; targets.size() < batch.size() && i < candidates.size(); ++i)
+        {
+            auto& slot = slots[candidates[i]];
+            auto& texture = textures[slot.texture];
+
+            texture.slots[slot.page] = EMPTY;
+            texture.dirty = true;
+
+            slot = {};
+
+            targets.push_back(candidates[i]);
+
+            ++stats.evicted;
+        }
+
+        const auto count = std::min(targets.size(), batch.size());
+
+        std::vector<std::uint8_t> staging(count * VirtualTextureCache::PAGE_BYTES);
+
+        const auto copy = [&](size_t begin, size_t end)
+        {
+            for (auto i = begin; i < end; ++i)
+            {
+                const auto& request = batch[i];
+                const auto page = textures[request.texture].pages.page(request.level, request.x, request.y);
+
+                std::memcpy(staging.data() + i * VirtualTextureCache::PAGE_BYTES, cache->page(page), VirtualTextureCache::PAGE_BYTES);
+            }
+        };
+
+        if (jobs) jobs->parallel_for(0, count, copy, 1);
+        else copy(0, count);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& request = batch[i];
+            const auto target = targets[i];
+            auto& texture = textures[request.texture];
+            const auto page = static_cast<std::uint32_t>(texture.pages.page(request.level, request.x, request.y) - texture.pages.first);
+
+            glTextureSubImage2D(atlas, 0, (target % atlas_side) * PAGE, (target / atlas_side) * PAGE, PAGE, PAGE, GL_RGBA, GL_UNSIGNED_BYTE, staging.data() + i * VirtualTextureCache::PAGE_BYTES);
+
+            // Stamped with the feedback that asked for it, so later batches do not evict it before the next one.
+            slots[target] = { request.texture, page, seen, pinned };
+            texture.slots[page] = target;
+            texture.dirty = true;
+
+            ++stats.loaded;
+        }
+    }
+
+    // Rewrites the indirection of textures whose pages changed, coarsest level first so every texel without a
+    // page of its own takes its parent's.
+    auto refresh() -> void
+    {
+        std::vector<std::array<std::uint16_t, 4>> above;
+        std::vector<std::array<std::uint16_t, 4>> level_texels;
+
+        for (std::uint32_t index = 0; index < textures.size(); ++index)
+        {
+            auto& texture = textures[index];
+
+            if (!texture.dirty) continue;
+
+            texture.dirty = false;
+
+            for (auto level = texture.pages.levels; level-- > 0;)
+            {
+                const auto [width, height] = texture.pages.level_pages(level);
+                const auto above_width = level + 1 < texture.pages.levels ? texture.pages.level_pages(level + 1).first : 0;
+
+                level_texels.resize(static_cast<size_t>(width) * height);
+
+                for (std::uint32_t y = 0; y < height; ++y)
+                {
+                    for (std::uint32_t x = 0; x < width; ++x)
+                    {
+                        const auto slot = texture.slots[texture.pages.page(level, x, y) - texture.pages.first];
+                        auto& texel = level_texels[static_cast<size_t>(y) * width + x];
+
+                        if (slot != EMPTY)
+                        {
+                            texel = { static_cast<std::uint16_t>(slot % atlas_side), static_cast<std::uint16_t>(slot / atlas_side), static_cast<std::uint16_t>(level), static_cast<std::uint16_t>(index) };
+                        }
+                        else if (above_width != 0)
+                        {
+                            const auto [parent_x, parent_y] = texture.pages.parent(level, x, y);
+
+                            texel = above[static_cast<size_t>(parent_y) * above_width + parent_x];
+                        }
+                        else
+                        {
+                            texel = { 0, 0, NONE, static_cast<std::uint16_t>(index) };
+                        }
+                    }
+                }
+
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glTextureSubImage2D(texture.indirection, static_cast<GLint>(level), 0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, level_texels.data());
+
+                std::swap(above, level_texels);
+            }
+        }
+    }
+
+    auto feedback(const DrawList& draw_list, GLsizei width, GLsizei height) -> void
+    {
+        PROFILE_SCOPE("virtual texture feedback pass");
+
+        const auto feedback_width = std::max<GLsizei>(width / FEEDBACK_SCALE, 1);
+        const auto feedback_height = std::max<GLsizei>(height / FEEDBACK_SCALE, 1);
+
+        if (feedback_width != framebuffer_width || feedback_height != framebuffer_height) resize(feedback_width, feedback_height);
+
+        GLint previous = 0;
+        GLint viewport[4];
+
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        const GLuint nothing[4] = {};
+        const GLfloat far = 1.0f;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, feedback_width, feedback_height);
+        glClearNamedFramebufferuiv(framebuffer, GL_COLOR, 0, nothing);
+        glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &far);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glFrontFace(GL_CCW);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glUseProgram(program);
+
+        draw_list.submit(program);
+
+        auto& readback = readbacks[next];
+
+        if (readback.fence)
+        {
+            // Every buffer still in flight: this frame's feedback is dropped rather than waited for.
+            ++dropped_total;
+        }
+        else
+        {
+            readback.width = feedback_width;
+            readback.height = feedback_height;
+
+            glNamedBufferData(readback.buffer, static_cast<GLsizeiptr>(feedback_width) * feedback_height * 8, nullptr, GL_STREAM_READ);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, feedback_width, feedback_height, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            next = (next + 1) % READBACKS;
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    auto resize(GLsizei width, GLsizei height) -> void
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &requests_texture);
+        glDeleteRenderbuffers(1, &depth);
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &requests_texture);
+        glTextureStorage2D(requests_texture, 1, GL_RG32UI, width, height);
+        glCreateRenderbuffers(1, &depth);
+        glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT24, width, height);
+        glCreateFramebuffers(1, &framebuffer);
+        glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, requests_texture, 0);
+        glNamedFramebufferRenderbuffer(framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glNamedFramebufferReadBuffer(framebuffer, GL_COLOR_ATTACHMENT0);
+
+        if (glCheckNamedFramebufferStatus(framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) throw std::runtime_error("Virtual texture feedback framebuffer incomplete.");
+
+        framebuffer_width = width;
+        framebuffer_height = height;
+    }
+
+    // Same vertex interface as the scene shaders, the transformation at location 0.
+    static auto link_feedback_program() -> GLuint
+    {
+        const auto vertex = std::string(R"(#version 450
+layout (location = 0) uniform mat4 transformation;
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inMapping;
+
+layout (location = 0) out vec2 outMapping;
+
+void main() {
+    gl_Position = transformation * vec4(inPosition, 1);
+    outMapping = inMapping;
+}
+)");
+        const auto fragment = "#version 450\n" + glsl() + R"(
+layout (location = 1) uniform float bias;
+
+layout (location = 0) in vec2 inMapping;
+
+layout (location = 0) out uvec2 outRequest;
+
+void main() {
+    int levels = textureQueryLevels(virtualIndirection);
+
+    if (levels == 0) {
+        outRequest = uvec2(0);
+
+        return;
+    }
+
+    int level = virtualLevel(inMapping, bias);
+    ivec2 page = virtualPage(inMapping, level);
+    uint index = texelFetch(virtualIndirection, ivec2(0), levels - 1).w;
+
+    outRequest = uvec2(index + 1u, uint(level) << 16 | uint(page.y) << 8 | uint(page.x));
+}
+)";
+
+        const auto compile = [](GLenum type, const std::string& source)
+        {
+            const auto shader = glCreateShader(type);
+            const auto text = source.c_str();
+
+            glShaderSource(shader, 1, &text, nullptr);
+            glCompileShader(shader);
+
+            GLint status;
+
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+            if (status != GL_TRUE)
+            {
+                GLint size = 0;
+
+                glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &size);
+
+                std::string log;
+
+                log.resize(size);
+                glGetShaderInfoLog(shader, size, &size, log.data());
+
+                throw std::runtime_error(log);
+            }
+
+            return shader;
+        };
+
+        const auto vertex_shader = compile(GL_VERTEX_SHADER, vertex);
+        const auto fragment_shader = compile(GL_FRAGMENT_SHADER, fragment);
+        const auto program = glCreateProgram();
+
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        glLinkProgram(program);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        GLint status;
+
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+        if (status != GL_TRUE)
+        {
+            GLint size = 0;
+
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &size);
+
+            std::string log;
+
+            log.resize(size);
+            glGetProgramInfoLog(program, size, &size, log.data());
+
+            throw std::runtime_error(log);
+        }
+
+        return program;
+    }
+
+    std::string                        cache_path;
+    JobSystem*                         jobs;
+    std::optional<VirtualTextureCache> cache;
+    std::vector<Texture>               textures;
+    std::vector<Slot>                  slots;
+    std::uint32_t                      atlas_side = 0;
+    std::vector<Request>               requests;
+    // update() count, and the one whose readback was interpreted last.
+    std::uint64_t                      frame = 0;
+    std::uint64_t                      seen  = 0;
+    GLuint                             program = 0;
+    GLuint                             framebuffer = 0;
+    GLuint                             requests_texture = 0;
+    GLuint                             depth = 0;
+    GLsizei                            framebuffer_width = 0;
+    GLsizei                            framebuffer_height = 0;
+    std::array<Readback, READBACKS>    readbacks;
+    size_t                             oldest = 0;
+    size_t                             next   = 0;
+};
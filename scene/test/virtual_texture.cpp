@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <png.h>
+#include <virtual_texture.hpp>
+
+// Builds caches of images whose page counts do not halve evenly and walks every page's fallback chain, the way
+// VirtualTexture::collect() and refresh() do. Needs no GL context: only the cache file is touched.
+
+auto check(bool condition, const std::string& message) -> void
+{
+    if (!condition) throw std::runtime_error(message);
+}
+
+// Each texel encodes its position, so pages can be traced back to where they were cut from.
+auto encode(std::uint32_t width, std::uint32_t height) -> std::vector<std::uint8_t>
+{
+    std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+    for (std::uint32_t y = 0; y < height; ++y)
+    {
+        for (std::uint32_t x = 0; x < width; ++x)
+        {
+            const auto texel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+
+            texel[0] = static_cast<std::uint8_t>(x);
+            texel[1] = static_cast<std::uint8_t>(y);
+            texel[2] = static_cast<std::uint8_t>(x >> 8 | (y >> 8) << 4);
+            texel[3] = 255;
+        }
+    }
+
+    png_image image = {};
+
+    image.version = PNG_IMAGE_VERSION;
+    image.width = width;
+    image.height = height;
+    image.format = PNG_FORMAT_RGBA;
+
+    png_alloc_size_t bytes = 0;
+
+    if (png_image_write_to_memory(&image, nullptr, &bytes, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+    std::vector<std::uint8_t> encoded(bytes);
+
+    if (png_image_write_to_memory(&image, encoded.data(), &bytes, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+    encoded.resize(bytes);
+
+    return encoded;
+}
+
+struct Case
+{
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t pages_x;
+    std::uint32_t pages_y;
+    std::uint32_t levels;
+};
+
+auto run(const Case& test, const std::filesystem::path& directory) -> void
+{
+    const auto name = std::to_string(test.width) + "x" + std::to_string(test.height);
+    const auto encoded = encode(test.width, test.height);
+    const auto sources = std::vector<Material::TextureSource>{ { encoded.data(), encoded.size() } };
+    const auto key = VirtualTextureCache::key(sources);
+    const auto path = (directory / (name + ".vtc")).string();
+
+    VirtualTextureCache::build(path, sources, key);
+
+    const auto cache = VirtualTextureCache::open(path, key);
+
+    check(cache.has_value(), name + ": cache did not open.");
+    check(!VirtualTextureCache::open(path, key + 1), name + ": cache opened with a stale key.");
+    check(cache->textures.size() == 1, name + ": wrong texture count.");
+
+    const auto& texture = cache->textures.front();
+
+    check(texture.pages_x == test.pages_x && texture.pages_y == test.pages_y, name + ": wrong page count.");
+    check(texture.levels == test.levels, name + ": wrong level count.");
+
+    const auto pages = (cache->file.size() - VirtualTextureCache::DATA_OFFSET) / VirtualTextureCache::PAGE_BYTES;
+
+    for (std::uint32_t level = 0; level < texture.levels; ++level)
+    {
+        const auto [width, height] = texture.level_pages(level);
+
+        for (std::uint32_t y = 0; y < height; ++y)
+        {
+            for (std::uint32_t x = 0; x < width; ++x)
+            {
+                const auto where = name + " level " + std::to_string(level) + " page " + std::to_string(x) + "," + std::to_string(y);
+
+                check(texture.page(level, x, y) < pages, where + ": page past the end of the file.");
+
+                if (level + 1 == texture.levels) continue;
+
+                // The parent covers the page's first texel, in texture coordinates as the shader computes them.
+                const auto [above_width, above_height] = texture.level_pages(level + 1);
+                const auto [parent_x, parent_y] = texture.parent(level, x, y);
+
+                check(parent_x < above_width && parent_y < above_height, where + ": parent out of range.");
+                check(parent_x == static_cast<std::uint32_t>(static_cast<double>(x) / width * above_width), where + ": wrong parent column.");
+                check(parent_y == static_cast<std::uint32_t>(static_cast<double>(y) / height * above_height), where + ": wrong parent row.");
+            }
+        }
+    }
+
+    // The first texel of level 0 pages comes from the matching spot of the source image.
+    for (std::uint32_t y = 0; y < texture.pages_y; ++y)
+    {
+        for (std::uint32_t x = 0; x < texture.pages_x; ++x)
+        {
+            const auto texel = cache->page(texture.page(0, x, y));
+            const auto source_x = static_cast<std::uint32_t>(static_cast<std::uint64_t>(x) * VirtualTextureCache::PAGE * test.width / (texture.pages_x * VirtualTextureCache::PAGE));
+            const auto source_y = static_cast<std::uint32_t>(static_cast<std::uint64_t>(y) * VirtualTextureCache::PAGE * test.height / (texture.pages_y * VirtualTextureCache::PAGE));
+
+            check(texel[0] == static_cast<std::uint8_t>(source_x) && texel[1] == static_cast<std::uint8_t>(source_y), name + ": page " + std::to_string(x) + "," + std::to_string(y) + " cut from the wrong place.");
+        }
+    }
+}
+
+int main()
+{
+    const auto directory = std::filesystem::temp_directory_path() / "virtual_texture_test";
+
+    try
+    {
+        std::filesystem::create_directories(directory);
+
+        // Page counts that halve unevenly or clamp to one page on one side, next to a power of two.
+        const Case cases[] = {
+            { 1000, 600, 8, 5, 4 },
+            { 600, 1000, 5, 8, 4 },
+            { 300, 300, 3, 3, 2 },
+            { 768, 512, 6, 4, 3 },
+            { 1024, 128, 8, 1, 4 },
+            { 512, 512, 4, 4, 3 },
+        };
+
+        for (const auto& test : cases) run(test, directory);
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << std::endl;
+        std::filesystem::remove_all(directory);
+
+        return EXIT_FAILURE;
+    }
+
+    std::filesystem::remove_all(directory);
+
+    std::cout << "virtual texture cache: ok" << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "synthetic_scene.hpp"
+
+int main(int argc, char** argv) {
+    try {
+        SyntheticScene::Settings settings;
+        std::string output;
+        std::string textures;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const auto argument = std::string(argv[i]);
+            const auto value = [&]() -> std::string
+            {
+                if (i + 1 >= argc) throw std::runtime_error("Missing value for " + argument + ".");
+
+                return argv[++i];
+            };
+
+            if (argument == "--nodes") settings.nodes = std::stoull(value());
+            else if (argument == "--depth") settings.depth = std::stoull(value());
+            else if (argument == "--meshes-per-node") settings.meshes_per_node = std::stoull(value());
+            else if (argument == "--triangles") settings.triangles_per_mesh = std::stoull(value());
+            else if (argument == "--textures") settings.textures = std::stoull(value());
+            else if (argument == "--texture-size") settings.texture_size = std::stoull(value());
+            else if (argument == "--reuse") settings.instance_reuse = std::stof(value());
+            else if (argument == "--seed") settings.seed = std::stoull(value());
+            else if (argument == "--unwelded") settings.unwelded = true;
+            else if (argument == "--output") output = value();
+            else if (argument == "--export-textures") textures = value();
+            else throw std::runtime_error("Unknown argument " + argument + ".");
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        const auto scene = SyntheticScene::generate(settings);
+        const auto end = std::chrono::steady_clock::now();
+
+        size_t triangles = 0;
+
+        for (size_t i = 0; i < scene->mNumMeshes; ++i) triangles += scene->mMeshes[i]->mNumFaces;
+
+        std::cout << "nodes: " << settings.nodes << std::endl;
+        std::cout << "meshes: " << scene->mNumMeshes << " unique, " << settings.nodes * settings.meshes_per_node << " instances" << std::endl;
+        std::cout << "triangles: " << triangles << " unique" << std::endl;
+        std::cout << "textures: " << scene->mNumTextures << std::endl;
+        std::cout << "generated in " << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << std::endl;
+
+        if (!output.empty()) SyntheticScene::export_gltf(scene.get(), output);
+        if (!textures.empty()) SyntheticScene::export_textures(scene.get(), textures);
+    }
+    catch (std::runtime_error error) {
+        std::cerr << error.what() << std::endl;
+
+        throw;
+    }
+
+    std::cout << "done" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include "synthetic_scene.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <png.h>
+#include <assimp/Exporter.hpp>
+#include <assimp/material.h>
+
+namespace
+{
+    // splitmix64, so a seed gives the same scene with every standard library.
+    struct Random
+    {
+        auto next() -> std::uint64_t
+        {
+            auto z = (state += 0x9e3779b97f4a7c15ull);
+
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+            return z ^ (z >> 31);
+        }
+        auto uniform(float from, float to) -> float
+        {
+            return from + (to - from) * static_cast<float>(next() >> 40) / static_cast<float>(1ull << 24);
+        }
+        auto index(size_t count) -> size_t
+        {
+            return static_cast<size_t>(next() % count);
+        }
+
+        std::uint64_t state;
+    };
+
+    // Tessellated, slightly bumped unit quad facing +Y with exactly `triangles` faces.
+    auto grid_mesh(size_t triangles, unsigned material, bool unwelded, Random& random) -> aiMesh*
+    {
+        const auto quads = (triangles + 1) / 2;
+        const auto columns = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(quads)))));
+        const auto rows = std::max<size_t>(1, (quads + columns - 1) / columns);
+        const auto vertices_count = (columns + 1) * (rows + 1);
+        const auto bump = random.uniform(0.0f, 0.2f);
+
+        auto mesh = new aiMesh();
+
+        mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+        mesh->mMaterialIndex = material;
+        mesh->mNumVertices = static_cast<unsigned>(vertices_count);
+        mesh->mVertices = new aiVector3D[vertices_count];
+        mesh->mTextureCoords[0] = new aiVector3D[vertices_count];
+        mesh->mNumUVComponents[0] = 2;
+
+        for (size_t row = 0; row <= rows; ++row)
+        {
+            for (size_t column = 0; column <= columns; ++column)
+            {
+                const auto u = static_cast<float>(column) / static_cast<float>(columns);
+                const auto v = static_cast<float>(row) / static_cast<float>(rows);
+                const auto i = row * (columns + 1) + column;
+
+                mesh->mVertices[i] = aiVector3D(u - 0.5f, bump * std::sin(u * 6.2831853f) * std::cos(v * 6.2831853f), v - 0.5f);
+                mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+            }
+        }
+
+        mesh->mNumFaces = static_cast<unsigned>(triangles);
+        mesh->mFaces = new aiFace[triangles];
+
+        for (size_t t = 0; t < triangles; ++t)
+        {
+            const auto quad = t / 2;
+            const auto a = static_cast<unsigned>((quad / columns) * (columns + 1) + quad % columns);
+            const auto b = a + 1;
+            const auto d = a + static_cast<unsigned>(columns) + 1;
+            const auto e = d + 1;
+
+            mesh->mFaces[t].mNumIndices = 3;
+            mesh->mFaces[t].mIndices = t % 2 == 0 ? new unsigned[3] { a, d, b } : new unsigned[3] { b, d, e };
+        }
+
+        if (unwelded)
+        {
+            // Every face gets its own copies of its three vertices, as exporters that write triangle soups do.
+            const auto positions = mesh->mVertices;
+            const auto mappings = mesh->mTextureCoords[0];
+
+            mesh->mNumVertices = static_cast<unsigned>(triangles * 3);
+            mesh->mVertices = new aiVector3D[triangles * 3];
+            mesh->mTextureCoords[0] = new aiVector3D[triangles * 3];
+
+            for (size_t t = 0; t < triangles; ++t)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    const auto vertex = static_cast<unsigned>(t * 3 + k);
+
+                    mesh->mVertices[vertex] = positions[mesh->mFaces[t].mIndices[k]];
+                    mesh->mTextureCoords[0][vertex] = mappings[mesh->mFaces[t].mIndices[k]];
+                    mesh->mFaces[t].mIndices[k] = vertex;
+                }
+            }
+
+            delete[] positions;
+            delete[] mappings;
+        }
+
+        return mesh;
+    }
+
+    auto checker_texture(size_t index, size_t size) -> aiTexture*
+    {
+        const auto color = std::array<std::uint8_t, 3> {
+            static_cast<std::uint8_t>(64 + (index * 97) % 192),
+            static_cast<std::uint8_t>(64 + (index * 57) % 192),
+            static_cast<std::uint8_t>(64 + (index * 31) % 192),
+        };
+
+        std::vector<std::uint8_t> pixels(size * size * 4);
+
+        for (size_t y = 0; y < size; ++y)
+        {
+            for (size_t x = 0; x < size; ++x)
+            {
+                const auto dark = ((x * 8 / size) + (y * 8 / size)) % 2 == 0;
+                const auto pixel = &pixels[(y * size + x) * 4];
+
+                pixel[0] = dark ? color[0] / 2 : color[0];
+                pixel[1] = dark ? color[1] / 2 : color[1];
+                pixel[2] = dark ? color[2] / 2 : color[2];
+                pixel[3] = 255;
+            }
+        }
+
+        png_image image = {};
+
+        image.version = PNG_IMAGE_VERSION;
+        image.width = static_cast<png_uint_32>(size);
+        image.height = static_cast<png_uint_32>(size);
+        image.format = PNG_FORMAT_RGBA;
+
+        png_alloc_size_t bytes = 0;
+
+        if (png_image_write_to_memory(&image, nullptr, &bytes, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+        std::vector<std::uint8_t> encoded(bytes);
+
+        if (png_image_write_to_memory(&image, encoded.data(), &bytes, 0, pixels.data(), 0, nullptr) == 0) throw std::runtime_error("Failed to encode image.");
+
+        auto texture = new aiTexture();
+
+        texture->mWidth = static_cast<unsigned>(bytes);
+        texture->mHeight = 0;
+        std::strcpy(texture->achFormatHint, "png");
+        texture->pcData = new aiTexel[(bytes + sizeof(aiTexel) - 1) / sizeof(aiTexel)];
+        std::memcpy(texture->pcData, encoded.data(), bytes);
+        texture->mFilename.Set("synthetic_" + std::to_string(index));
+
+        return texture;
+    }
+
+    auto local_transformation(Random& random) -> aiMatrix4x4
+    {
+        const auto angle = random.uniform(0.0f, 6.2831853f);
+        const auto scale = random.uniform(0.6f, 0.9f);
+        const auto c = std::cos(angle) * scale;
+        const auto s = std::sin(angle) * scale;
+
+        return aiMatrix4x4(
+            +c,    0.0f,  +s,    random.uniform(-1.0f, +1.0f),
+            0.0f,  scale, 0.0f,  random.uniform(-0.5f, +0.5f),
+            -s,    0.0f,  +c,    random.uniform(-1.0f, +1.0f),
+            0.0f,  0.0f,  0.0f,  1.0f
+        );
+    }
+}
+
+auto SyntheticScene::generate(const Settings& settings) -> std::unique_ptr<aiScene>
+{
+    if (settings.nodes == 0) throw std::runtime_error("Synthetic scene needs at least one node.");
+    if (settings.depth == 0) throw std::runtime_error("Synthetic scene depth must be positive.");
+    if (settings.depth == 1 && settings.nodes > 1) throw std::runtime_error("Synthetic scenes with more than one node need a depth of at least 2, the root is the only node of depth 1.");
+    if (settings.triangles_per_mesh == 0) throw std::runtime_error("Synthetic meshes need at least one triangle.");
+    if (settings.textures > 0 && settings.texture_size == 0) throw std::runtime_error("Synthetic texture size must be positive.");
+    if (!(settings.instance_reuse >= 0.0f && settings.instance_reuse < 1.0f)) throw std::runtime_error("Instance reuse must be in [0, 1).");
+
+    auto random = Random { settings.seed };
+    auto scene = std::make_unique<aiScene>();
+
+    const auto materials_count = std::max<size_t>(1, settings.textures);
+
+    scene->mNumMaterials = static_cast<unsigned>(materials_count);
+    scene->mMaterials = new aiMaterial*[materials_count];
+
+    for (size_t i = 0; i < materials_count; ++i)
+    {
+        auto material = new aiMaterial();
+        auto name = aiString("synthetic_" + std::to_string(i));
+
+        material->AddProperty(&name, AI_MATKEY_NAME);
+
+        if (i < settings.textures)
+        {
+            auto path = aiString("*" + std::to_string(i));
+
+            material->AddProperty(&path, AI_MATKEY_TEXTURE_DIFFUSE(0));
+        }
+
+        scene->mMaterials[i] = material;
+    }
+
+    if (settings.textures > 0)
+    {
+        scene->mNumTextures = static_cast<unsigned>(settings.textures);
+        scene->mTextures = new aiTexture*[settings.textures];
+
+        for (size_t i = 0; i < settings.textures; ++i)
+        {
+            scene->mTextures[i] = checker_texture(i, settings.texture_size);
+        }
+    }
+
+    const auto references = settings.nodes * settings.meshes_per_node;
+    const auto unique_meshes = references == 0 ? 0 : std::max<size_t>(1, static_cast<size_t>(std::llround(static_cast<double>(references) * (1.0 - settings.instance_reuse))));
+
+    if (unique_meshes > 0)
+    {
+        scene->mNumMeshes = static_cast<unsigned>(unique_meshes);
+        scene->mMeshes = new aiMesh*[unique_meshes];
+
+        for (size_t i = 0; i < unique_meshes; ++i)
+        {
+            scene->mMeshes[i] = grid_mesh(settings.triangles_per_mesh, static_cast<unsigned>(i % materials_count), settings.unwelded, random);
+        }
+    }
+
+    // A spine of `depth` nodes fixes the hierarchy depth, the remaining nodes hang off random non-leaf levels.
+    std::vector<aiNode*> nodes(settings.nodes);
+    std::vector<size_t> levels(settings.nodes);
+    std::vector<std::vector<aiNode*>> children(settings.nodes);
+    std::vector<size_t> parents;
+
+    for (size_t i = 0; i < settings.nodes; ++i)
+    {
+        nodes[i] = new aiNode("node_" + std::to_string(i));
+
+        if (i > 0)
+        {
+            const auto parent = i < settings.depth ? i - 1 : parents[random.index(parents.size())];
+
+            nodes[i]->mTransformation = local_transformation(random);
+            levels[i] = levels[parent] + 1;
+            children[parent].push_back(nodes[i]);
+        }
+
+        if (levels[i] + 1 < settings.depth) parents.push_back(i);
+
+        if (settings.meshes_per_node > 0)
+        {
+            nodes[i]->mNumMeshes = static_cast<unsigned>(settings.meshes_per_node);
+            nodes[i]->mMeshes = new unsigned[settings.meshes_per_node];
+
+            for (size_t j = 0; j < settings.meshes_per_node; ++j)
+            {
+                nodes[i]->mMeshes[j] = static_cast<unsigned>((i * settings.meshes_per_node + j) % unique_meshes);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < settings.nodes; ++i)
+    {
+        nodes[i]->addChildren(static_cast<unsigned>(children[i].size()), children[i].data());
+    }
+
+    scene->mRootNode = nodes.front();
+
+    return scene;
+}
+
+auto SyntheticScene::export_gltf(const aiScene* scene, const std::string& path) -> void
+{
+    const auto format = std::filesystem::path(path).extension() == ".glb" ? "glb2" : "gltf2";
+
+    Assimp::Exporter exporter;
+
+    if (exporter.Export(scene, format, path.c_str()) != aiReturn_SUCCESS) throw std::runtime_error(exporter.GetErrorString());
+}
+
+auto SyntheticScene::export_textures(const aiScene* scene, const std::string& directory) -> void
+{
+    std::filesystem::create_directories(directory);
+
+    for (size_t i = 0; i < scene->mNumTextures; ++i)
+    {
+        const auto texture = scene->mTextures[i];
+
+        if (texture->mHeight != 0) throw std::runtime_error("Only compressed textures can be exported.");
+
+        const auto path = std::filesystem::path(directory) / (std::string(texture->mFilename.C_Str()) + ".png");
+
+        std::ofstream stream(path, std::ios::binary);
+
+        if (!stream) throw std::runtime_error("Failed to open " + path.string() + ".");
+
+        stream.write(reinterpret_cast<const char*>(texture->pcData), texture->mWidth);
+    }
+}
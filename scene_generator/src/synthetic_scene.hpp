@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <assimp/scene.h>
+
+// Procedural scenes for scaling tests of Node::from, Mesh::from, Material::from and Node::render.
+struct SyntheticScene
+{
+    struct Settings
+    {
+        size_t        nodes              = 1000;
+        size_t        depth              = 8;
+        size_t        meshes_per_node    = 1;
+        size_t        triangles_per_mesh = 128;
+        size_t        textures           = 4;
+        size_t        texture_size       = 256;
+        float         instance_reuse     = 0.0f; // Share of mesh references that point at an already created mesh.
+        bool          unwelded           = false; // Triangle soup, every face with its own three vertices.
+        std::uint64_t seed               = 1;
+    };
+
+    // Textures are embedded as compressed PNGs named "synthetic_<i>".
+    static auto generate(const Settings& settings) -> std::unique_ptr<aiScene>;
+
+    // glTF 2.0, binary when the path ends with .glb.
+    static auto export_gltf(const aiScene* scene, const std::string& path) -> void;
+
+    // Writes the embedded textures as <directory>/synthetic_<i>.png, to look at them, loading does not need them.
+    static auto export_textures(const aiScene* scene, const std::string& directory) -> void;
+};
@@ -0,0 +1,91 @@
+#include "staging_ring.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr GLbitfield MAPPING = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+StagingRing::StagingRing(size_t capacity):
+    capacity(capacity)
+{
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, capacity, nullptr, MAPPING);
+
+    mapped = static_cast<std::uint8_t*>(glMapNamedBufferRange(buffer, 0, capacity, MAPPING));
+
+    if (!mapped) throw std::runtime_error("Failed to map the staging buffer.");
+}
+
+StagingRing::~StagingRing()
+{
+    for (const auto& region : in_flight) glDeleteSync(region.fence);
+
+    // Pending uploads keep the storage alive until they are done.
+    glUnmapNamedBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+}
+
+auto StagingRing::allocate(size_t size) -> Allocation
+{
+    if (size > capacity) throw std::runtime_error("Staging allocation of " + std::to_string(size) + " bytes exceeds the ring.");
+
+    auto offset = (head + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    if (offset + size > capacity) offset = 0;
+
+    // Regions are retired in allocation order, so everything up to the last one overlapping the new range goes.
+    while (!in_flight.empty())
+    {
+        const auto& region = in_flight.front();
+        const auto overlaps = region.begin < offset + size && offset < region.end;
+        const auto wrapped = offset == 0 && region.begin >= head;
+
+        if (!overlaps && !wrapped) break;
+
+        wait(region);
+        in_flight.pop_front();
+    }
+
+    head = offset + size;
+
+    return { offset, size, mapped + offset };
+}
+
+auto StagingRing::commit(const Allocation& allocation) -> void
+{
+    in_flight.push_back({ allocation.offset, allocation.offset + allocation.size, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+}
+
+auto StagingRing::upload_texture(GLuint texture, const Allocation& allocation, GLsizei width, GLsizei height, GLenum format, GLenum type) -> void
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTextureSubImage2D(texture, 0, 0, 0, width, height, format, type, reinterpret_cast<const void*>(allocation.offset));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    commit(allocation);
+}
+
+auto StagingRing::wait(const Region& region) -> void
+{
+    const auto started = std::chrono::steady_clock::now();
+
+    auto flags = GLbitfield(GL_SYNC_FLUSH_COMMANDS_BIT);
+    auto status = GLenum(GL_TIMEOUT_EXPIRED);
+
+    while (status == GL_TIMEOUT_EXPIRED)
+    {
+        status = glClientWaitSync(region.fence, flags, 100'000'000);
+        flags = 0;
+    }
+
+    glDeleteSync(region.fence);
+
+    if (status == GL_WAIT_FAILED) throw std::runtime_error("Waiting for a staging fence failed.");
+
+    wait_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include <GL/glew.h>
+
+// Persistently mapped GL_PIXEL_UNPACK_BUFFER used as a ring of upload staging memory.
+// Decoders write straight into allocate()d memory, upload_texture() copies it into a texture from the buffer
+// and fences the region, later allocations wait for that fence before reusing it.
+//
+//     auto ring = StagingRing();
+//     auto staging = ring.allocate(bytes);
+//     decode(staging.data);
+//     ring.upload_texture(texture, staging, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+//
+// Commit (upload_texture() or commit()) every allocation before the next one. An allocation may be committed in
+// slices, in order, such as one per texture decoded into it by a different thread.
+struct StagingRing
+{
+    static constexpr size_t DEFAULT_CAPACITY = 32 * 1024 * 1024;
+    // Allocations start cache line aligned, which also satisfies any GL_UNPACK_ALIGNMENT.
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct Allocation
+    {
+        size_t        offset;
+        size_t        size;
+        std::uint8_t* data;
+    };
+
+    explicit StagingRing(size_t capacity = DEFAULT_CAPACITY);
+    StagingRing(const StagingRing&) = delete;
+    ~StagingRing();
+
+    auto operator=(const StagingRing&) -> StagingRing& = delete;
+
+    // Throws when `size` exceeds the capacity, callers fall back to a client memory upload.
+    auto allocate(size_t size) -> Allocation;
+    // Fences the allocation once the commands reading it were issued.
+    auto commit(const Allocation& allocation) -> void;
+    auto upload_texture(GLuint texture, const Allocation& allocation, GLsizei width, GLsizei height, GLenum format, GLenum type) -> void;
+
+    GLuint        buffer = 0;
+    std::uint8_t* mapped = nullptr;
+    size_t        capacity;
+    size_t        head = 0;
+    double        wait_ms = 0.0;
+
+private:
+    struct Region
+    {
+        size_t begin;
+        size_t end;
+        GLsync fence;
+    };
+
+    auto wait(const Region& region) -> void;
+
+    std::deque<Region> in_flight;
+};
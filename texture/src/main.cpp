@@ -5,6 +5,9 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include <capture.hpp>
+#include <frame_pacer.hpp>
+#include <pixel_convert.hpp>
 
 struct Vertex {
     glm::vec2 position;
@@ -42,20 +45,9 @@ const GLint FRAGMENT_SHADER_LENGTHS[] = { static_cast<GLint>(FRAGMENT_SHADER_SOU
 
 int main() {
     try {
-        if (!glfwInit()) throw std::runtime_error("GLFW initialization failed.");
+        auto capture = Capture();
 
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-        const auto window = glfwCreateWindow(800, 600, "Texture", nullptr, nullptr);
-
-        if (!window) throw std::runtime_error("Window creation failed.");
-
-        glfwMakeContextCurrent(window);
-
-        if (glewInit() != GLEW_OK) throw std::runtime_error("GLEW initialization failed.");
+        auto surface = Surface(capture, 800, 600, "Texture");
 
         const auto vertices = std::vector<Vertex>{
             { { -0.5f, -0.5f }, { 0.0f, 0.0f } },
@@ -164,7 +156,7 @@ int main() {
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
 
-        std::vector<std::uint8_t> pixels = {
+        std::vector<std::uint8_t> rgb = {
             255, 0, 0,
             0, 255, 0,
             0, 0, 255,
@@ -178,12 +170,16 @@ int main() {
             255, 255, 255,
         };
 
+        // Drivers store RGB8 as RGBA8 anyway, expanding on the CPU keeps the upload on the fast path.
+        std::vector<std::uint8_t> rgba(3 * 3 * 4);
+
+        pixels::best().rgb_to_rgba(rgb.data(), rgba.data(), 3 * 3);
+
         GLuint texture;
 
         glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-        glTextureStorage2D(texture, 1, GL_RGB8, 3, 3);
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-        glTextureSubImage2D(texture, 0, 0, 0, 3, 3, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        glTextureStorage2D(texture, 1, GL_RGBA8, 3, 3);
+        glTextureSubImage2D(texture, 0, 0, 0, 3, 3, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
 
         GLuint sampler;
 
@@ -193,13 +189,17 @@ int main() {
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        while (!glfwWindowShouldClose(window))
+        auto pacer = FramePacer();
+
+        while (surface.open())
         {
-            glfwPollEvents();
+            surface.poll();
+
+            pacer.begin();
 
             int width, height;
 
-            glfwGetFramebufferSize(window, &width, &height);
+            surface.size(width, height);
 
             glViewport(0, 0, width, height);
             glClearColor(1.0f, 0.5f, 0.0f, 1.0f);
@@ -229,9 +229,10 @@ int main() {
             glBindSampler(0, sampler);
 
             glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-            glFlush();
 
-            glfwSwapBuffers(window);
+            surface.present();
+
+            pacer.end();
         }
 
         glDeleteSamplers(1, &sampler);
@@ -254,9 +255,6 @@ int main() {
 
             throw std::runtime_error("Unknown OpenGL error: " + std::to_string(error) + ".");
         }
-
-        glfwDestroyWindow(window);
-        glfwTerminate();
     }
     catch (std::runtime_error error) {
         std::cerr << error.what() << std::endl;